@@ -1,248 +1,1549 @@
 #include <assert.h>
+#include <pthread.h>
+#include <stdlib.h>
 #include <string.h>
 #include <inttypes.h>
 
-#include <file_manager/file_manager.h>
 #include "instructions_compiling.h"
+#include "std_library.h"
+#include "reachability.h"
 
 #define CUR_FUNC compiler->curFunction
+#define TREE     (&compiler->tree)
 
 const size_t ELF_INITIAL_SIZE           = 1024;
+const size_t ELF_BYTES_PER_NODE         = 8; /* a bit more than a node's code takes on average */
 const size_t HORIZONTAL_LINE_LENGTH     = 50;
 const char*  INDENTATION                = "                ";
-const size_t MAX_STD_FUNC_LENGTH        = 256;
 const size_t MAX_INDENTED_STRING_LENGTH = 512;
+const size_t MAX_SYMBOL_NAME_LENGTH     = 512;
 const size_t IO_BUFFER_SIZE             = 512;
 
+/* Named labels are looked up by the pointers of their names, so every label 
+ * name has to be used through one of these constants. */
+const char*  LABEL_IO_BUFFER            = "IO_BUFFER";
+const char*  LABEL_STRING               = "STR";
+const char*  LABEL_RETURN               = ".RETURN";
+const char*  LABEL_ELSE                 = ".ELSE_";
+const char*  LABEL_END_IF_ELSE          = ".END_IF_ELSE";
+const char*  LABEL_WHILE                = ".WHILE_";
+const char*  LABEL_END_WHILE            = ".END_WHILE_";
+const char*  LABEL_CMP_TRUE             = ".CMP_TRUE_";
+const char*  LABEL_CMP_END              = ".CMP_END_";
+
+/* Cached functions' label names are turned back into the constants by these. */
+const char*  LABEL_CONSTANTS[]          = {LABEL_IO_BUFFER, LABEL_STRING, LABEL_RETURN, LABEL_ELSE, 
+                                           LABEL_END_IF_ELSE, LABEL_WHILE, LABEL_END_WHILE, 
+                                           LABEL_CMP_TRUE, LABEL_CMP_END};
+const size_t LABEL_CONSTANTS_COUNT      = sizeof(LABEL_CONSTANTS) / sizeof(LABEL_CONSTANTS[0]);
+
+/* Most numbers which a node adds to its function's key at once (see buildFunctionKey()). */
+const size_t NODE_KEY_MAX_FIELDS        = 8;
+
 //===================================Compiler===================================
 int32_t       nextLabelNumber     (Compiler* compiler, LabelPurposeType labelType);
-Label         getExistingLabel    (Compiler* compiler, Label label);
+Label         namedLabel          (Compiler* compiler, const char* name);
+Label         localLabel          (Compiler* compiler, const char* name, int32_t number);
+Label         stringLabel         (Compiler* compiler, int stringId);
 void          writeLabel          (Compiler* compiler, Label label);
+void          writeSourceLine     (Compiler* compiler, uint32_t line);
 void          compileError        (Compiler* compiler, CompilerError error); 
-CompilerError makeCompilationPass (Compiler* compiler);
+void          compileProgram      (Compiler* compiler);
+void          compileFunctions    (Compiler* compiler, NodeIndex first, NodeIndex end, Function* firstFunction);
+void          compileParallel     (Compiler* compiler, NodeIndex first, Function* firstFunction);
+void          compileCached       (Compiler* compiler, NodeIndex first, Function* firstFunction);
+void          allocateNamedLabels (Compiler* compiler, NodeIndex first, Function* firstFunction);
+void          resolveFixups       (Compiler* compiler);
+void          relaxBranches       (Compiler* compiler);
+void          writeSymbolTable    (Compiler* compiler);
+uint64_t      relaxedOffset       (const LabelManager* labelManager, const uint64_t* savedBefore, uint64_t offset);
 //===================================Compiler===================================
 
-//==================================Write data==================================
-void writeEntryPoint   (Compiler* compiler);
-void writeStdFunctions (Compiler* compiler);
-void writeStdFunction  (Compiler* compiler, StdFunctionInfo info);
-void writeBSS          (Compiler* compiler);
-void writeData         (Compiler* compiler);
-void writeStringsData  (Compiler* compiler);
-//==================================Write data==================================
+//================================Function cache================================
+struct CachedFunction;
+struct CachedLabel;
+
+uint32_t    cacheOptions        (const Compiler* compiler);
+void        buildFunctionKey    (Compiler* compiler, NodeIndex declaration, const Function* function, 
+                                 CacheBuffer* key);
+void        compileMissed       (const Compiler* compiler, CachedFunction* cached, const char** labelNames);
+void        serializePart       (const Compiler* part, const char** labelNames, uint32_t functionLine, 
+                                 const char* listing, size_t listingSize, CacheBuffer* data);
+CachedLabel cachedLabel         (const Compiler* part, LabelId label, const char** labelNames, CacheBuffer* names);
+void        mergeCached         (Compiler* compiler, const CachedFunction* cached);
+LabelId     resolveCachedLabel  (Compiler* compiler, CachedLabel label, LabelId firstOwnLabel, const char* names);
+const char* cachedLabelName     (const char* name);
+uint32_t    relativeNode        (NodeIndex node, NodeIndex declaration);
+//================================Function cache================================
+
+//==================================Write data==================================
+void writeEntryPoint      (Compiler* compiler);
+void writeStdFunctions    (Compiler* compiler);
+void writeStdFunction     (Compiler* compiler, StdFunctionInfo info);
+void findUsedStdFunctions (Compiler* compiler, bool* isUsed);
+void writeBSS             (Compiler* compiler);
+void writeData            (Compiler* compiler);
+void writeStringsData     (Compiler* compiler);
+//==================================Write data==================================
+
+//==============================Write NASM comments==============================
+void writeHorizontalLine (Compiler* compiler);
+void writeFunctionHeader (Compiler* compiler);
+//==============================Write NASM comments==============================
+
+//==================================Compilation==================================
+void compileFunction         (Compiler* compiler, NodeIndex node);
+void compileBlock            (Compiler* compiler, NodeIndex node);
+void compileStatement        (Compiler* compiler, NodeIndex node);
+
+void compileCondition        (Compiler* compiler, NodeIndex node);
+void compileLoop             (Compiler* compiler, NodeIndex node);
+void compileExitCondition    (Compiler* compiler, NodeIndex node, Label exitLabel);
+void compileAssignment       (Compiler* compiler, NodeIndex node);
+void compileAssignmentVar    (Compiler* compiler, NodeIndex node);
+void compileAssignmentArray  (Compiler* compiler, NodeIndex node);
+void compileArrayDeclaration (Compiler* compiler, NodeIndex node);
+void compileReturn           (Compiler* compiler, NodeIndex node);
+
+void compileExpression       (Compiler* compiler, NodeIndex node);
+bool isSimpleOperand         (Compiler* compiler, NodeIndex node);
+void compileSimpleOperand    (Compiler* compiler, NodeIndex node, Reg64 result);
+bool tryTwoOperandSimple     (Compiler* compiler, NodeIndex node);
+void compileTwoOperand       (Compiler* compiler, NodeIndex node);
+void compileMath             (Compiler* compiler, NodeIndex node);
+void compileCompare          (Compiler* compiler, NodeIndex node);
+void compileMemAccess        (Compiler* compiler, NodeIndex node);
+void compileString           (Compiler* compiler, NodeIndex node, Reg64 result);
+void compileNumber           (Compiler* compiler, NodeIndex node, Reg64 result);
+void compileVar              (Compiler* compiler, NodeIndex node, Reg64 result);
+
+void compileParamList        (Compiler* compiler, NodeIndex node, const Function* function);
+void compileCall             (Compiler* compiler, NodeIndex node);
+//==================================Compilation=================================
+
+
+//===================================Compiler===================================
+void construct(Compiler* compiler, Node* tree, SymbolTable* table)
+{
+    assert(compiler);
+    assert(tree);
+    assert(table);
+
+    compiler->table      = table; 
+    compiler->errorsFile = stdout;
+    construct(&compiler->tree, tree);
+    markReachableSymbols(table, &compiler->tree);
+    construct(&compiler->labelManager);
+}
+
+void destroy(Compiler* compiler)
+{
+    assert(compiler);
+
+    compiler->table = nullptr;
+
+    /* Parts share the program's tree. */
+    if (compiler->program == nullptr) { destroy(&compiler->tree); }
+
+    destroy(&compiler->labelManager);
+    destroy(&compiler->builder);
+
+    if (compiler->isNasmNeeded)      { destroy(&compiler->listing);   }
+    if (compiler->isDebugInfoNeeded) { destroy(&compiler->debugInfo); }
+    if (compiler->isCacheUsed)       { destroy(&compiler->cache);     }
+}
+
+//------------------------------------------------------------------------------
+//! Makes the compiler of a part of the program's functions, which emits them 
+//! into its own builder, with its own labels (see constructPart() of 
+//! LabelManager), listing and debug info, and is merged into the program by 
+//! mergePart(). The part shares the tree and the symbol table with the 
+//! program, which it only reads, so parts can be compiled in parallel.
+//!
+//! The part's listing, if it's needed, is added by addNasmFile().
+//------------------------------------------------------------------------------
+void constructPart(Compiler* compiler, const Compiler* program, size_t initialSize)
+{
+    assert(compiler);
+    ASSERT_COMPILER(program);
+    assert(program->program == nullptr);
+
+    *compiler = {};
+
+    compiler->program          = program;
+    compiler->table            = program->table;
+    compiler->tree             = program->tree;
+    compiler->firstStringLabel = program->firstStringLabel;
+    compiler->isSizeOptimized  = program->isSizeOptimized;
+    compiler->errorsFile       = program->errorsFile;
+
+    constructPart(&compiler->labelManager, &program->labelManager);
+    constructPart(&compiler->builder, initialSize);
+
+    if (program->isDebugInfoNeeded)
+    {
+        addDebugInfo(compiler, program->debugInfo.sourceName);
+    }
+}
+
+//------------------------------------------------------------------------------
+//! Places the part's code at the current offset and merges its labels, fixups
+//! and debug info into the program's ones. The part's listing isn't merged.
+//------------------------------------------------------------------------------
+void mergePart(Compiler* compiler, const Compiler* part)
+{
+    ASSERT_COMPILER(compiler);
+    ASSERT_COMPILER(part);
+    assert(part->program == compiler);
+
+    uint64_t offset = compiler->builder.offset;
+    writeBytes(&compiler->builder, part->builder.elfFile.bytecode, part->builder.offset);
+
+    LabelId shift = mergePart(&compiler->labelManager, &part->labelManager, offset);
+
+    if (compiler->isDebugInfoNeeded)
+    {
+        mergePart(&compiler->debugInfo, &part->debugInfo, offset, &part->labelManager, shift);
+    }
+
+    if (part->status != COMPILER_NO_ERROR) { compiler->status = part->status; }
+}
+
+void addElfFile(Compiler* compiler, FILE* elfFile)
+{
+    assert(compiler);
+    assert(elfFile);
+
+    /* Sized up front, so that the bytecode is rarely reallocated. */
+    construct(&compiler->builder, elfFile, 
+              ELF_INITIAL_SIZE + ELF_BYTES_PER_NODE * compiler->tree.count);
+}
+
+void addNasmFile(Compiler* compiler, FILE* nasmFile)
+{
+    assert(compiler);
+    assert(nasmFile);
+
+    compiler->isNasmNeeded = true;
+    construct(&compiler->listing, nasmFile);
+}
+
+//------------------------------------------------------------------------------
+//! Makes compile() choose the shortest encodings of jumps, immediate constants
+//! and displacements.
+//------------------------------------------------------------------------------
+void optimizeSize(Compiler* compiler)
+{
+    assert(compiler);
+
+    compiler->isSizeOptimized = true;
+}
+
+//------------------------------------------------------------------------------
+//! Makes compile() write the DWARF sections (see DebugInfo). The parser has to
+//! record the lines for them to be meaningful (see recordLines()).
+//------------------------------------------------------------------------------
+void addDebugInfo(Compiler* compiler, const char* sourceName)
+{
+    assert(compiler);
+    assert(sourceName);
+
+    compiler->isDebugInfoNeeded = true;
+    construct(&compiler->debugInfo, sourceName);
+}
+
+//------------------------------------------------------------------------------
+//! Makes compile() compile the functions with up to threadsCount threads (see
+//! compileParallel()).
+//------------------------------------------------------------------------------
+void useThreads(Compiler* compiler, size_t threadsCount)
+{
+    assert(compiler);
+    assert(threadsCount > 0);
+
+    compiler->threadsCount = threadsCount;
+}
+
+//------------------------------------------------------------------------------
+//! Makes compile() take the program's functions compiled before from the cache
+//! in the directory and store the other ones there (see compileCached()).
+//------------------------------------------------------------------------------
+void useCache(Compiler* compiler, const char* directory, const char* programName)
+{
+    assert(compiler);
+    assert(directory);
+    assert(programName);
+
+    compiler->isCacheUsed   = true;
+    compiler->cachedProgram = programName;
+    construct(&compiler->cache, directory);
+}
+
+void setErrorsFile(Compiler* compiler, FILE* errorsFile)
+{
+    assert(compiler);
+    assert(errorsFile);
+
+    compiler->errorsFile = errorsFile;
+}
+
+const char* errorString(CompilerError error)
+{
+    if (error < COMPILER_ERRORS_COUNT)
+    {
+        return COMPILER_ERROR_STRINGS[error];
+    }
+
+    return "UNDEFINED error";
+}
+
+int32_t nextLabelNumber(Compiler* compiler, LabelPurposeType labelType)
+{
+    ASSERT_COMPILER(compiler);
+
+    return compiler->labelManager.curLabelNumbers[labelType]++;
+}
+
+//------------------------------------------------------------------------------
+//! @param name Function's name or one of the label constants.
+//!
+//! @return The same label every time it's called with the name.
+//------------------------------------------------------------------------------
+Label namedLabel(Compiler* compiler, const char* name)
+{
+    ASSERT_COMPILER(compiler);
+
+    return {namedLabelId(&compiler->labelManager, name), name, -1};
+}
+
+//------------------------------------------------------------------------------
+//! @return New label of a condition, a loop etc. (local to the function).
+//------------------------------------------------------------------------------
+Label localLabel(Compiler* compiler, const char* name, int32_t number)
+{
+    ASSERT_COMPILER(compiler);
+
+    return {newLabelId(&compiler->labelManager), name, number};
+}
+
+//------------------------------------------------------------------------------
+//! @return Label of the string's data, which is named after the string unless
+//!         the string is anonymous.
+//------------------------------------------------------------------------------
+Label stringLabel(Compiler* compiler, int stringId)
+{
+    ASSERT_COMPILER(compiler);
+
+    const String* string = getString(compiler->table, stringId);
+    LabelId       label  = compiler->firstStringLabel + stringId;
+
+    if (string->name != nullptr) { return {label, string->name, -1};       }
+    else                         { return {label, LABEL_STRING, stringId}; }
+}
+
+void writeLabel(Compiler* compiler, Label label)
+{
+    ASSERT_COMPILER(compiler);
+
+    setLabelOffset(&compiler->labelManager, label.id, compiler->builder.offset);
+
+    /* Labels like ".WHILE_9" are local to the function being compiled. */
+    const char* function = label.name[0] == '.' ? CUR_FUNC->name : nullptr;
+    addLabelSymbol(&compiler->labelManager, {label, function});
+
+    if (label.number >= 0)
+    {
+        write(compiler, "%s%" PRId32 ":\n", label.name, label.number);
+    }
+    else 
+    {
+        write(compiler, "%s:\n", label.name);
+    }
+}
+
+//------------------------------------------------------------------------------
+//! Attributes the code written from now on to the source line (see DebugInfo).
+//------------------------------------------------------------------------------
+void writeSourceLine(Compiler* compiler, uint32_t line)
+{
+    ASSERT_COMPILER(compiler);
+
+    if (compiler->isDebugInfoNeeded)
+    {
+        addLineRow(&compiler->debugInfo, compiler->builder.offset, line);
+    }
+}
+
+void compileError(Compiler* compiler, CompilerError error)
+{
+    ASSERT_COMPILER(compiler);
+
+    compiler->status = error;
+
+    fprintf(compiler->errorsFile, "COMPILATION ERROR: %s\n", errorString(error));
+}
+
+CompilerError compile(Compiler* compiler)
+{
+    assert(compiler);
+
+    if (getFunction(compiler->table, intern(MAIN_FUNCTION_NAME)) == nullptr)
+    {
+        compileError(compiler, COMPILER_ERROR_NO_MAIN_FUNCTION);
+        return compiler->status;
+    }
+
+    compiler->firstStringLabel = newLabelIds(&compiler->labelManager, 
+                                             compiler->table->stringsData.count);
+
+    compileProgram(compiler);
+    if (compiler->isNasmNeeded) { flush(&compiler->listing); }
+    if (compiler->status != COMPILER_NO_ERROR) { return compiler->status; }
+
+    resolveFixups(compiler);
+
+    if (compiler->isDebugInfoNeeded)
+    {
+        writeDebugSections(&compiler->debugInfo, &compiler->builder, &compiler->labelManager);
+    }
+
+    writeSymbolTable(compiler);
+    
+    writeElfFile(&compiler->builder.elfFile, compiler->builder.offset);
+
+    return compiler->status;
+}
+
+//------------------------------------------------------------------------------
+//! Emits the whole program in one pass. References to labels which aren't 
+//! written yet are left zeroed and recorded as fixups (see resolveFixups()).
+//------------------------------------------------------------------------------
+void compileProgram(Compiler* compiler)
+{
+    ASSERT_COMPILER(compiler);
+
+    startTextSegment(&compiler->builder);
+
+    writeEntryPoint(compiler);
+    writeStdFunctions(compiler);
+
+    // Skipping strings declarations
+    NodeIndex curDeclaration = TREE->root;
+    while (curDeclaration != NO_NODE && nodeType(TREE, curDeclaration) == SDECL_TYPE)
+    {
+        curDeclaration = leftChild(TREE, curDeclaration);
+    }
+
+    Function* firstFunction = compiler->table->functionsData.functions;
+
+    if (compiler->isCacheUsed)
+    {
+        compileCached(compiler, curDeclaration, firstFunction);
+    }
+    else if (compiler->threadsCount > 1)
+    {
+        compileParallel(compiler, curDeclaration, firstFunction);
+    }
+    else
+    {
+        compileFunctions(compiler, curDeclaration, NO_NODE, firstFunction);
+    }
+
+    if (compiler->isSizeOptimized) { relaxBranches(compiler); }
+
+    endTextSegment(&compiler->builder);
+    writeBSS(compiler);
+    writeData(compiler);
+}
+
+//------------------------------------------------------------------------------
+//! Compiles the reachable functions declared from the first declaration up to
+//! the end one (not including it).
+//!
+//! @param firstFunction Function of the first declaration.
+//------------------------------------------------------------------------------
+void compileFunctions(Compiler* compiler, NodeIndex first, NodeIndex end, Function* firstFunction)
+{
+    ASSERT_COMPILER(compiler);
+    assert(firstFunction);
+
+    CUR_FUNC = firstFunction;
+
+    for (NodeIndex declaration = first; declaration != end; declaration = leftChild(TREE, declaration))
+    {
+        assert(declaration != NO_NODE);
+
+        if (CUR_FUNC->isReachable)
+        {
+            compileFunction(compiler, rightChild(TREE, declaration));
+            write(compiler, "\n\n");
+        }
+
+        CUR_FUNC++;
+    }
+}
+
+//------------------------------------------------------------------------------
+//! Functions compiled by a separate thread into a part of the program (see 
+//! constructPart()). The part's listing is gathered in memory.
+//------------------------------------------------------------------------------
+struct CompilingJob
+{
+    Compiler  part;
+    NodeIndex first;
+    NodeIndex end;
+    Function* firstFunction;
+
+    char*     listing;
+    size_t    listingSize;
+
+    pthread_t thread;
+    bool      threadStarted;
+};
+
+static void* compileJob(void* job)
+{
+    assert(job);
+
+    CompilingJob* compilingJob = (CompilingJob*) job;
+    Compiler*     part         = &compilingJob->part;
+
+    compileFunctions(part, compilingJob->first, compilingJob->end, compilingJob->firstFunction);
+
+    /* The part's jumps don't leave it, so they are relaxed right away. */
+    if (part->isSizeOptimized) { relaxBranches(part); }
+
+    return nullptr;
+}
+
+//------------------------------------------------------------------------------
+//! Compiles the functions from the first declaration on with up to 
+//! threadsCount threads. The declarations are split into chunks of about the 
+//! same number of nodes, each of which is compiled into a part of the program
+//! (see constructPart()). As jumps never leave functions, and calls, strings' 
+//! addresses and labels are merged by ids and resolved as fixups, placing the
+//! parts one after another in the order of the chunks gives exactly the same 
+//! code as compileFunctions() does.
+//!
+//! Programs too small to be split are compiled in the current thread.
+//------------------------------------------------------------------------------
+void compileParallel(Compiler* compiler, NodeIndex first, Function* firstFunction)
+{
+    ASSERT_COMPILER(compiler);
+    assert(compiler->program == nullptr);
+    assert(firstFunction);
+
+    size_t nodesCount  = first != NO_NODE ? TREE->count - (size_t) first : 0;
+    size_t chunksCount = nodesCount / PARALLEL_COMPILING_MIN_CHUNK_NODES;
+
+    if (chunksCount > compiler->threadsCount)         { chunksCount = compiler->threadsCount;         }
+    if (chunksCount > PARALLEL_COMPILING_MAX_THREADS) { chunksCount = PARALLEL_COMPILING_MAX_THREADS; }
+
+    if (chunksCount <= 1)
+    {
+        compileFunctions(compiler, first, NO_NODE, firstFunction);
+        return;
+    }
+
+    allocateNamedLabels(compiler, first, firstFunction);
+
+    CompilingJob jobs[PARALLEL_COMPILING_MAX_THREADS] = {};
+    size_t       jobsCount     = 0;
+    NodeIndex    chunkStart    = first;
+    Function*    chunkFunction = firstFunction;
+
+    for (size_t chunk = 0; chunk < chunksCount && chunkStart != NO_NODE; chunk++)
+    {
+        NodeIndex split          = (NodeIndex) (first + nodesCount * (chunk + 1) / chunksCount);
+        NodeIndex chunkEnd       = chunkStart;
+        size_t    functionsCount = 0;
+
+        /* The last chunk's split is the tree's end. */
+        do
+        {
+            chunkEnd = leftChild(TREE, chunkEnd);
+            functionsCount++;
+        } while (chunkEnd != NO_NODE && chunkEnd < split);
+
+        CompilingJob* job = &jobs[jobsCount++];
+
+        size_t chunkNodes = (chunkEnd != NO_NODE ? (size_t) chunkEnd : TREE->count) - (size_t) chunkStart;
+        constructPart(&job->part, compiler, ELF_INITIAL_SIZE + ELF_BYTES_PER_NODE * chunkNodes);
+
+        if (compiler->isNasmNeeded)
+        {
+            FILE* listingFile = open_memstream(&job->listing, &job->listingSize);
+            assert(listingFile);
+
+            addNasmFile(&job->part, listingFile);
+        }
+
+        job->first         = chunkStart;
+        job->end           = chunkEnd;
+        job->firstFunction = chunkFunction;
+
+        chunkStart     = chunkEnd;
+        chunkFunction += functionsCount;
+    }
+
+    /* All the parts have to be constructed before the first one is merged. */
+    for (size_t i = 0; i < jobsCount; i++)
+    {
+        CompilingJob* job = &jobs[i];
+
+        job->threadStarted = pthread_create(&job->thread, nullptr, compileJob, job) == 0;
+        if (!job->threadStarted) { compileJob(job); }
+    }
+
+    for (size_t i = 0; i < jobsCount; i++)
+    {
+        CompilingJob* job = &jobs[i];
+        if (job->threadStarted) { pthread_join(job->thread, nullptr); }
+
+        mergePart(compiler, &job->part);
+
+        FILE* listingFile = job->part.listing.file;
+        if (listingFile != nullptr)
+        {
+            flush(&job->part.listing);
+            fflush(listingFile);
+
+            writeChars(&compiler->listing, job->listing, job->listingSize);
+        }
+
+        destroy(&job->part);
+
+        if (listingFile != nullptr)
+        {
+            fclose(listingFile);
+            free(job->listing);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+//! Allocates the labels which can be referenced by the functions from the 
+//! first declaration on, as parts can't allocate named labels.
+//------------------------------------------------------------------------------
+void allocateNamedLabels(Compiler* compiler, NodeIndex first, Function* firstFunction)
+{
+    ASSERT_COMPILER(compiler);
+    assert(firstFunction);
+
+    const Function* function = firstFunction;
+    for (NodeIndex declaration = first; declaration != NO_NODE; declaration = leftChild(TREE, declaration))
+    {
+        if (function->isReachable) { namedLabel(compiler, function->name); }
+        function++;
+    }
+
+    namedLabel(compiler, LABEL_IO_BUFFER);
+}
+
+//------------------------------------------------------------------------------
+//! Label referenced or written by a cached function. The function's own labels
+//! are numbered from 0, and the program's ones are kept by the strings' ids and
+//! by the names, as their ids differ from program to program.
+//------------------------------------------------------------------------------
+enum CachedLabelKind
+{
+    CACHED_LABEL_OWN,
+    CACHED_LABEL_STRING,
+    CACHED_LABEL_NAMED
+};
+
+struct CachedLabel
+{
+    uint32_t kind;
+    uint32_t value; /* own label's number, string's id or name's offset in the names */
+};
+
+//------------------------------------------------------------------------------
+//! Beginning of a cached function's data, which is followed by the code, the 
+//! own labels' offsets, the fixups, symbols, exports, rows and frames, the 
+//! listing and the names. Offsets are relative to the function's start and 
+//! lines to the line of its name, so the data doesn't depend on where the 
+//! function is.
+//------------------------------------------------------------------------------
+struct CachedFunctionHeader
+{
+    uint64_t codeSize;
+    uint64_t listingSize;
+    uint64_t namesSize;
+    uint32_t labelsCount;
+    uint32_t fixupsCount;
+    uint32_t symbolsCount;
+    uint32_t exportsCount;
+    uint32_t rowsCount;
+    uint32_t framesCount;
+};
+
+struct CachedFixup
+{
+    uint64_t    offset;
+    CachedLabel label;
+    uint32_t    type;
+    uint32_t    reserved;
+};
+
+struct CachedSymbol
+{
+    CachedLabel label;
+    uint32_t    name;    /* offset in the names */
+    int32_t     number;
+    uint32_t    isLocal;
+};
+
+struct CachedExport
+{
+    CachedLabel label;
+    int64_t     offset;
+};
+
+struct CachedRow
+{
+    uint64_t offset;
+    int64_t  line;
+};
+
+struct CachedFrame
+{
+    CachedLabel start;
+    CachedLabel returnLabel;
+};
+
+//------------------------------------------------------------------------------
+//! Reachable function, whose data is either found in the cache's pack or 
+//! compiled into the buffer.
+//------------------------------------------------------------------------------
+struct CachedFunction
+{
+    NodeIndex     declaration;
+    Function*     function;
+    CacheBuffer   key;
+    CacheSlice    data;
+    CacheBuffer   compiled;
+    bool          isHit;
+    CompilerError status;
+};
+
+//------------------------------------------------------------------------------
+//! Misses compiled by a separate thread: every step-th one from the first.
+//------------------------------------------------------------------------------
+struct CachingJob
+{
+    const Compiler*  compiler;
+    CachedFunction** misses;
+    size_t           missesCount;
+    size_t           first;
+    size_t           step;
+    const char**     labelNames;
+
+    pthread_t        thread;
+    bool             threadStarted;
+};
+
+static void* compileCachingJob(void* job)
+{
+    assert(job);
+
+    CachingJob* cachingJob = (CachingJob*) job;
+
+    for (size_t i = cachingJob->first; i < cachingJob->missesCount; i += cachingJob->step)
+    {
+        compileMissed(cachingJob->compiler, cachingJob->misses[i], cachingJob->labelNames);
+    }
+
+    return nullptr;
+}
+
+//------------------------------------------------------------------------------
+//! Compiles the functions from the first declaration on, taking the ones which
+//! didn't change from the program's pack in the cache, which is rewritten with
+//! all the functions if enough of them were missed. The function's key (see 
+//! buildFunctionKey()) describes everything its code depends on, and the cached
+//! code refers to the program's labels by the names, so it can be placed 
+//! anywhere in any program.
+//! The misses are compiled one by one into parts of the program (see 
+//! constructPart()) with up to threadsCount threads, and are placed from their
+//! cached form too, so the code is exactly the same as compileFunctions() 
+//! gives, whether the functions are found or not.
+//------------------------------------------------------------------------------
+void compileCached(Compiler* compiler, NodeIndex first, Function* firstFunction)
+{
+    ASSERT_COMPILER(compiler);
+    assert(compiler->program == nullptr);
+    assert(firstFunction);
+
+    allocateNamedLabels(compiler, first, firstFunction);
+
+    size_t    functionsCount = 0;
+    Function* function       = firstFunction;
+    for (NodeIndex declaration = first; declaration != NO_NODE; declaration = leftChild(TREE, declaration))
+    {
+        if (function->isReachable) { functionsCount++; }
+        function++;
+    }
+
+    /* The functions are kept in the program's pack, one per set of options. */
+    CacheBuffer packKey = {};
+    construct(&packKey);
+
+    appendProgramPath(&packKey, compiler->cachedProgram);
+    appendUInt32(&packKey, cacheOptions(compiler));
+
+    openCachePack(&compiler->cache.pack, compiler->cache.directory, &packKey);
+    destroy(&packKey);
+
+    CachedFunction*  functions   = (CachedFunction*)  calloc(functionsCount + 1, sizeof(CachedFunction));
+    CachedFunction** misses      = (CachedFunction**) calloc(functionsCount + 1, sizeof(CachedFunction*));
+    size_t           missesCount = 0;
+    assert(functions);
+    assert(misses);
+
+    CachedFunction* cached = functions;
+    function = firstFunction;
+    for (NodeIndex declaration = first; declaration != NO_NODE; declaration = leftChild(TREE, declaration))
+    {
+        if (function->isReachable)
+        {
+            cached->declaration = declaration;
+            cached->function    = function;
+            construct(&cached->key);
+
+            buildFunctionKey(compiler, declaration, function, &cached->key);
+            cached->isHit = findCachedFunction(&compiler->cache, &cached->key, &cached->data);
+
+            if (!cached->isHit)
+            {
+                construct(&cached->compiled);
+                misses[missesCount++] = cached;
+            }
+            cached++;
+        }
+
+        function++;
+    }
+
+    /* Misses refer to the program's labels by these names. */
+    const NamesIndex* namedLabels = &compiler->labelManager.namedLabels;
+    const char**      labelNames  = (const char**) calloc(compiler->labelManager.count + 1, sizeof(const char*));
+    assert(labelNames);
+
+    for (size_t slot = 0; slot < namedLabels->capacity; slot++)
+    {
+        if (namedLabels->slots[slot].name != nullptr)
+        {
+            labelNames[namedLabels->slots[slot].position] = namedLabels->slots[slot].name;
+        }
+    }
+
+    size_t threadsCount = compiler->threadsCount > 1 ? compiler->threadsCount : 1;
+    if (threadsCount > PARALLEL_COMPILING_MAX_THREADS) { threadsCount = PARALLEL_COMPILING_MAX_THREADS; }
+    if (threadsCount > missesCount)                    { threadsCount = missesCount;                    }
+
+    CachingJob jobs[PARALLEL_COMPILING_MAX_THREADS] = {};
+    for (size_t i = 0; i < threadsCount; i++)
+    {
+        CachingJob* job = &jobs[i];
+
+        job->compiler    = compiler;
+        job->misses      = misses;
+        job->missesCount = missesCount;
+        job->first       = i;
+        job->step        = threadsCount;
+        job->labelNames  = labelNames;
+
+        job->threadStarted = threadsCount > 1 && pthread_create(&job->thread, nullptr, compileCachingJob, job) == 0;
+        if (!job->threadStarted) { compileCachingJob(job); }
+    }
+
+    for (size_t i = 0; i < threadsCount; i++)
+    {
+        if (jobs[i].threadStarted) { pthread_join(jobs[i].thread, nullptr); }
+    }
+
+    /* A few misses are compiled again instead (see CACHE_PACK_REWRITE_MISSES_PART). */
+    bool        isRewritten  = missesCount > 0 && 
+                               missesCount * CACHE_PACK_REWRITE_MISSES_PART >= functionsCount;
+    CacheEntry* entries      = nullptr;
+    size_t      entriesCount = 0;
+    if (isRewritten)
+    {
+        entries = (CacheEntry*) calloc(functionsCount + 1, sizeof(CacheEntry));
+        assert(entries);
+    }
+
+    for (size_t i = 0; i < functionsCount; i++)
+    {
+        cached = &functions[i];
+        mergeCached(compiler, cached);
+
+        if (isRewritten && cached->status == COMPILER_NO_ERROR)
+        {
+            entries[entriesCount++] = {{cached->key.bytes, cached->key.size}, cached->data};
+        }
+    }
+
+    if (isRewritten)
+    {
+        storeCachePack(&compiler->cache.pack, entries, entriesCount);
+        free(entries);
+    }
+
+    for (size_t i = 0; i < functionsCount; i++)
+    {
+        destroy(&functions[i].key);
+        if (!functions[i].isHit) { destroy(&functions[i].compiled); }
+    }
+
+    free(labelNames);
+    free(misses);
+    free(functions);
+}
+
+//------------------------------------------------------------------------------
+//! Options which the code depends on.
+//------------------------------------------------------------------------------
+uint32_t cacheOptions(const Compiler* compiler)
+{
+    ASSERT_COMPILER(compiler);
+
+    return (uint32_t) compiler->isSizeOptimized        | 
+           (uint32_t) compiler->isNasmNeeded      << 1 | 
+           (uint32_t) compiler->isDebugInfoNeeded << 2;
+}
+
+//------------------------------------------------------------------------------
+//! Key of the function's code: the options which the code depends on, the 
+//! function's variables and subtree (with the nodes' children and lines 
+//! relative to the declaration), and the signatures of the functions and 
+//! strings which it uses.
+//------------------------------------------------------------------------------
+void buildFunctionKey(Compiler* compiler, NodeIndex declaration, const Function* function, CacheBuffer* key)
+{
+    ASSERT_COMPILER(compiler);
+    assert(declaration != NO_NODE);
+    assert(function);
+    assert(key);
+
+    appendUInt32(key, cacheOptions(compiler));
+
+    appendString(key, function->name);
+    appendVarUInt(key, function->paramsCount);
+    appendVarUInt(key, function->varsData.count);
+
+    for (size_t i = 0; i < function->varsData.count; i++)
+    {
+        appendString(key, function->varsData.vars[i]);
+    }
+
+    NodeIndex end          = declarationEnd(TREE, declaration);
+    uint32_t  functionLine = nodeLine(TREE, rightChild(TREE, declaration));
+
+    for (NodeIndex node = declaration; node < end; node++)
+    {
+        NodeType type = nodeType(TREE, node);
+        NodeData data = nodeData(TREE, node);
+
+        /* The node's numbers are gathered here and appended at once. */
+        uint8_t  fields[NODE_KEY_MAX_FIELDS * CACHE_VAR_UINT_MAX_SIZE] = {};
+        uint8_t* cursor = writeVarUInt(fields, type);
+
+        if (compiler->isDebugInfoNeeded)
+        {
+            uint32_t line = nodeLine(TREE, node);
+
+            cursor = writeVarUInt(cursor, line != 0);
+            cursor = writeVarUInt(cursor, line != 0 ? line - functionLine : 0);
+        }
+
+        switch (type)
+        {
+            case FDECL_TYPE:  { cursor = writeVarUInt(cursor, data.isVoidFunction);    break; }
+            case MATH_TYPE:   { cursor = writeVarUInt(cursor, data.operation);         break; }
+            case NUMBER_TYPE: { cursor = writeVarUInt(cursor, (uint64_t) data.number); break; }
+
+            case STRING_TYPE:
+            {
+                appendBytes(key, fields, (size_t) (cursor - fields));
+                appendString(key, data.string);
+
+                cursor = writeVarUInt(fields, (uint32_t) getStringByContent(compiler->table, data.string));
+                break;
+            }
+
+            case ID_TYPE:
+            {
+                appendBytes(key, fields, (size_t) (cursor - fields));
+                appendString(key, data.id.name);
+
+                cursor = writeVarUInt(fields, (uint32_t) data.id.varSlot);
+                if (data.id.varSlot != NO_VAR_SLOT) { break; }
+
+                /* Otherwise it's a called function's or a string's name. */
+                const Function* callee = getFunction(compiler->table, data.id.name);
+
+                cursor = writeVarUInt(cursor, callee != nullptr ? callee->paramsCount + 1 : 0);
+                cursor = writeVarUInt(cursor, (uint32_t) getStringByName(compiler->table, data.id.name));
+                break;
+            }
+
+            default: { break; }
+        }
+
+        if (type == BLOCK_TYPE || type == EXPR_LIST_TYPE)
+        {
+            const NodeIndex* children      = listChildren(TREE, node);
+            size_t           childrenCount = listLength(TREE, node);
+
+            cursor = writeVarUInt(cursor, childrenCount);
+            appendBytes(key, fields, (size_t) (cursor - fields));
+
+            for (size_t i = 0; i < childrenCount; i++)
+            {
+                appendVarUInt(key, relativeNode(children[i], declaration));
+            }
+        }
+        else
+        {
+            /* The declaration's left is the next declaration. */
+            cursor = writeVarUInt(cursor, relativeNode(node != declaration ? leftChild(TREE, node) : NO_NODE, 
+                                                       declaration));
+            cursor = writeVarUInt(cursor, relativeNode(rightChild(TREE, node), declaration));
+
+            appendBytes(key, fields, (size_t) (cursor - fields));
+        }
+    }
+}
+
+uint32_t relativeNode(NodeIndex node, NodeIndex declaration)
+{
+    return node != NO_NODE ? node - declaration : NO_NODE;
+}
+
+//------------------------------------------------------------------------------
+//! Compiles the function into a part of the program (see constructPart()) and
+//! puts the part into the function's data in the cached form.
+//------------------------------------------------------------------------------
+void compileMissed(const Compiler* compiler, CachedFunction* cached, const char** labelNames)
+{
+    ASSERT_COMPILER(compiler);
+    assert(cached);
+    assert(labelNames);
+
+    NodeIndex declaration = cached->declaration;
+    size_t    nodesCount  = (size_t) declarationEnd(TREE, declaration) - (size_t) declaration;
 
-//==============================Write NASM comments==============================
-void writeHorizontalLine (Compiler* compiler);
-void writeFunctionHeader (Compiler* compiler);
-//==============================Write NASM comments==============================
+    Compiler part = {};
+    constructPart(&part, compiler, ELF_INITIAL_SIZE + ELF_BYTES_PER_NODE * nodesCount);
 
-//==================================Compilation==================================
-void compileFunction         (Compiler* compiler, Node* node);
-void compileBlock            (Compiler* compiler, Node* node);
-void compileStatement        (Compiler* compiler, Node* node);
-
-void compileCondition        (Compiler* compiler, Node* node);
-void compileLoop             (Compiler* compiler, Node* node);
-void compileExitCondition    (Compiler* compiler, Node* node, Label exitLabel);
-void compileAssignment       (Compiler* compiler, Node* node);
-void compileAssignmentVar    (Compiler* compiler, Node* node);
-void compileAssignmentArray  (Compiler* compiler, Node* node);
-void compileArrayDeclaration (Compiler* compiler, Node* node);
-void compileReturn           (Compiler* compiler, Node* node);
-
-void compileExpression       (Compiler* compiler, Node* node);
-bool isSimpleOperand         (Compiler* compiler, Node* node);
-void compileSimpleOperand    (Compiler* compiler, Node* node, Reg64 result);
-bool tryTwoOperandSimple     (Compiler* compiler, Node* node);
-void compileTwoOperand       (Compiler* compiler, Node* node);
-void compileMath             (Compiler* compiler, Node* node);
-void compileCompare          (Compiler* compiler, Node* node);
-void compileMemAccess        (Compiler* compiler, Node* node);
-void compileString           (Compiler* compiler, Node* node, Reg64 result);
-void compileNumber           (Compiler* compiler, Node* node, Reg64 result);
-void compileVar              (Compiler* compiler, Node* node, Reg64 result);
-
-void compileParamList        (Compiler* compiler, Node* node, const Function* function);
-void compileCall             (Compiler* compiler, Node* node);
-//==================================Compilation=================================
+    char*  listing     = nullptr;
+    size_t listingSize = 0;
+    FILE*  listingFile = nullptr;
 
+    if (compiler->isNasmNeeded)
+    {
+        listingFile = open_memstream(&listing, &listingSize);
+        assert(listingFile);
 
-//===================================Compiler===================================
-void construct(Compiler* compiler, Node* tree, SymbolTable* table)
-{
-    assert(compiler);
-    assert(tree);
-    assert(table);
+        addNasmFile(&part, listingFile);
+    }
 
-    compiler->table = table; 
-    compiler->tree  = tree;
-    construct(&compiler->labelManager);
-}
+    compileFunctions(&part, declaration, leftChild(TREE, declaration), cached->function);
 
-void destroy(Compiler* compiler)
-{
-    assert(compiler);
+    /* The function's jumps don't leave it, so they are relaxed right away. */
+    if (part.isSizeOptimized) { relaxBranches(&part); }
 
-    compiler->table = nullptr;
-    compiler->tree  = nullptr;
-    destroy(&compiler->labelManager);
-    destroy(&compiler->builder);
-}
+    if (listingFile != nullptr)
+    {
+        flush(&part.listing);
+        fflush(listingFile);
+    }
 
-void addElfFile(Compiler* compiler, FILE* elfFile)
-{
-    assert(compiler);
-    assert(elfFile);
+    serializePart(&part, labelNames, nodeLine(TREE, rightChild(TREE, declaration)), 
+                  listing, listingSize, &cached->compiled);
+    cached->data   = {cached->compiled.bytes, cached->compiled.size};
+    cached->status = part.status;
+
+    destroy(&part);
 
-    construct(&compiler->builder, elfFile, ELF_INITIAL_SIZE);
+    if (listingFile != nullptr)
+    {
+        fclose(listingFile);
+        free(listing);
+    }
 }
 
-void addNasmFile(Compiler* compiler, FILE* nasmFile)
+//------------------------------------------------------------------------------
+//! Appends the part's code, labels, debug info and listing to the data in the
+//! cached form (see CachedFunctionHeader).
+//!
+//! @param labelNames   Program's label id -> its name, if it's a named label.
+//! @param functionLine Line of the function's name, which the lines are kept 
+//!                     relative to.
+//------------------------------------------------------------------------------
+void serializePart(const Compiler* part, const char** labelNames, uint32_t functionLine, 
+                   const char* listing, size_t listingSize, CacheBuffer* data)
 {
-    assert(compiler);
-    assert(nasmFile);
+    ASSERT_COMPILER(part);
+    assert(part->program != nullptr);
+    assert(labelNames);
+    assert(data);
+
+    const LabelManager* labelManager = &part->labelManager;
+    const DebugInfo*    debugInfo    = &part->debugInfo;
+
+    CacheBuffer names = {};
+    construct(&names);
+
+    size_t               headerStart = data->size;
+    CachedFunctionHeader header      = {};
+
+    header.codeSize     = part->builder.offset;
+    header.listingSize  = listing != nullptr ? listingSize : 0;
+    header.labelsCount  = (uint32_t) labelManager->count;
+    header.fixupsCount  = (uint32_t) labelManager->fixupsCount;
+    header.symbolsCount = (uint32_t) labelManager->symbolsCount;
+    header.exportsCount = (uint32_t) labelManager->exportsCount;
+    header.rowsCount    = part->isDebugInfoNeeded ? (uint32_t) debugInfo->rowsCount   : 0;
+    header.framesCount  = part->isDebugInfoNeeded ? (uint32_t) debugInfo->framesCount : 0;
+
+    reserveBytes(data, sizeof(header));
+    appendBytes(data, part->builder.elfFile.bytecode, header.codeSize);
+    appendBytes(data, labelManager->offsets, header.labelsCount * sizeof(int64_t));
+
+    for (size_t i = 0; i < header.fixupsCount; i++)
+    {
+        Fixup       fixup       = labelManager->fixups[i];
+        CachedFixup cachedFixup = {fixup.offset, cachedLabel(part, fixup.label, labelNames, &names), 
+                                   (uint32_t) fixup.type, 0};
 
-    compiler->isNasmNeeded = true;
-    compiler->nasmFile     = nasmFile;
+        appendBytes(data, &cachedFixup, sizeof(cachedFixup));
+    }
+
+    for (size_t i = 0; i < header.symbolsCount; i++)
+    {
+        LabelSymbol  symbol       = labelManager->symbols[i];
+        CachedSymbol cachedSymbol = {};
+
+        cachedSymbol.label   = cachedLabel(part, symbol.label.id, labelNames, &names);
+        cachedSymbol.name    = (uint32_t) names.size;
+        cachedSymbol.number  = symbol.label.number;
+        cachedSymbol.isLocal = symbol.function != nullptr;
+        appendString(&names, symbol.label.name);
+
+        appendBytes(data, &cachedSymbol, sizeof(cachedSymbol));
+    }
+
+    for (size_t i = 0; i < header.exportsCount; i++)
+    {
+        LabelExport  labelExport  = labelManager->exports[i];
+        CachedExport cachedExport = {cachedLabel(part, labelExport.label, labelNames, &names), labelExport.offset};
+
+        appendBytes(data, &cachedExport, sizeof(cachedExport));
+    }
+
+    for (size_t i = 0; i < header.rowsCount; i++)
+    {
+        LineRow   row       = debugInfo->rows[i];
+        CachedRow cachedRow = {row.offset, (int64_t) row.line - (int64_t) functionLine};
+
+        appendBytes(data, &cachedRow, sizeof(cachedRow));
+    }
+
+    for (size_t i = 0; i < header.framesCount; i++)
+    {
+        FunctionFrame frame       = debugInfo->frames[i];
+        CachedFrame   cachedFrame = {cachedLabel(part, frame.start,       labelNames, &names), 
+                                     cachedLabel(part, frame.returnLabel, labelNames, &names)};
+
+        appendBytes(data, &cachedFrame, sizeof(cachedFrame));
+    }
+
+    appendBytes(data, listing, header.listingSize);
+
+    header.namesSize = names.size;
+    appendBytes(data, names.bytes, names.size);
+
+    memcpy(data->bytes + headerStart, &header, sizeof(header));
+
+    destroy(&names);
 }
 
-const char* errorString(CompilerError error)
+CachedLabel cachedLabel(const Compiler* part, LabelId label, const char** labelNames, CacheBuffer* names)
 {
-    if (error < COMPILER_ERRORS_COUNT)
+    ASSERT_COMPILER(part);
+    assert(labelNames);
+    assert(names);
+
+    const LabelManager* labelManager = &part->labelManager;
+    size_t              stringsCount = part->table->stringsData.count;
+
+    if (label >= labelManager->firstPartId)
     {
-        return COMPILER_ERROR_STRINGS[error];
+        return {CACHED_LABEL_OWN, (uint32_t) (label - labelManager->firstPartId)};
     }
 
-    return "UNDEFINED error";
+    if (label >= part->firstStringLabel && (size_t) (label - part->firstStringLabel) < stringsCount)
+    {
+        return {CACHED_LABEL_STRING, (uint32_t) (label - part->firstStringLabel)};
+    }
+
+    assert(labelNames[label] != nullptr);
+
+    CachedLabel cached = {CACHED_LABEL_NAMED, (uint32_t) names->size};
+    appendString(names, labelNames[label]);
+
+    return cached;
 }
 
-int32_t nextLabelNumber(Compiler* compiler, LabelPurposeType labelType)
+static const uint8_t* readCached(const uint8_t* cursor, void* value, size_t size)
 {
-    ASSERT_COMPILER(compiler);
-
-    return compiler->labelManager.curLabelNumbers[labelType]++;
+    memcpy(value, cursor, size);
+    return cursor + size;
 }
 
 //------------------------------------------------------------------------------
-//! If a label with the same (optionally) functionName name and (optionally) 
-//! number already contains in the compiler's LabelManager, then return it, 
-//! otherwise return the same label without any changes. This is needed to get 
-//! the valid offset of the label (which is not always possible on the first 
-//! pass of the compiler), based on its (optionally) functionName, name and 
-//! (optionally) number. 
-//! 
-//! @param compiler
-//! @param label
-//! 
-//! @return Label with a changed offset, if the label already exists, or the 
-//!         same label. 
+//! Places the cached function at the current offset and merges its labels and
+//! debug info into the program's ones, like mergePart() does with a part.
 //------------------------------------------------------------------------------
-Label getExistingLabel(Compiler* compiler, Label label)
+void mergeCached(Compiler* compiler, const CachedFunction* cached)
 {
     ASSERT_COMPILER(compiler);
+    assert(cached);
+    assert(cached->data.size >= sizeof(CachedFunctionHeader));
 
-    int idx = findLabel(&compiler->labelManager.labelArray, label);
+    LabelManager*        labelManager = &compiler->labelManager;
+    const uint8_t*       cursor       = cached->data.bytes;
+    CachedFunctionHeader header       = {};
 
-    if (idx != -1) { return compiler->labelManager.labelArray.labels[idx]; }
-    else           { return label; }
-}
+    cursor = readCached(cursor, &header, sizeof(header));
 
-void writeLabel(Compiler* compiler, Label label)
-{
-    ASSERT_COMPILER(compiler);
+    const char* names        = (const char*) (cached->data.bytes + cached->data.size - header.namesSize);
+    uint32_t    functionLine = nodeLine(TREE, rightChild(TREE, cached->declaration));
+    uint64_t    offset       = compiler->builder.offset;
 
-    int existingLabelIdx = findLabel(&compiler->labelManager.labelArray, label); 
-    label.offset = compiler->builder.offset;
+    writeBytes(&compiler->builder, cursor, header.codeSize);
+    cursor += header.codeSize;
 
-    if (existingLabelIdx == -1)
+    LabelId firstOwnLabel = newLabelIds(labelManager, header.labelsCount);
+    for (uint32_t i = 0; i < header.labelsCount; i++)
     {
-        insertLabel(&compiler->labelManager.labelArray, label);
+        int64_t labelOffset = LABEL_NOT_WRITTEN;
+        cursor = readCached(cursor, &labelOffset, sizeof(labelOffset));
+
+        if (labelOffset != LABEL_NOT_WRITTEN)
+        {
+            setLabelOffset(labelManager, firstOwnLabel + (LabelId) i, labelOffset + (int64_t) offset);
+        }
     }
-    else
+
+    for (uint32_t i = 0; i < header.fixupsCount; i++)
     {
-        compiler->labelManager.labelArray.labels[existingLabelIdx] = label;
+        CachedFixup fixup = {};
+        cursor = readCached(cursor, &fixup, sizeof(fixup));
+
+        addFixup(labelManager, {fixup.offset + offset, resolveCachedLabel(compiler, fixup.label, firstOwnLabel, names),
+                                (FixupType) fixup.type});
     }
 
-    if (label.number >= 0)
+    for (uint32_t i = 0; i < header.symbolsCount; i++)
     {
-        write(compiler, "%s%" PRId32 ":\n", label.name, label.number);
+        CachedSymbol symbol = {};
+        cursor = readCached(cursor, &symbol, sizeof(symbol));
+
+        Label label = {resolveCachedLabel(compiler, symbol.label, firstOwnLabel, names), 
+                       cachedLabelName(names + symbol.name), symbol.number};
+
+        addLabelSymbol(labelManager, {label, symbol.isLocal ? cached->function->name : nullptr});
     }
-    else 
+
+    for (uint32_t i = 0; i < header.exportsCount; i++)
     {
-        write(compiler, "%s:\n", label.name);
+        CachedExport labelExport = {};
+        cursor = readCached(cursor, &labelExport, sizeof(labelExport));
+
+        setLabelOffset(labelManager, resolveCachedLabel(compiler, labelExport.label, firstOwnLabel, names), 
+                       labelExport.offset + (int64_t) offset);
     }
+
+    for (uint32_t i = 0; i < header.rowsCount; i++)
+    {
+        CachedRow row = {};
+        cursor = readCached(cursor, &row, sizeof(row));
+
+        addLineRow(&compiler->debugInfo, row.offset + offset, (uint32_t) (functionLine + row.line));
+    }
+
+    for (uint32_t i = 0; i < header.framesCount; i++)
+    {
+        CachedFrame frame = {};
+        cursor = readCached(cursor, &frame, sizeof(frame));
+
+        addFunctionFrame(&compiler->debugInfo, {resolveCachedLabel(compiler, frame.start,       firstOwnLabel, names), 
+                                                resolveCachedLabel(compiler, frame.returnLabel, firstOwnLabel, names)});
+    }
+
+    if (compiler->isNasmNeeded)
+    {
+        writeChars(&compiler->listing, (const char*) cursor, header.listingSize);
+    }
+
+    if (cached->status != COMPILER_NO_ERROR) { compiler->status = cached->status; }
 }
 
-void compileError(Compiler* compiler, CompilerError error)
+LabelId resolveCachedLabel(Compiler* compiler, CachedLabel label, LabelId firstOwnLabel, const char* names)
 {
     ASSERT_COMPILER(compiler);
+    assert(names);
 
-    compiler->status = error;
+    switch (label.kind)
+    {
+        case CACHED_LABEL_OWN:    { return firstOwnLabel + (LabelId) label.value;              }
+        case CACHED_LABEL_STRING: { return compiler->firstStringLabel + (LabelId) label.value; }
+        case CACHED_LABEL_NAMED:  { return namedLabel(compiler, cachedLabelName(names + label.value)).id; }
 
-    printf("COMPILATION ERROR: %s\n", errorString(error));
+        default: { assert(!"Valid cached label kind."); return 0; }
+    }
 }
 
-CompilerError compile(Compiler* compiler)
+//------------------------------------------------------------------------------
+//! @return The label constant with the same name or the interned name, as 
+//!         named labels are looked up by the pointers of their names.
+//------------------------------------------------------------------------------
+const char* cachedLabelName(const char* name)
 {
-    assert(compiler);
+    assert(name);
 
-    if (getFunction(compiler->table, MAIN_FUNCTION_NAME) == nullptr)
+    for (size_t i = 0; i < LABEL_CONSTANTS_COUNT; i++)
     {
-        compileError(compiler, COMPILER_ERROR_NO_MAIN_FUNCTION);
-        return compiler->status;
+        if (strcmp(name, LABEL_CONSTANTS[i]) == 0) { return LABEL_CONSTANTS[i]; }
     }
 
-    uint8_t passes = COMPILER_TOTAL_PASSES_ELF;
-    if (compiler->isNasmNeeded && passes < COMPILER_TOTAL_PASSES_NASM)
+    return intern(name);
+}
+
+void resolveFixups(Compiler* compiler)
+{
+    ASSERT_COMPILER(compiler);
+
+    LabelManager* labelManager = &compiler->labelManager;
+
+    for (size_t i = 0; i < labelManager->fixupsCount; i++)
     {
-        passes = COMPILER_TOTAL_PASSES_NASM;
+        Fixup   fixup       = labelManager->fixups[i];
+        int64_t labelOffset = getLabelOffset(labelManager, fixup.label);
+        assert(labelOffset != LABEL_NOT_WRITTEN);
+
+        switch (fixup.type)
+        {
+            case FIXUP_REL32:
+            {
+                patchUInt32(&compiler->builder, fixup.offset, (uint32_t) (labelOffset - (fixup.offset + 4)));
+                break;
+            }
+
+            case FIXUP_ABS64:
+            {
+                patchUInt64(&compiler->builder, fixup.offset, labelOffset + VIRTUAL_ADDRESS_START);
+                break;
+            }
+
+            default: { assert(!"Valid fixup type."); }
+        }
     }
 
-    for (uint8_t pass = 0; pass < passes; pass++)
+    labelManager->fixupsCount = 0;
+}
+
+//------------------------------------------------------------------------------
+//! Adds the entry point, functions and written labels to the ELF's symbol 
+//! table (so that profilers and debuggers could tell the functions apart).
+//! Local labels are named "<function><label>", e.g. "fact.WHILE_9".
+//------------------------------------------------------------------------------
+void writeSymbolTable(Compiler* compiler)
+{
+    ASSERT_COMPILER(compiler);
+
+    ElfBuilder*       builder      = &compiler->builder;
+    const Elf64_Phdr* textHeader   = &builder->elfFile.textHeader;
+    LabelManager*     labelManager = &compiler->labelManager;
+
+    addSymbol(builder, "_start", textHeader->p_offset, STT_FUNC, STB_GLOBAL);
+
+    for (size_t i = 0; i < labelManager->symbolsCount; i++)
     {
-        compiler->passNumber = pass;
-        makeCompilationPass(compiler);
+        LabelSymbol symbol = labelManager->symbols[i];
+        uint64_t    offset = (uint64_t) getLabelOffset(labelManager, symbol.label.id);
+
+        char name[MAX_SYMBOL_NAME_LENGTH] = "";
+        int  nameLength = snprintf(name, MAX_SYMBOL_NAME_LENGTH, "%s%s", 
+                                   symbol.function != nullptr ? symbol.function : "", 
+                                   symbol.label.name);
+
+        if (symbol.label.number >= 0 && (size_t) nameLength < MAX_SYMBOL_NAME_LENGTH)
+        {
+            snprintf(name + nameLength, MAX_SYMBOL_NAME_LENGTH - nameLength, 
+                     "%" PRId32, symbol.label.number);
+        }
+
+        if (symbol.function != nullptr)
+        {
+            addSymbol(builder, name, offset, STT_NOTYPE, STB_LOCAL);
+        }
+        else if (offset < textHeader->p_offset + textHeader->p_filesz)
+        {
+            addSymbol(builder, name, offset, STT_FUNC, STB_GLOBAL);
+        }
+        else
+        {
+            addSymbol(builder, name, offset, STT_OBJECT, STB_LOCAL);
+        }
     }
-    
-    writeElfFile(&compiler->builder.elfFile, compiler->builder.offset);
 
-    return compiler->status;
+    writeSections(builder);
 }
 
-CompilerError makeCompilationPass(Compiler* compiler)
+//------------------------------------------------------------------------------
+//! Shortens the jumps to rel8 where possible and encodes all of the branches.
+//! Has to be called right after the text is emitted, as it's compacted.
+//!
+//! All the branches start in the rel32 form and are shortened while there are
+//! ones whose targets are in range. As shortening only brings the code closer
+//! together, no branch has to be made long again and the process ends.
+//------------------------------------------------------------------------------
+void relaxBranches(Compiler* compiler)
 {
     ASSERT_COMPILER(compiler);
 
-    setBuilderToStart(&compiler->builder);
-    resetLabelNumbers(&compiler->labelManager);
-    startTextSegment(&compiler->builder);
+    LabelManager* labelManager = &compiler->labelManager;
+    Branch*       branches     = labelManager->branches;
+    size_t        count        = labelManager->branchesCount;
 
-    writeEntryPoint(compiler);
-    writeStdFunctions(compiler);
+    /* savedBefore[i] - number of bytes saved by shortening branches[0..i-1]. */
+    uint64_t* savedBefore = (uint64_t*) calloc(count + 1, sizeof(uint64_t));
+    assert(savedBefore);
 
-    // Skipping strings declarations
-    Node* curDeclaration = compiler->tree;
-    while (curDeclaration != nullptr && curDeclaration->type == SDECL_TYPE)
+    bool isChanged = true;
+    while (isChanged)
+    {
+        isChanged = false;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            savedBefore[i + 1] = savedBefore[i] + (branches[i].isShort ? branches[i].longSize - SHORT_JUMP_SIZE : 0);
+        }
+
+        for (size_t i = 0; i < count; i++)
+        {
+            Branch* branch = &branches[i];
+            if (branch->isShort || branch->shortOpcode == 0) { continue; }
+
+            int64_t target = relaxedOffset(labelManager, savedBefore, getLabelOffset(labelManager, branch->label));
+            int64_t end    = relaxedOffset(labelManager, savedBefore, branch->offset) + SHORT_JUMP_SIZE;
+
+            /* Branches shortened in this pass only reduce the distance. */
+            if (INT8_MIN <= target - end && target - end <= INT8_MAX)
+            {
+                branch->isShort = true;
+                isChanged       = true;
+            }
+        }
+    }
+
+    /* Moving the code between the branches to the new offsets. */
+    uint8_t* bytecode = compiler->builder.elfFile.bytecode;
+    uint64_t textEnd  = compiler->builder.offset;
+    uint64_t src      = count > 0 ? branches[0].offset : textEnd;
+    uint64_t dest     = src;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        Branch branch = branches[i];
+
+        memmove(bytecode + dest, bytecode + src, branch.offset - src);
+        dest += branch.offset - src;
+        src   = branch.offset;
+
+        int64_t target = relaxedOffset(labelManager, savedBefore, getLabelOffset(labelManager, branch.label));
+
+        if (branch.isShort)
+        {
+            bytecode[dest]     = branch.shortOpcode;
+            bytecode[dest + 1] = (uint8_t) (int8_t) (target - (int64_t) (dest + SHORT_JUMP_SIZE));
+            dest += SHORT_JUMP_SIZE;
+        }
+        else
+        {
+            memmove(bytecode + dest, bytecode + src, branch.longSize - 4);
+            patchUInt32(&compiler->builder, dest + branch.longSize - 4, 
+                        (uint32_t) (target - (int64_t) (dest + branch.longSize)));
+            dest += branch.longSize;
+        }
+
+        src += branch.longSize;
+    }
+
+    memmove(bytecode + dest, bytecode + src, textEnd - src);
+    compiler->builder.offset = dest + (textEnd - src);
+
+    /* The freed tail becomes the padding of the segment. */
+    memset(bytecode + compiler->builder.offset, 0, textEnd - compiler->builder.offset);
+
+    /* Only the text's labels are written by now. */
+    for (size_t label = 0; label < labelManager->count; label++)
     {
-        curDeclaration = curDeclaration->left;
+        if (labelManager->offsets[label] != LABEL_NOT_WRITTEN)
+        {
+            labelManager->offsets[label] = relaxedOffset(labelManager, savedBefore, labelManager->offsets[label]);
+        }
     }
 
-    CUR_FUNC = compiler->table->functionsData.functions;
+    for (size_t i = 0; i < labelManager->exportsCount; i++)
+    {
+        labelManager->exports[i].offset = relaxedOffset(labelManager, savedBefore, labelManager->exports[i].offset);
+    }
 
-    while (curDeclaration != nullptr)
+    for (size_t i = 0; i < labelManager->fixupsCount; i++)
     {
-        compileFunction(compiler, curDeclaration->right);
-        curDeclaration = curDeclaration->left;
-        CUR_FUNC++;
+        labelManager->fixups[i].offset = relaxedOffset(labelManager, savedBefore, labelManager->fixups[i].offset);
+    }
 
-        write(compiler, "\n\n");
+    if (compiler->isDebugInfoNeeded)
+    {
+        DebugInfo* debugInfo = &compiler->debugInfo;
+        for (size_t i = 0; i < debugInfo->rowsCount; i++)
+        {
+            debugInfo->rows[i].offset = relaxedOffset(labelManager, savedBefore, debugInfo->rows[i].offset);
+        }
     }
 
-    endTextSegment(&compiler->builder);
-    writeBSS(compiler);
-    writeData(compiler);
+    free(savedBefore);
+    labelManager->branchesCount = 0;
+}
+
+//------------------------------------------------------------------------------
+//! @return Offset after the branches are shortened according to savedBefore 
+//!         (see relaxBranches()) of the code which isn't inside a branch.
+//------------------------------------------------------------------------------
+uint64_t relaxedOffset(const LabelManager* labelManager, const uint64_t* savedBefore, uint64_t offset)
+{
+    assert(labelManager);
+    assert(savedBefore);
+
+    /* Number of branches starting before the offset. */
+    size_t left  = 0;
+    size_t right = labelManager->branchesCount;
+    while (left < right)
+    {
+        size_t middle = left + (right - left) / 2;
+
+        if (labelManager->branches[middle].offset < offset) { left  = middle + 1; }
+        else                                                { right = middle;     }
+    }
 
-    return COMPILER_NO_ERROR;
+    return offset - savedBefore[left];
 }
 //===================================Compiler===================================
 
@@ -253,12 +1554,14 @@ void write(Compiler* compiler, const char* format, ...)
     ASSERT_COMPILER(compiler);
     assert(format);
 
-    if (compiler->isNasmNeeded && compiler->passNumber < COMPILER_TOTAL_PASSES_NASM)
+    if (compiler->isNasmNeeded)
     {
         va_list args;
         va_start(args, format);
 
-        vfprintf(compiler->nasmFile, format, args);
+        writeFormatted(&compiler->listing, format, args);
+
+        va_end(args);
     }
 }
 
@@ -274,13 +1577,15 @@ void writeIndented(Compiler* compiler, const char* format, ...)
     ASSERT_COMPILER(compiler);
     assert(format);
 
-    if (compiler->isNasmNeeded && compiler->passNumber < COMPILER_TOTAL_PASSES_NASM)
+    if (compiler->isNasmNeeded)
     {
         va_list args;
         va_start(args, format);
 
-        fprintf(compiler->nasmFile, INDENTATION);
-        vfprintf(compiler->nasmFile, format, args);
+        writeString(&compiler->listing, INDENTATION);
+        writeFormatted(&compiler->listing, format, args);
+
+        va_end(args);
     }
 }
 
@@ -288,14 +1593,12 @@ void writeHorizontalLine(Compiler* compiler)
 {
     ASSERT_COMPILER(compiler);
 
-    write(compiler, "; ");
-
-    for (size_t i = 0; i < HORIZONTAL_LINE_LENGTH; i++)
+    if (compiler->isNasmNeeded)
     {
-        write(compiler, "=");
+        writeChars   (&compiler->listing, "; ", 2);
+        writeRepeated(&compiler->listing, '=', HORIZONTAL_LINE_LENGTH);
+        writeChars   (&compiler->listing, "\n", 1);
     }
-
-    write(compiler, "\n");
 }
 
 void writeFunctionHeader(Compiler* compiler)
@@ -342,7 +1645,7 @@ void writeEntryPoint(Compiler* compiler)
                     "section .text \n\n"
                     "_start:       \n");
 
-    Label mainLabel = getExistingLabel(compiler, {0, nullptr, "love", -1});
+    Label mainLabel = namedLabel(compiler, intern(MAIN_FUNCTION_NAME));
     write_call_rel32(compiler, mainLabel);
     
     write_mov_r64_imm64(compiler, RAX, SYSCALL_EXIT);
@@ -350,14 +1653,51 @@ void writeEntryPoint(Compiler* compiler)
     write_syscall(compiler, "exiting program with code 0");
 }
 
+//------------------------------------------------------------------------------
+//! Writes only the standard functions which are called by reachable functions.
+//------------------------------------------------------------------------------
 void writeStdFunctions(Compiler* compiler)
 {
     ASSERT_COMPILER(compiler);
+
+    bool isUsed[STANDARD_FUNCTIONS_COUNT] = {};
+    findUsedStdFunctions(compiler, isUsed);
     
     for (size_t i = 0; i < STANDARD_FUNCTIONS_COUNT; i++)
     {
-        writeStdFunction(compiler, STANDARD_FUNCTIONS[i]);
-        if (compiler->status != COMPILER_NO_ERROR) { break; }
+        if (isUsed[i]) { writeStdFunction(compiler, STANDARD_FUNCTIONS[i]); }
+    }
+}
+
+//------------------------------------------------------------------------------
+//! @param isUsed Is set to true for the standard functions (in the order of 
+//!               STANDARD_FUNCTIONS) which are called by reachable functions.
+//------------------------------------------------------------------------------
+void findUsedStdFunctions(Compiler* compiler, bool* isUsed)
+{
+    ASSERT_COMPILER(compiler);
+    assert(isUsed);
+
+    const Function* function = compiler->table->functionsData.functions;
+
+    for (NodeIndex declaration = TREE->root; declaration != NO_NODE; declaration = leftChild(TREE, declaration))
+    {
+        if (nodeType(TREE, declaration) != FDECL_TYPE) { continue; }
+        if (!(function++)->isReachable)                { continue; }
+
+        NodeIndex end = declarationEnd(TREE, declaration);
+        for (NodeIndex node = declaration + 1; node < end; node++)
+        {
+            if (nodeType(TREE, node) != CALL_TYPE) { continue; }
+
+            KeywordCode stdFunction = isStdFunction(nodeData(TREE, leftChild(TREE, node)).id.name);
+            if (stdFunction == INVALID_KEYWORD) { continue; }
+
+            for (size_t i = 0; i < STANDARD_FUNCTIONS_COUNT; i++)
+            {
+                if (STANDARD_FUNCTIONS[i].code == stdFunction) { isUsed[i] = true; }
+            }
+        }
     }
 }
 
@@ -365,8 +1705,10 @@ void writeStdFunction(Compiler* compiler, StdFunctionInfo info)
 {
     ASSERT_COMPILER(compiler);
 
-    Function* function = pushFunction(compiler->table, info.workingName);
-    Label     label    = getExistingLabel(compiler, {0, nullptr, function->name, -1});
+    Function* function = pushFunction(compiler->table, intern(info.workingName));
+    function->isReachable = true;
+
+    Label label = namedLabel(compiler, function->name);
 
     /* Needed in order to not have double labels. */
     bool isNasmNeeded = compiler->isNasmNeeded; 
@@ -374,46 +1716,20 @@ void writeStdFunction(Compiler* compiler, StdFunctionInfo info)
     writeLabel(compiler, label);
     compiler->isNasmNeeded = isNasmNeeded;
 
-    static char filenameBytecode[MAX_STD_FUNC_LENGTH];
-    snprintf(filenameBytecode, MAX_STD_FUNC_LENGTH, 
-             "../potter_tongue_libs/io/%s.bytecode", info.workingName);
-
-    uint8_t* bytecode     = nullptr;
-    size_t   bytecodeSize = 0;
-    if (!loadFile(filenameBytecode, (char**) &bytecode, &bytecodeSize))
-    {
-        compileError(compiler, COMPILER_ERROR_NO_STDIO_BYTECODE);
-        return;
-    }
+    const StdFunctionCode* code = getStdFunctionCode(info.workingName);
+    assert(code);
 
-    writeBytes(&compiler->builder, bytecode, bytecodeSize);
-    free(bytecode);
+    writeBytes(&compiler->builder, code->bytecode, code->bytecodeSize);
 
-    if (compiler->isNasmNeeded && compiler->passNumber < COMPILER_TOTAL_PASSES_NASM)
+    if (compiler->isNasmNeeded)
     {
-        static char filenameNasm[MAX_STD_FUNC_LENGTH];
-        snprintf(filenameNasm, MAX_STD_FUNC_LENGTH, 
-                "../potter_tongue_libs/io/%s.nasm", info.workingName);
-
-        char*  nasmCode     = nullptr;
-        size_t nasmCodeSize = 0;
-
-        if (!loadFile(filenameNasm, &nasmCode, &nasmCodeSize))
-        {
-            compileError(compiler, COMPILER_ERROR_NO_STDIO_NASM_CODE);
-            return;
-        }
-
-        fwrite(nasmCode, 1, nasmCodeSize, compiler->nasmFile);
+        writeChars(&compiler->listing, code->nasm, code->nasmSize);
         writeNewLine(compiler);
-
-        free(nasmCode);
-    
     }
 
     for (size_t param = 0; param < info.parametersCount; param++)
     {
-        pushParameter(function, info.parameters[param]);
+        pushParameter(function, intern(info.parameters[param]));
     }
 }
 
@@ -424,12 +1740,10 @@ void writeBSS(Compiler* compiler)
     startBssSegment(&compiler->builder);
 
     write(compiler, "section .bss\n");
-    Label ioBufferLabel = getExistingLabel(compiler, {0, nullptr, "IO_BUFFER", -1});
-    writeLabel(compiler, ioBufferLabel);
+    writeLabel(compiler, namedLabel(compiler, LABEL_IO_BUFFER));
     writeIndented(compiler, "resb %zu\n", IO_BUFFER_SIZE);
 
-    compiler->builder.offset += IO_BUFFER_SIZE;
-    endBssSegment(&compiler->builder);
+    endBssSegment(&compiler->builder, IO_BUFFER_SIZE);
 }
 
 void writeData(Compiler* compiler)
@@ -452,18 +1766,9 @@ void writeStringsData(Compiler* compiler)
     for (size_t i = 0; i < stringsData->count; i++)
     {
         String curString = stringsData->strings[i]; 
+        if (!curString.isReachable) { continue; }
 
-        if (curString.name != nullptr)
-        {
-            writeLabel(compiler, {0, nullptr, curString.name, -1});
-        } 
-        else 
-        {
-            writeLabel(compiler, {0, 
-                                  nullptr, 
-                                  "STR", 
-                                  getStringNumber(compiler->table, stringsData->strings + i)});
-        }
+        writeLabel(compiler, stringLabel(compiler, (int) i));
 
         writeBytes(&compiler->builder, 
                    (const uint8_t*) curString.content, 
@@ -483,17 +1788,22 @@ void writeStringsData(Compiler* compiler)
 
 
 //==================================Compilation==================================
-void compileFunction(Compiler* compiler, Node* node)
+void compileFunction(Compiler* compiler, NodeIndex node)
 {
     ASSERT_COMPILER(compiler);
-    assert(node);
+    assert(node != NO_NODE);
 
     writeFunctionHeader(compiler);
 
-    Label label  = {};
-    label.name   = CUR_FUNC->name;
-    label.number = -1;
-    writeLabel(compiler, label);
+    /* Local labels are numbered in each function anew, so that the numbers 
+     * don't depend on the other functions (see compileParallel()). */
+    resetLabelNumbers(&compiler->labelManager);
+
+    Label    functionLabel = namedLabel(compiler, CUR_FUNC->name);
+    uint32_t functionLine  = nodeLine(TREE, node);
+
+    writeLabel(compiler, functionLabel);
+    writeSourceLine(compiler, functionLine);
 
     write_push_r64(compiler, RBP);
     write_mov_r64_r64(compiler, RBP, RSP);
@@ -504,61 +1814,68 @@ void compileFunction(Compiler* compiler, Node* node)
     }
 
     write(compiler, "\n");
-    compileBlock(compiler, node->left);
+    compiler->returnLabel = localLabel(compiler, LABEL_RETURN, -1);
+    compileBlock(compiler, leftChild(TREE, node));
 
-    Label retLabel = {};
-    retLabel.functionName = CUR_FUNC->name;
-    retLabel.name         = ".RETURN";
-    retLabel.number       = -1;
-    writeLabel(compiler, retLabel);
+    writeLabel(compiler, compiler->returnLabel);
+    writeSourceLine(compiler, functionLine);
     
     write_mov_r64_r64(compiler, RSP, RBP);
     write_pop_r64(compiler, RBP);
     write_ret(compiler);
+
+    if (compiler->isDebugInfoNeeded)
+    {
+        addFunctionFrame(&compiler->debugInfo, {functionLabel.id, compiler->returnLabel.id});
+    }
 }
 
-void compileBlock(Compiler* compiler, Node* node)
+void compileBlock(Compiler* compiler, NodeIndex node)
 {
     ASSERT_COMPILER(compiler);
-    assert(node);
+    assert(node != NO_NODE);
+
+    assert(nodeType(TREE, node) == BLOCK_TYPE);
 
-    Node* curStatement = node->right;
-    while (curStatement != nullptr)
+    const NodeIndex* statements      = listChildren(TREE, node);
+    size_t           statementsCount = listLength(TREE, node);
+
+    for (size_t i = 0; i < statementsCount; i++)
     {
-        compileStatement(compiler, curStatement);
-        curStatement = curStatement->right;
+        compileStatement(compiler, statements[i]);
     }
 }
 
-void compileStatement(Compiler* compiler, Node* node)
+void compileStatement(Compiler* compiler, NodeIndex node)
 {
     ASSERT_COMPILER(compiler);
-    assert(node);
-    assert(node->left);
+    assert(node != NO_NODE);
+
+    writeSourceLine(compiler, nodeLine(TREE, node));
 
-    switch (node->left->type)
+    switch (nodeType(TREE, node))
     {
-        case COND_TYPE:   { compileCondition        (compiler, node->left); break; }
-        case LOOP_TYPE:   { compileLoop             (compiler, node->left); break; }
-        case VDECL_TYPE:  { compileAssignment       (compiler, node->left); break; }
-        case ASSIGN_TYPE: { compileAssignment       (compiler, node->left); break; }
-        case ADECL_TYPE:  { compileArrayDeclaration (compiler, node->left); break; }
-        case JUMP_TYPE:   { compileReturn           (compiler, node->left); break; }
-        default:          { compileExpression       (compiler, node->left); break; }
+        case COND_TYPE:   { compileCondition        (compiler, node); break; }
+        case LOOP_TYPE:   { compileLoop             (compiler, node); break; }
+        case VDECL_TYPE:  { compileAssignment       (compiler, node); break; }
+        case ASSIGN_TYPE: { compileAssignment       (compiler, node); break; }
+        case ADECL_TYPE:  { compileArrayDeclaration (compiler, node); break; }
+        case JUMP_TYPE:   { compileReturn           (compiler, node); break; }
+        default:          { compileExpression       (compiler, node); break; }
     }
 }
 
-void compileCondition(Compiler* compiler, Node* node)
+void compileCondition(Compiler* compiler, NodeIndex node)
 {
     ASSERT_COMPILER(compiler);
-    assert(node);
+    assert(node != NO_NODE);
 
-    Node*   condition = node->left;
-    Node*   body      = node->right;
+    NodeIndex condition = leftChild(TREE, node);
+    NodeIndex body      = rightChild(TREE, node);
 
-    int32_t labelNum  = nextLabelNumber(compiler, LABEL_COND);
-    Label   elseLabel = getExistingLabel(compiler, {0, CUR_FUNC->name, ".ELSE_",       labelNum});
-    Label   endLabel  = getExistingLabel(compiler, {0, CUR_FUNC->name, ".END_IF_ELSE", labelNum});
+    int32_t   labelNum  = nextLabelNumber(compiler, LABEL_COND);
+    Label     elseLabel = localLabel(compiler, LABEL_ELSE,        labelNum);
+    Label     endLabel  = localLabel(compiler, LABEL_END_IF_ELSE, labelNum);
 
     writeIndented(compiler, "; ==== if-else statement ====\n");
     
@@ -567,32 +1884,32 @@ void compileCondition(Compiler* compiler, Node* node)
     writeNewLine(compiler);
 
     writeIndented(compiler, "; if true\n");
-    compileBlock(compiler, body->left);    
+    compileBlock(compiler, leftChild(TREE, body));    
 
     write_jmp_rel32(compiler, endLabel);
     writeNewLine(compiler);
 
     writeLabel(compiler, elseLabel);
 
-    if (body->right != nullptr)
+    if (rightChild(TREE, body) != NO_NODE)
     {
-        compileBlock(compiler, body->right);
+        compileBlock(compiler, rightChild(TREE, body));
     }
 
     writeLabel(compiler, endLabel);
 }
 
-void compileLoop(Compiler* compiler, Node* node)
+void compileLoop(Compiler* compiler, NodeIndex node)
 {
     ASSERT_COMPILER(compiler);
-    assert(node);
+    assert(node != NO_NODE);
 
-    Node*   condition  = node->left;
-    Node*   body       = node->right;
+    NodeIndex condition  = leftChild(TREE, node);
+    NodeIndex body       = rightChild(TREE, node);
 
-    int32_t labelNum   = nextLabelNumber(compiler, LABEL_LOOP);
-    Label   whileLabel = getExistingLabel(compiler, {0, CUR_FUNC->name, ".WHILE_",     labelNum});
-    Label   endLabel   = getExistingLabel(compiler, {0, CUR_FUNC->name, ".END_WHILE_", labelNum});
+    int32_t   labelNum   = nextLabelNumber(compiler, LABEL_LOOP);
+    Label     whileLabel = localLabel(compiler, LABEL_WHILE,     labelNum);
+    Label     endLabel   = localLabel(compiler, LABEL_END_WHILE, labelNum);
 
     writeIndented(compiler, "; ==== while ====\n");
     writeLabel(compiler, whileLabel);
@@ -608,12 +1925,12 @@ void compileLoop(Compiler* compiler, Node* node)
     writeLabel(compiler, endLabel);
 }
 
-void compileExitCondition(Compiler* compiler, Node* node, Label exitLabel)
+void compileExitCondition(Compiler* compiler, NodeIndex node, Label exitLabel)
 {
     ASSERT_COMPILER(compiler);
-    assert(node);
+    assert(node != NO_NODE);
 
-    if (node->type != MATH_TYPE || !isComparisonOp(node->data.operation))
+    if (nodeType(TREE, node) != MATH_TYPE || !isComparisonOp(nodeData(TREE, node).operation))
     {
         compileExpression(compiler, node);
         write_test_r64_r64(compiler, RAX, RAX);
@@ -624,7 +1941,7 @@ void compileExitCondition(Compiler* compiler, Node* node, Label exitLabel)
         compileTwoOperand(compiler, node);
         write_cmp_r64_r64(compiler, RAX, RBX);
 
-        switch (node->data.operation)
+        switch (nodeData(TREE, node).operation)
         {
             case EQUAL_OP:         { write_jne_rel32 (compiler, exitLabel); break; }
             case NOT_EQUAL_OP:     { write_je_rel32  (compiler, exitLabel); break; }
@@ -637,12 +1954,12 @@ void compileExitCondition(Compiler* compiler, Node* node, Label exitLabel)
     }
 }
 
-void compileAssignment(Compiler* compiler, Node* node)
+void compileAssignment(Compiler* compiler, NodeIndex node)
 {
     ASSERT_COMPILER(compiler);
-    assert(node);
+    assert(node != NO_NODE);
 
-    if (node->left->type == ID_TYPE)
+    if (nodeType(TREE, leftChild(TREE, node)) == ID_TYPE)
     {
         compileAssignmentVar(compiler, node);
     }
@@ -652,40 +1969,41 @@ void compileAssignment(Compiler* compiler, Node* node)
     }
 }
 
-void compileAssignmentVar(Compiler* compiler, Node* node)
+void compileAssignmentVar(Compiler* compiler, NodeIndex node)
 {
     ASSERT_COMPILER(compiler);
-    assert(node);
+    assert(node != NO_NODE);
 
-    const char* var       = node->left->data.id;
-    Mem64       varMemory = mem64BaseDisp(RBP, getVarOffset(CUR_FUNC, var)); 
+    IdData var       = nodeData(TREE, leftChild(TREE, node)).id;
+    Mem64  varMemory = mem64BaseDisp(RBP, getSlotOffset(CUR_FUNC, var.varSlot)); 
 
-    writeIndented(compiler, "; --- assignment to %s ---\n", var);
+    writeIndented(compiler, "; --- assignment to %s ---\n", var.name);
     writeIndented(compiler, "; evaluating expression\n");
-    compileExpression(compiler, node->right);      
+    compileExpression(compiler, rightChild(TREE, node));      
 
     write_mov_m64_r64(compiler, varMemory, RAX); 
 
     writeNewLine(compiler);
 }
 
-void compileAssignmentArray(Compiler* compiler, Node* node)
+void compileAssignmentArray(Compiler* compiler, NodeIndex node)
 {
     ASSERT_COMPILER(compiler);
-    assert(node);
+    assert(node != NO_NODE);
 
-    const char* var       = node->left->left->data.id;
-    Mem64       varMemory = mem64BaseDisp(RBP, getVarOffset(CUR_FUNC, var)); 
+    NodeIndex memAccess = leftChild(TREE, node);
+    IdData    var       = nodeData(TREE, leftChild(TREE, memAccess)).id;
+    Mem64     varMemory = mem64BaseDisp(RBP, getSlotOffset(CUR_FUNC, var.varSlot)); 
 
-    writeIndented(compiler, "; --- assignment to %s ---\n", var);
+    writeIndented(compiler, "; --- assignment to %s ---\n", var.name);
     write_mov_r64_m64(compiler, RAX, varMemory);             
 
     write_push_r64(compiler, RAX, "save variable");          
-    compileExpression(compiler, node->left->right);                  
+    compileExpression(compiler, rightChild(TREE, memAccess));                  
     write_neg_r64(compiler, RAX, "addressing in memory is from right to left");
 
     write_push_r64(compiler, RAX, "save index");
-    compileExpression(compiler, node->right);
+    compileExpression(compiler, rightChild(TREE, node));
 
     write_pop_r64(compiler, RCX, "restore index to rcx");
     write_pop_r64(compiler, RBX, "restore variable to rbx"); 
@@ -699,18 +2017,18 @@ void compileAssignmentArray(Compiler* compiler, Node* node)
     writeNewLine(compiler);
 }
 
-void compileArrayDeclaration(Compiler* compiler, Node* node)
+void compileArrayDeclaration(Compiler* compiler, NodeIndex node)
 {
     ASSERT_COMPILER(compiler);
-    assert(node);
+    assert(node != NO_NODE);
 
-    const char* var       = node->left->data.id;
-    Mem64       varMemory = mem64BaseDisp(RBP, getVarOffset(CUR_FUNC, var)); 
+    IdData var       = nodeData(TREE, leftChild(TREE, node)).id;
+    Mem64  varMemory = mem64BaseDisp(RBP, getSlotOffset(CUR_FUNC, var.varSlot)); 
 
-    writeIndented(compiler, "; --- declaring array %s ---\n", var);
+    writeIndented(compiler, "; --- declaring array %s ---\n", var.name);
     
     writeIndented(compiler, "; evaluating expression (array's size)\n");
-    compileExpression(compiler, node->right);     
+    compileExpression(compiler, rightChild(TREE, node));     
     write_sal_r64_imm8(compiler, RAX, 3, "*8 to get array's size in bytes");
     write_sub_r64_imm32(compiler, RAX, 8, "to mitigate the next instruction");
 
@@ -721,23 +2039,22 @@ void compileArrayDeclaration(Compiler* compiler, Node* node)
     writeNewLine(compiler);
 }
 
-void compileReturn(Compiler* compiler, Node* node)
+void compileReturn(Compiler* compiler, NodeIndex node)
 {
     ASSERT_COMPILER(compiler);
-    assert(node);
+    assert(node != NO_NODE);
 
-    compileExpression(compiler, node->right);
+    compileExpression(compiler, rightChild(TREE, node));
     
-    Label label = getExistingLabel(compiler, {0, CUR_FUNC->name, ".RETURN", -1});
-    write_jmp_rel32(compiler, label);
+    write_jmp_rel32(compiler, compiler->returnLabel);
 }
 
-void compileExpression(Compiler* compiler, Node* node)
+void compileExpression(Compiler* compiler, NodeIndex node)
 {
     ASSERT_COMPILER(compiler);
-    assert(node);
+    assert(node != NO_NODE);
 
-    switch (node->type)
+    switch (nodeType(TREE, node))
     {
         case MATH_TYPE:       { compileMath      (compiler, node);      break; }
         case MEM_ACCESS_TYPE: { compileMemAccess (compiler, node);      break; }
@@ -750,22 +2067,24 @@ void compileExpression(Compiler* compiler, Node* node)
     }
 }
 
-bool isSimpleOperand(Compiler* compiler, Node* node)
+bool isSimpleOperand(Compiler* compiler, NodeIndex node)
 {
     ASSERT_COMPILER(compiler);
-    assert(node);
+    assert(node != NO_NODE);
     
-    return node->type == ID_TYPE     || 
-           node->type == NUMBER_TYPE || 
-           node->type == STRING_TYPE;
+    NodeType type = nodeType(TREE, node);
+
+    return type == ID_TYPE     || 
+           type == NUMBER_TYPE || 
+           type == STRING_TYPE;
 }
  
-void compileSimpleOperand(Compiler* compiler, Node* node, Reg64 result)
+void compileSimpleOperand(Compiler* compiler, NodeIndex node, Reg64 result)
 {
     ASSERT_COMPILER(compiler);
-    assert(node);
+    assert(node != NO_NODE);
 
-    switch (node->type)
+    switch (nodeType(TREE, node))
     {
         case STRING_TYPE: { compileString (compiler, node, result); break; }
         case NUMBER_TYPE: { compileNumber (compiler, node, result); break; }
@@ -774,38 +2093,41 @@ void compileSimpleOperand(Compiler* compiler, Node* node, Reg64 result)
     }
 }
 
-bool tryTwoOperandSimple(Compiler* compiler, Node* node)
+bool tryTwoOperandSimple(Compiler* compiler, NodeIndex node)
 {
     ASSERT_COMPILER(compiler);
-    assert(node);
+    assert(node != NO_NODE);
+
+    NodeIndex left  = leftChild(TREE, node);
+    NodeIndex right = rightChild(TREE, node);
 
-    if (!isSimpleOperand(compiler, node->left) || !isSimpleOperand(compiler, node->right))
+    if (!isSimpleOperand(compiler, left) || !isSimpleOperand(compiler, right))
     {
         return false;
     }
 
-    if (node->left->type == ID_TYPE && node->right->type == ID_TYPE)
+    if (nodeType(TREE, left) == ID_TYPE && nodeType(TREE, right) == ID_TYPE)
     {
         return false;
     }
 
-    compileSimpleOperand(compiler, node->left,  RAX);
-    compileSimpleOperand(compiler, node->right, RBX);
+    compileSimpleOperand(compiler, left,  RAX);
+    compileSimpleOperand(compiler, right, RBX);
 
     return true;
 }
 
-void compileTwoOperand(Compiler* compiler, Node* node)
+void compileTwoOperand(Compiler* compiler, NodeIndex node)
 {
     if (!tryTwoOperandSimple(compiler, node))
     {
-        compileExpression(compiler, node->left);
+        compileExpression(compiler, leftChild(TREE, node));
             
         writeNewLine(compiler);
         write_push_r64(compiler, RAX, "save rax");
         writeNewLine(compiler);
 
-        compileExpression(compiler, node->right);
+        compileExpression(compiler, rightChild(TREE, node));
 
         write_mov_r64_r64(compiler, RBX, RAX);
         write_pop_r64(compiler, RAX, "restore rax");
@@ -814,12 +2136,12 @@ void compileTwoOperand(Compiler* compiler, Node* node)
     }
 }
 
-void compileMath(Compiler* compiler, Node* node)
+void compileMath(Compiler* compiler, NodeIndex node)
 {
     ASSERT_COMPILER(compiler);
-    assert(node);
+    assert(node != NO_NODE);
 
-    MathOp operation = node->data.operation;
+    MathOp operation = nodeData(TREE, node).operation;
     compileTwoOperand(compiler, node);
 
     if (isComparisonOp(operation))
@@ -828,7 +2150,7 @@ void compileMath(Compiler* compiler, Node* node)
         return;
     }
 
-    switch (node->data.operation)
+    switch (operation)
     {
         case ADD_OP: { write_add_r64_r64  (compiler, RAX, RBX); break; }
         case SUB_OP: { write_sub_r64_r64  (compiler, RAX, RBX); break; }
@@ -845,19 +2167,18 @@ void compileMath(Compiler* compiler, Node* node)
     }
 }
 
-void compileCompare(Compiler* compiler, Node* node)
+void compileCompare(Compiler* compiler, NodeIndex node)
 {
     ASSERT_COMPILER(compiler);
-    assert(node);
+    assert(node != NO_NODE);
 
-    int32_t     labelNum  = nextLabelNumber(compiler, LABEL_CMP);
-    const char* funcName  = CUR_FUNC->name; 
-    Label       labelTrue = getExistingLabel(compiler, {0, funcName, ".CMP_TRUE_", labelNum});
-    Label       labelEnd  = getExistingLabel(compiler, {0, funcName, ".CMP_END_",  labelNum});
+    int32_t labelNum  = nextLabelNumber(compiler, LABEL_CMP);
+    Label   labelTrue = localLabel(compiler, LABEL_CMP_TRUE, labelNum);
+    Label   labelEnd  = localLabel(compiler, LABEL_CMP_END,  labelNum);
 
     write_cmp_r64_r64(compiler, RAX, RBX);
 
-    switch (node->data.operation)
+    switch (nodeData(TREE, node).operation)
     {
         case EQUAL_OP:         { write_je_rel32  (compiler, labelTrue); break; }
         case NOT_EQUAL_OP:     { write_jne_rel32 (compiler, labelTrue); break; }
@@ -879,16 +2200,16 @@ void compileCompare(Compiler* compiler, Node* node)
     writeLabel(compiler, labelEnd);
 }
 
-void compileMemAccess(Compiler* compiler, Node* node)
+void compileMemAccess(Compiler* compiler, NodeIndex node)
 {
     ASSERT_COMPILER(compiler);
-    assert(node);
+    assert(node != NO_NODE);
 
-    Mem64 varMemory = mem64BaseDisp(RBP, getVarOffset(CUR_FUNC, node->left->data.id)); 
+    Mem64 varMemory = mem64BaseDisp(RBP, getSlotOffset(CUR_FUNC, nodeData(TREE, leftChild(TREE, node)).id.varSlot)); 
     write_mov_r64_m64(compiler, RAX, varMemory);             
 
     write_push_r64(compiler, RAX, "save variable");          
-    compileExpression(compiler, node->right);                  
+    compileExpression(compiler, rightChild(TREE, node));                  
     write_neg_r64(compiler, RAX, "addressing in memory is from right to left");
     write_pop_r64(compiler, RBX, "restore variable to rbx"); 
 
@@ -899,73 +2220,78 @@ void compileMemAccess(Compiler* compiler, Node* node)
     write_mov_r64_m64(compiler, RAX, arrayElementMemory);    
 }
 
-void compileString(Compiler* compiler, Node* node, Reg64 result)
+void compileString(Compiler* compiler, NodeIndex node, Reg64 result)
 {
     ASSERT_COMPILER(compiler);
-    assert(node);
+    assert(node != NO_NODE);
 
-    String* string = getStringByContent(compiler->table, node->data.string);
+    int stringId = getStringByContent(compiler->table, nodeData(TREE, node).string);
+    assert(stringId != NO_STRING);
 
-    Label label = getExistingLabel(compiler, {0, 
-                                              nullptr, 
-                                              "STR", 
-                                              getStringNumber(compiler->table, string)});
-    write_mov_r64_imm64(compiler, result, label);
+    write_mov_r64_imm64(compiler, result, stringLabel(compiler, stringId));
 }
 
-void compileNumber(Compiler* compiler, Node* node, Reg64 result)
+void compileNumber(Compiler* compiler, NodeIndex node, Reg64 result)
 {
     ASSERT_COMPILER(compiler);
-    assert(node);
+    assert(node != NO_NODE);
 
-    write_mov_r64_imm64(compiler, result, node->data.number);
+    write_mov_r64_imm64(compiler, result, nodeData(TREE, node).number);
 }
 
-void compileVar(Compiler* compiler, Node* node, Reg64 result)
+void compileVar(Compiler* compiler, NodeIndex node, Reg64 result)
 {
     ASSERT_COMPILER(compiler);
-    assert(node);
+    assert(node != NO_NODE);
 
-    int varOffset = getVarOffset(CUR_FUNC, node->data.id);
-    if (varOffset != -1)
+    IdData var = nodeData(TREE, node).id;
+    if (var.varSlot != NO_VAR_SLOT)
     {
-        Mem64 varMemory = mem64BaseDisp(RBP, varOffset); 
+        Mem64 varMemory = mem64BaseDisp(RBP, getSlotOffset(CUR_FUNC, var.varSlot)); 
         write_mov_r64_m64(compiler, result, varMemory);
     }
     else
     {   
-        Label label = getExistingLabel(compiler, {0, nullptr, node->data.id, -1});
-        write_mov_r64_imm64(compiler, result, label);
+        int stringId = getStringByName(compiler->table, var.name);
+        assert(stringId != NO_STRING);
+
+        write_mov_r64_imm64(compiler, result, stringLabel(compiler, stringId));
     }
 }
 
-void compileParamList(Compiler* compiler, Node* node, const Function* function)
+void compileParamList(Compiler* compiler, NodeIndex node, const Function* function)
 {
     ASSERT_COMPILER(compiler);
-    assert(node);
+    assert(node != NO_NODE);
+
+    NodeIndex paramList = rightChild(TREE, node);
+    if (paramList == NO_NODE) { return; }
 
-    Node*  curParamExpr = node->right;
-    size_t paramNumber  = function->paramsCount;
-    while (curParamExpr != nullptr)
+    const NodeIndex* params      = listChildren(TREE, paramList);
+    size_t           paramsCount = listLength(TREE, paramList);
+    size_t           paramNumber = function->paramsCount;
+
+    for (size_t i = 0; i < paramsCount; i++)
     {
         writeIndented(compiler, "; param %zu\n", paramNumber);
 
-        compileExpression(compiler, curParamExpr->left); // (rax = expression)
-        write_push_r64(compiler, RAX);                 // push rax
+        compileExpression(compiler, params[i]); // (rax = expression)
+        write_push_r64(compiler, RAX);          // push rax
 
-        curParamExpr = curParamExpr->right;
         paramNumber--;
     }
 }
 
-void compileCall(Compiler* compiler, Node* node)
+void compileCall(Compiler* compiler, NodeIndex node)
 {
     ASSERT_COMPILER(compiler); 
-    assert(node);
+    assert(node != NO_NODE);
+
+    const char* functionName = nodeData(TREE, leftChild(TREE, node)).id.name;
 
-    writeIndented(compiler, "; --- calling %s() ---\n", node->left->data.id);
+    writeIndented(compiler, "; --- calling %s() ---\n", functionName);
 
-    Function* function = getFunction(compiler->table, node->left->data.id);
+    Function* function = getFunction(compiler->table, functionName);
     if (function == nullptr) 
     {
         compileError(compiler, COMPILER_ERROR_CALL_UNDEFINED_FUNCTION);
@@ -975,16 +2301,14 @@ void compileCall(Compiler* compiler, Node* node)
     KeywordCode stdFunction = isStdFunction(function->name);
     if (stdFunction != INVALID_KEYWORD && getStdFunctionInfo(stdFunction)->additionalParamNeeded)
     {
-        Label label = getExistingLabel(compiler, {0, nullptr, "IO_BUFFER", -1});
-        write_mov_r64_imm64(compiler, RAX, label);
+        write_mov_r64_imm64(compiler, RAX, namedLabel(compiler, LABEL_IO_BUFFER));
         write_push_r64(compiler, RAX);
     }
 
     compileParamList(compiler, node, function);
     writeNewLine(compiler);
 
-    Label label = getExistingLabel(compiler, {0, nullptr, function->name, -1});
-    write_call_rel32(compiler, label);
+    write_call_rel32(compiler, namedLabel(compiler, function->name));
 
     size_t paramsCount = function->paramsCount;
     if (stdFunction != INVALID_KEYWORD && getStdFunctionInfo(stdFunction)->additionalParamNeeded)
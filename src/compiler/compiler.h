@@ -5,56 +5,79 @@
 #include <stdio.h>
 #include "label_manager.h"
 #include "elf_builder.h"
+#include "listing_writer.h"
+#include "debug_info.h"
+#include "function_cache.h"
 #include "../symbol_table/symbol_table.h"
 #include "../parser/expression_tree.h"
       
 #define ASSERT_COMPILER(compiler) assert(compiler);        \
                                   assert(compiler->table); \
-                                  assert(compiler->tree);  \
+                                  assert(compiler->tree.types); \
  
 enum CompilerError
 {
     COMPILER_NO_ERROR,
     COMPILER_ERROR_NO_MAIN_FUNCTION,
     COMPILER_ERROR_CALL_UNDEFINED_FUNCTION,
-    COMPILER_ERROR_NO_STDIO_BYTECODE,
-    COMPILER_ERROR_NO_STDIO_NASM_CODE,
 
     COMPILER_ERRORS_COUNT
 };
 
+static const size_t PARALLEL_COMPILING_MIN_CHUNK_NODES = 16 * 1024;
+static const size_t PARALLEL_COMPILING_MAX_THREADS     = 64;
+
+/* Rewriting the cache's pack costs about as much as compiling a fifth of its
+ * functions, so it's rewritten once at least this part of them is missed. */
+static const size_t CACHE_PACK_REWRITE_MISSES_PART     = 8;
+
 static const char* COMPILER_ERROR_STRINGS[COMPILER_ERRORS_COUNT] = 
 {
     "no error",
     "main function ('love') wasn't found",
-    "calling undefined function",
-    "couldn't find one of the bytecode files with standard I/O functions",
-    "couldn't find one of the nasm files with standard I/O functions"
+    "calling undefined function"
 };
 
-static const uint8_t COMPILER_FIRST_PASS        = 0;
-static const uint8_t COMPILER_TOTAL_PASSES_NASM = 1;
-static const uint8_t COMPILER_TOTAL_PASSES_ELF  = 2;
-
 struct Compiler
 {
     SymbolTable*  table;
-    Node*         tree;
+    CompactTree   tree;
     Function*     curFunction;
-    uint8_t       passNumber;
     LabelManager  labelManager;
+    LabelId       firstStringLabel; // strings' labels go in the order of their ids
+    Label         returnLabel;      // of the current function
     ElfBuilder    builder;
+    bool          isSizeOptimized;  // short jumps and immediates, see relaxBranches()
+    size_t        threadsCount;     // compiling the functions, see compileParallel()
 
     bool          isNasmNeeded;
-    FILE*         nasmFile;
+    ListingWriter listing;
+
+    bool          isDebugInfoNeeded;
+    DebugInfo     debugInfo;
+
+    bool          isCacheUsed;
+    FunctionCache cache;            // of the compiled functions, see compileCached()
+    const char*   cachedProgram;    // whose functions the cache keeps
 
     CompilerError status;
+    FILE*         errorsFile;       // compileError() reports to, stdout by default
+
+    /* Program whose part this compiler is (see constructPart()) or nullptr. */
+    const Compiler* program;
 };
 
 void          construct     (Compiler* compiler, Node* tree, SymbolTable* table);
+void          constructPart (Compiler* compiler, const Compiler* program, size_t initialSize);
 void          destroy       (Compiler* compiler);
+void          mergePart     (Compiler* compiler, const Compiler* part);
 void          addElfFile    (Compiler* compiler, FILE* elfFile);
 void          addNasmFile   (Compiler* compiler, FILE* nasmFile);
+void          optimizeSize  (Compiler* compiler);
+void          addDebugInfo  (Compiler* compiler, const char* sourceName);
+void          useThreads    (Compiler* compiler, size_t threadsCount);
+void          useCache      (Compiler* compiler, const char* directory, const char* programName);
+void          setErrorsFile (Compiler* compiler, FILE* errorsFile);
 const char*   errorString   (CompilerError error);
 CompilerError compile       (Compiler* compiler);
 
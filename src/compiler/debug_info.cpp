@@ -0,0 +1,542 @@
+#include <assert.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "debug_info.h"
+
+//==================================DWARF codes=================================
+const uint16_t DWARF_VERSION             = 3;
+const uint8_t  DWARF_ADDRESS_SIZE        = 8;
+const char*    DWARF_PRODUCER            = "potter-tongue x86-64 compiler";
+
+const uint8_t  DW_TAG_compile_unit       = 0x11;
+const uint8_t  DW_CHILDREN_no            = 0x00;
+const uint8_t  DW_AT_name                = 0x03;
+const uint8_t  DW_AT_stmt_list           = 0x10;
+const uint8_t  DW_AT_low_pc              = 0x11;
+const uint8_t  DW_AT_high_pc             = 0x12;
+const uint8_t  DW_AT_comp_dir            = 0x1b;
+const uint8_t  DW_AT_producer            = 0x25;
+const uint8_t  DW_FORM_addr              = 0x01;
+const uint8_t  DW_FORM_data4             = 0x06;
+const uint8_t  DW_FORM_string            = 0x08;
+
+const uint8_t  DW_LNS_copy               = 0x01;
+const uint8_t  DW_LNS_advance_pc         = 0x02;
+const uint8_t  DW_LNS_advance_line       = 0x03;
+const uint8_t  DW_LNE_end_sequence       = 0x01;
+const uint8_t  DW_LNE_set_address        = 0x02;
+
+/* Line program's special opcodes encode both line's and address' advances. */
+const int8_t   LINE_BASE                 = -5;
+const uint8_t  LINE_RANGE                = 14;
+const uint8_t  OPCODE_BASE               = 13;
+const uint8_t  STANDARD_OPCODE_LENGTHS[] = {0, 1, 1, 1, 1, 0, 0, 0, 1, 0, 0, 1};
+
+const uint32_t DW_CIE_ID                 = 0xffffffff;
+const uint8_t  DW_CIE_VERSION            = 1;
+const uint8_t  DW_CFA_nop                = 0x00;
+const uint8_t  DW_CFA_advance_loc        = 0x40; /* | delta    */
+const uint8_t  DW_CFA_offset             = 0x80; /* | register */
+const uint8_t  DW_CFA_restore            = 0xc0; /* | register */
+const uint8_t  DW_CFA_advance_loc4       = 0x04;
+const uint8_t  DW_CFA_def_cfa            = 0x0c;
+const uint8_t  DW_CFA_def_cfa_register   = 0x0d;
+const uint8_t  DW_CFA_def_cfa_offset     = 0x0e;
+
+/* DWARF numbers of the x86-64 registers. */
+const uint8_t  DWARF_RBP                 = 6;
+const uint8_t  DWARF_RSP                 = 7;
+const uint8_t  DWARF_RETURN_ADDRESS      = 16;
+//==================================DWARF codes=================================
+
+/* Sizes of the frame's instructions (see FunctionFrame). */
+const uint8_t  PUSH_RBP_SIZE             = 1;
+const uint8_t  MOV_RBP_RSP_SIZE          = 3;
+const uint8_t  MOV_RSP_RBP_SIZE          = 3;
+const uint8_t  POP_RBP_SIZE              = 1;
+const uint8_t  RET_SIZE                  = 1;
+
+void appendBytes    (DebugSection* section, const void* bytes, size_t size);
+void appendByte     (DebugSection* section, uint8_t byte);
+void appendUInt16   (DebugSection* section, uint16_t word);
+void appendUInt32   (DebugSection* section, uint32_t doubleWord);
+void appendUInt64   (DebugSection* section, uint64_t quadWord);
+void appendString   (DebugSection* section, const char* string);
+void appendULEB128  (DebugSection* section, uint64_t value);
+void appendSLEB128  (DebugSection* section, int64_t value);
+void patchUInt32    (DebugSection* section, size_t offset, uint32_t doubleWord);
+void alignWithNops  (DebugSection* section, size_t start, size_t alignment);
+
+void writeAbbrev    (DebugInfo* debugInfo);
+void writeInfo      (DebugInfo* debugInfo, uint64_t textStart, uint64_t textEnd);
+void writeLines     (DebugInfo* debugInfo, uint64_t textEnd);
+void writeLineRow   (DebugSection* section, uint64_t addressAdvance, int64_t lineAdvance);
+void writeFrames    (DebugInfo* debugInfo, const LabelManager* labelManager);
+
+void construct(DebugInfo* debugInfo, const char* sourceName)
+{
+    assert(debugInfo);
+    assert(sourceName);
+
+    debugInfo->sourceName     = sourceName;
+
+    debugInfo->rows           = (LineRow*) calloc(DEBUG_INFO_INITIAL_CAPACITY, sizeof(LineRow));
+    debugInfo->rowsCount      = 0;
+    debugInfo->rowsCapacity   = DEBUG_INFO_INITIAL_CAPACITY;
+    assert(debugInfo->rows);
+
+    debugInfo->frames         = (FunctionFrame*) calloc(DEBUG_INFO_INITIAL_CAPACITY, sizeof(FunctionFrame));
+    debugInfo->framesCount    = 0;
+    debugInfo->framesCapacity = DEBUG_INFO_INITIAL_CAPACITY;
+    assert(debugInfo->frames);
+
+    for (size_t section = 0; section < SECTIONS_COUNT; section++)
+    {
+        debugInfo->sections[section] = {};
+    }
+}
+
+void destroy(DebugInfo* debugInfo)
+{
+    assert(debugInfo);
+
+    free(debugInfo->rows);
+    free(debugInfo->frames);
+
+    for (size_t section = 0; section < SECTIONS_COUNT; section++)
+    {
+        free(debugInfo->sections[section].bytes);
+    }
+
+    *debugInfo = {};
+}
+
+//------------------------------------------------------------------------------
+//! Rows have to be added in the order of their offsets. A row at the same
+//! offset as the previous one replaces it (e.g. an empty statement's row).
+//------------------------------------------------------------------------------
+void addLineRow(DebugInfo* debugInfo, uint64_t offset, uint32_t line)
+{
+    assert(debugInfo);
+    assert(debugInfo->rows);
+
+    if (line == 0) { return; }
+
+    if (debugInfo->rowsCount > 0)
+    {
+        LineRow* last = &debugInfo->rows[debugInfo->rowsCount - 1];
+        assert(last->offset <= offset);
+
+        if (last->offset == offset)
+        {
+            last->line = line;
+            return;
+        }
+
+        if (last->line == line) { return; }
+    }
+
+    if (debugInfo->rowsCount == debugInfo->rowsCapacity)
+    {
+        debugInfo->rowsCapacity *= 2;
+        debugInfo->rows          = (LineRow*) realloc(debugInfo->rows,
+                                                      debugInfo->rowsCapacity * sizeof(LineRow));
+        assert(debugInfo->rows);
+    }
+
+    debugInfo->rows[debugInfo->rowsCount++] = {offset, line};
+}
+
+void addFunctionFrame(DebugInfo* debugInfo, FunctionFrame frame)
+{
+    assert(debugInfo);
+    assert(debugInfo->frames);
+
+    if (debugInfo->framesCount == debugInfo->framesCapacity)
+    {
+        debugInfo->framesCapacity *= 2;
+        debugInfo->frames          = (FunctionFrame*) realloc(debugInfo->frames,
+                                                              debugInfo->framesCapacity * sizeof(FunctionFrame));
+        assert(debugInfo->frames);
+    }
+
+    debugInfo->frames[debugInfo->framesCount++] = frame;
+}
+
+//------------------------------------------------------------------------------
+//! Appends the rows and frames of a part of the program, whose code is placed
+//! at the offset and whose labels are merged with the shift (see mergePart() 
+//! of LabelManager).
+//------------------------------------------------------------------------------
+void mergePart(DebugInfo* debugInfo, const DebugInfo* part, uint64_t offset, 
+               const LabelManager* partLabels, LabelId shift)
+{
+    assert(debugInfo);
+    assert(part);
+    assert(partLabels);
+
+    for (size_t i = 0; i < part->rowsCount; i++)
+    {
+        addLineRow(debugInfo, part->rows[i].offset + offset, part->rows[i].line);
+    }
+
+    for (size_t i = 0; i < part->framesCount; i++)
+    {
+        FunctionFrame frame = part->frames[i];
+
+        addFunctionFrame(debugInfo, {mergedLabelId(partLabels, frame.start,       shift), 
+                                     mergedLabelId(partLabels, frame.returnLabel, shift)});
+    }
+}
+
+//------------------------------------------------------------------------------
+//! Makes the debug sections and hands them to the builder. Has to be called
+//! once the text is ended and the labels' offsets are final.
+//------------------------------------------------------------------------------
+void writeDebugSections(DebugInfo* debugInfo, ElfBuilder* builder, const LabelManager* labelManager)
+{
+    assert(debugInfo);
+    assert(builder);
+    assert(labelManager);
+
+    const Elf64_Phdr* textHeader = &builder->elfFile.textHeader;
+    uint64_t          textStart  = textHeader->p_offset;
+    uint64_t          textEnd    = textHeader->p_offset + textHeader->p_filesz;
+
+    writeAbbrev (debugInfo);
+    writeInfo   (debugInfo, textStart, textEnd);
+    writeLines  (debugInfo, textEnd);
+    writeFrames (debugInfo, labelManager);
+
+    for (size_t section = FIRST_DEBUG_SECTION; section < SECTIONS_COUNT; section++)
+    {
+        setDebugSection(builder, (ElfSection) section,
+                        debugInfo->sections[section].bytes,
+                        debugInfo->sections[section].size);
+    }
+}
+
+//==================================Sections====================================
+void writeAbbrev(DebugInfo* debugInfo)
+{
+    assert(debugInfo);
+
+    DebugSection* abbrev = &debugInfo->sections[SECTION_DEBUG_ABBREV];
+
+    appendULEB128 (abbrev, 1); /* abbreviation's code */
+    appendULEB128 (abbrev, DW_TAG_compile_unit);
+    appendByte    (abbrev, DW_CHILDREN_no);
+
+    const uint8_t attributes[][2] = {{DW_AT_name,      DW_FORM_string},
+                                     {DW_AT_comp_dir,  DW_FORM_string},
+                                     {DW_AT_producer,  DW_FORM_string},
+                                     {DW_AT_stmt_list, DW_FORM_data4 },
+                                     {DW_AT_low_pc,    DW_FORM_addr  },
+                                     {DW_AT_high_pc,   DW_FORM_addr  }};
+
+    for (size_t i = 0; i < sizeof(attributes) / sizeof(attributes[0]); i++)
+    {
+        appendULEB128(abbrev, attributes[i][0]);
+        appendULEB128(abbrev, attributes[i][1]);
+    }
+
+    appendULEB128 (abbrev, 0);
+    appendULEB128 (abbrev, 0);
+    appendULEB128 (abbrev, 0); /* end of the abbreviations */
+}
+
+void writeInfo(DebugInfo* debugInfo, uint64_t textStart, uint64_t textEnd)
+{
+    assert(debugInfo);
+
+    DebugSection* info = &debugInfo->sections[SECTION_DEBUG_INFO];
+
+    char compilationDir[PATH_MAX] = ".";
+    if (getcwd(compilationDir, sizeof(compilationDir)) == nullptr)
+    {
+        strcpy(compilationDir, ".");
+    }
+
+    size_t unitStart = info->size;
+    appendUInt32  (info, 0); /* unit's length, patched below */
+    appendUInt16  (info, DWARF_VERSION);
+    appendUInt32  (info, 0); /* offset of the abbreviations */
+    appendByte    (info, DWARF_ADDRESS_SIZE);
+
+    appendULEB128 (info, 1);
+    appendString  (info, debugInfo->sourceName);
+    appendString  (info, compilationDir);
+    appendString  (info, DWARF_PRODUCER);
+    appendUInt32  (info, 0); /* offset of the line table */
+    appendUInt64  (info, textStart + VIRTUAL_ADDRESS_START);
+    appendUInt64  (info, textEnd   + VIRTUAL_ADDRESS_START);
+
+    patchUInt32(info, unitStart, (uint32_t) (info->size - unitStart - sizeof(uint32_t)));
+}
+
+void writeLines(DebugInfo* debugInfo, uint64_t textEnd)
+{
+    assert(debugInfo);
+
+    DebugSection* lines = &debugInfo->sections[SECTION_DEBUG_LINE];
+
+    size_t unitStart = lines->size;
+    appendUInt32  (lines, 0); /* unit's length, patched below */
+    appendUInt16  (lines, DWARF_VERSION);
+
+    size_t headerLengthOffset = lines->size;
+    appendUInt32  (lines, 0); /* header's length, patched below */
+
+    size_t headerStart = lines->size;
+    appendByte    (lines, 1); /* minimum instruction length */
+    appendByte    (lines, 1); /* rows are statements' beginnings by default */
+    appendByte    (lines, (uint8_t) LINE_BASE);
+    appendByte    (lines, LINE_RANGE);
+    appendByte    (lines, OPCODE_BASE);
+    appendBytes   (lines, STANDARD_OPCODE_LENGTHS, sizeof(STANDARD_OPCODE_LENGTHS));
+
+    appendByte    (lines, 0); /* no include directories */
+
+    appendString  (lines, debugInfo->sourceName);
+    appendULEB128 (lines, 0); /* the compilation directory */
+    appendULEB128 (lines, 0); /* modification time */
+    appendULEB128 (lines, 0); /* file's length */
+    appendByte    (lines, 0); /* end of the files */
+
+    patchUInt32(lines, headerLengthOffset, (uint32_t) (lines->size - headerStart));
+
+    if (debugInfo->rowsCount > 0)
+    {
+        uint64_t address = debugInfo->rows[0].offset;
+        int64_t  line    = 1;
+
+        appendByte    (lines, 0); /* extended opcode */
+        appendULEB128 (lines, 1 + sizeof(uint64_t));
+        appendByte    (lines, DW_LNE_set_address);
+        appendUInt64  (lines, address + VIRTUAL_ADDRESS_START);
+
+        for (size_t i = 0; i < debugInfo->rowsCount; i++)
+        {
+            LineRow row = debugInfo->rows[i];
+            writeLineRow(lines, row.offset - address, (int64_t) row.line - line);
+
+            address = row.offset;
+            line    = row.line;
+        }
+
+        appendByte    (lines, DW_LNS_advance_pc);
+        appendULEB128 (lines, textEnd - address);
+
+        appendByte    (lines, 0); /* extended opcode */
+        appendULEB128 (lines, 1);
+        appendByte    (lines, DW_LNE_end_sequence);
+    }
+
+    patchUInt32(lines, unitStart, (uint32_t) (lines->size - unitStart - sizeof(uint32_t)));
+}
+
+void writeLineRow(DebugSection* section, uint64_t addressAdvance, int64_t lineAdvance)
+{
+    assert(section);
+
+    if (LINE_BASE <= lineAdvance && lineAdvance < LINE_BASE + LINE_RANGE)
+    {
+        uint64_t opcode = (uint64_t) (lineAdvance - LINE_BASE) + LINE_RANGE * addressAdvance + OPCODE_BASE;
+
+        if (opcode <= UINT8_MAX)
+        {
+            appendByte(section, (uint8_t) opcode);
+            return;
+        }
+    }
+
+    if (lineAdvance != 0)
+    {
+        appendByte    (section, DW_LNS_advance_line);
+        appendSLEB128 (section, lineAdvance);
+    }
+
+    if (addressAdvance != 0)
+    {
+        appendByte    (section, DW_LNS_advance_pc);
+        appendULEB128 (section, addressAdvance);
+    }
+
+    appendByte(section, DW_LNS_copy);
+}
+
+//------------------------------------------------------------------------------
+//! Describes the frames as follows:
+//!
+//!     push rbp        ; cfa = rsp + 8,  return address at cfa - 8
+//!     mov  rbp, rsp   ; cfa = rsp + 16, rbp at cfa - 16
+//!     ...             ; cfa = rbp + 16
+//!     mov  rsp, rbp
+//!     pop  rbp
+//!     ret             ; cfa = rsp + 8, rbp is restored
+//------------------------------------------------------------------------------
+void writeFrames(DebugInfo* debugInfo, const LabelManager* labelManager)
+{
+    assert(debugInfo);
+    assert(labelManager);
+
+    DebugSection* frames = &debugInfo->sections[SECTION_DEBUG_FRAME];
+
+    size_t cieStart = frames->size;
+    appendUInt32  (frames, 0); /* entry's length, patched below */
+    appendUInt32  (frames, DW_CIE_ID);
+    appendByte    (frames, DW_CIE_VERSION);
+    appendString  (frames, ""); /* no augmentation */
+    appendULEB128 (frames, 1);  /* code alignment */
+    appendSLEB128 (frames, -8); /* data alignment */
+    appendByte    (frames, DWARF_RETURN_ADDRESS);
+
+    appendByte    (frames, DW_CFA_def_cfa);
+    appendULEB128 (frames, DWARF_RSP);
+    appendULEB128 (frames, 8);
+    appendByte    (frames, DW_CFA_offset | DWARF_RETURN_ADDRESS);
+    appendULEB128 (frames, 1);
+
+    alignWithNops(frames, cieStart, DWARF_ADDRESS_SIZE);
+    patchUInt32(frames, cieStart, (uint32_t) (frames->size - cieStart - sizeof(uint32_t)));
+
+    for (size_t i = 0; i < debugInfo->framesCount; i++)
+    {
+        FunctionFrame frame       = debugInfo->frames[i];
+        uint64_t      start       = (uint64_t) getLabelOffset(labelManager, frame.start);
+        uint64_t      epilogue    = (uint64_t) getLabelOffset(labelManager, frame.returnLabel);
+        uint64_t      afterPop    = epilogue + MOV_RSP_RBP_SIZE + POP_RBP_SIZE;
+        uint64_t      afterFrame  = start + PUSH_RBP_SIZE + MOV_RBP_RSP_SIZE;
+
+        assert(afterFrame <= afterPop);
+
+        size_t fdeStart = frames->size;
+        appendUInt32  (frames, 0); /* entry's length, patched below */
+        appendUInt32  (frames, (uint32_t) cieStart);
+        appendUInt64  (frames, start + VIRTUAL_ADDRESS_START);
+        appendUInt64  (frames, afterPop + RET_SIZE - start);
+
+        appendByte    (frames, DW_CFA_advance_loc | PUSH_RBP_SIZE);
+        appendByte    (frames, DW_CFA_def_cfa_offset);
+        appendULEB128 (frames, 16);
+        appendByte    (frames, DW_CFA_offset | DWARF_RBP);
+        appendULEB128 (frames, 2);
+
+        appendByte    (frames, DW_CFA_advance_loc | MOV_RBP_RSP_SIZE);
+        appendByte    (frames, DW_CFA_def_cfa_register);
+        appendULEB128 (frames, DWARF_RBP);
+
+        appendByte    (frames, DW_CFA_advance_loc4);
+        appendUInt32  (frames, (uint32_t) (afterPop - afterFrame));
+        appendByte    (frames, DW_CFA_def_cfa);
+        appendULEB128 (frames, DWARF_RSP);
+        appendULEB128 (frames, 8);
+        appendByte    (frames, DW_CFA_restore | DWARF_RBP);
+
+        alignWithNops(frames, fdeStart, DWARF_ADDRESS_SIZE);
+        patchUInt32(frames, fdeStart, (uint32_t) (frames->size - fdeStart - sizeof(uint32_t)));
+    }
+}
+//==================================Sections====================================
+
+
+//==================================Appending===================================
+void appendBytes(DebugSection* section, const void* bytes, size_t size)
+{
+    assert(section);
+    assert(bytes);
+
+    if (section->size + size > section->capacity)
+    {
+        size_t newCapacity = section->capacity > 0 ? section->capacity : DEBUG_INFO_INITIAL_CAPACITY;
+        while (section->size + size > newCapacity) { newCapacity *= 2; }
+
+        section->bytes = (uint8_t*) realloc(section->bytes, newCapacity);
+        assert(section->bytes);
+
+        section->capacity = newCapacity;
+    }
+
+    memcpy(section->bytes + section->size, bytes, size);
+    section->size += size;
+}
+
+void appendByte(DebugSection* section, uint8_t byte)
+{
+    appendBytes(section, &byte, sizeof(byte));
+}
+
+void appendUInt16(DebugSection* section, uint16_t word)
+{
+    appendBytes(section, &word, sizeof(word));
+}
+
+void appendUInt32(DebugSection* section, uint32_t doubleWord)
+{
+    appendBytes(section, &doubleWord, sizeof(doubleWord));
+}
+
+void appendUInt64(DebugSection* section, uint64_t quadWord)
+{
+    appendBytes(section, &quadWord, sizeof(quadWord));
+}
+
+void appendString(DebugSection* section, const char* string)
+{
+    assert(string);
+    appendBytes(section, string, strlen(string) + 1);
+}
+
+void appendULEB128(DebugSection* section, uint64_t value)
+{
+    do
+    {
+        uint8_t byte = value & 0x7f;
+        value >>= 7;
+
+        if (value != 0) { byte |= 0x80; }
+        appendByte(section, byte);
+    } while (value != 0);
+}
+
+void appendSLEB128(DebugSection* section, int64_t value)
+{
+    bool isLast = false;
+
+    while (!isLast)
+    {
+        uint8_t byte = value & 0x7f;
+        value >>= 7; /* arithmetic shift */
+
+        isLast = (value == 0  && (byte & 0x40) == 0) ||
+                 (value == -1 && (byte & 0x40) != 0);
+
+        if (!isLast) { byte |= 0x80; }
+        appendByte(section, byte);
+    }
+}
+
+void patchUInt32(DebugSection* section, size_t offset, uint32_t doubleWord)
+{
+    assert(section);
+    assert(offset + sizeof(doubleWord) <= section->size);
+
+    memcpy(section->bytes + offset, &doubleWord, sizeof(doubleWord));
+}
+
+//------------------------------------------------------------------------------
+//! Pads the entry, which starts at start and whose length field isn't counted
+//! in its length, so that the length is a multiple of alignment.
+//------------------------------------------------------------------------------
+void alignWithNops(DebugSection* section, size_t start, size_t alignment)
+{
+    assert(section);
+
+    while ((section->size - start - sizeof(uint32_t)) % alignment != 0)
+    {
+        appendByte(section, DW_CFA_nop);
+    }
+}
+//==================================Appending===================================
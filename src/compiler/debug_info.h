@@ -0,0 +1,67 @@
+#ifndef DEBUG_INFO_H
+#define DEBUG_INFO_H
+
+#include <stdint.h>
+#include "label_manager.h"
+#include "elf_builder.h"
+
+static const size_t DEBUG_INFO_INITIAL_CAPACITY = 256;
+
+//------------------------------------------------------------------------------
+//! The code from the offset on (up to the next row) is compiled from the line.
+//------------------------------------------------------------------------------
+struct LineRow
+{
+    uint64_t offset; /* in the binary file */
+    uint32_t line;   /* counting from 1 */
+};
+
+//------------------------------------------------------------------------------
+//! Function compiled by compileFunction(), which starts with
+//! "push rbp / mov rbp, rsp" and ends with "mov rsp, rbp / pop rbp / ret"
+//! right after its return label.
+//------------------------------------------------------------------------------
+struct FunctionFrame
+{
+    LabelId start;
+    LabelId returnLabel;
+};
+
+struct DebugSection
+{
+    uint8_t* bytes;
+    size_t   size;
+    size_t   capacity;
+};
+
+//------------------------------------------------------------------------------
+//! Gathers the source lines and frames of the compiled code and turns them
+//! into DWARF sections (.debug_line, .debug_frame and the compilation unit
+//! in .debug_info and .debug_abbrev, which tools find the line table by).
+//------------------------------------------------------------------------------
+struct DebugInfo
+{
+    const char*    sourceName;
+
+    /* In the order of the offsets. */
+    LineRow*       rows;
+    size_t         rowsCount;
+    size_t         rowsCapacity;
+
+    FunctionFrame* frames;
+    size_t         framesCount;
+    size_t         framesCapacity;
+
+    /* Only the debug sections are used. */
+    DebugSection   sections[SECTIONS_COUNT];
+};
+
+void construct          (DebugInfo* debugInfo, const char* sourceName);
+void destroy            (DebugInfo* debugInfo);
+void addLineRow         (DebugInfo* debugInfo, uint64_t offset, uint32_t line);
+void addFunctionFrame   (DebugInfo* debugInfo, FunctionFrame frame);
+void mergePart          (DebugInfo* debugInfo, const DebugInfo* part, uint64_t offset, 
+                         const LabelManager* partLabels, LabelId shift);
+void writeDebugSections (DebugInfo* debugInfo, ElfBuilder* builder, const LabelManager* labelManager);
+
+#endif
@@ -1,5 +1,7 @@
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
 #include "elf_builder.h"
 
 const double   BYTECODE_REALLOC_MULTIPLIER = 1.6;
@@ -8,20 +10,60 @@ const uint64_t SEGMENT_ALIGNMENT_SIZE      = 0x1000;
 void makeNeededSpace(ElfBuilder* builder, size_t bytesNeeded);
 void startNewSegment(ElfBuilder* builder);
 
+ElfSection symbolSection     (const ElfFile* elfFile, uint64_t offset);
+void       setSymbolsSizes   (ElfBuilder* builder);
+void       alignBuilder      (ElfBuilder* builder, size_t alignment);
+void       writeSymbols      (ElfBuilder* builder, uint8_t binding);
+Elf64_Shdr segmentSection    (const Elf64_Phdr* segment, uint32_t type, uint64_t flags);
+
 void makeNeededSpace(ElfBuilder* builder, size_t bytesNeeded)
 {
     ASSERT_ELF_BUILDER(builder);
 
-    while (builder->offset + bytesNeeded >= builder->elfFile.bytecodeCapacity)
+    if (builder->offset + bytesNeeded >= builder->elfFile.bytecodeCapacity)
     {
-        builder->elfFile.bytecodeCapacity *= BYTECODE_REALLOC_MULTIPLIER;
+        growBytecode(builder, bytesNeeded);
+    }
+}
 
-        uint8_t* newBuffer = (uint8_t*) realloc(builder->elfFile.bytecode, 
-                                                builder->elfFile.bytecodeCapacity);
+//------------------------------------------------------------------------------
+//! Reallocates the bytecode at once to the size that fits bytesNeeded more 
+//! bytes. The new bytes are zeroed (the mapped bytecode is grown together with
+//! the file, which zeroes them too).
+//------------------------------------------------------------------------------
+void growBytecode(ElfBuilder* builder, size_t bytesNeeded)
+{
+    ASSERT_ELF_BUILDER(builder);
+
+    ElfFile* elfFile     = &builder->elfFile;
+    size_t   oldCapacity = elfFile->bytecodeCapacity;
+    size_t   newCapacity = (size_t) (oldCapacity * BYTECODE_REALLOC_MULTIPLIER);
+
+    if (newCapacity <= builder->offset + bytesNeeded)
+    {
+        newCapacity = builder->offset + bytesNeeded + 1;
+    }
+
+    uint8_t* newBuffer = nullptr;
+    if (elfFile->isMapped)
+    {
+        int ftruncateResult = ftruncate(fileno(elfFile->file), (off_t) newCapacity);
+        assert(ftruncateResult == 0);
+
+        newBuffer = (uint8_t*) mremap(elfFile->bytecode, oldCapacity, newCapacity, MREMAP_MAYMOVE);
+        assert(newBuffer != MAP_FAILED);
+    }
+    else
+    {
+        newBuffer = (uint8_t*) realloc(elfFile->bytecode, newCapacity);
         assert(newBuffer);
 
-        builder->elfFile.bytecode = newBuffer;
+        /* Gaps between the segments are left as they are. */
+        memset(newBuffer + oldCapacity, 0, newCapacity - oldCapacity);
     }
+
+    elfFile->bytecode         = newBuffer;
+    elfFile->bytecodeCapacity = newCapacity;
 }
 
 void construct(ElfBuilder* builder, FILE* file, size_t initialSize)
@@ -35,6 +77,7 @@ void construct(ElfBuilder* builder, FILE* file, size_t initialSize)
     assert(builder->elfFile.bytecode);
 
     builder->elfFile.bytecodeCapacity = initialSize;
+    builder->elfFile.isMapped         = false;
     builder->elfFile.elfHeader        = DEFAULT_ELF_HEADER;
 
     builder->elfFile.textHeader          = DEFAULT_SEGMENT_HEADER;
@@ -50,6 +93,42 @@ void construct(ElfBuilder* builder, FILE* file, size_t initialSize)
 
     makeNeededSpace(builder, FIRST_SEGMENT_OFFSET + 1);
     setBuilderToStart(builder);
+
+    builder->symbols         = (Elf64_Sym*) calloc(ELF_SYMBOLS_INITIAL_CAPACITY, sizeof(Elf64_Sym));
+    builder->symbolsCount    = 0;
+    builder->symbolsCapacity = ELF_SYMBOLS_INITIAL_CAPACITY;
+    assert(builder->symbols);
+
+    /* The first name is the empty one, which is used by the null symbol. */
+    builder->symbolNames         = (char*) calloc(ELF_SYMBOLS_INITIAL_CAPACITY, sizeof(char));
+    builder->symbolNamesSize     = 1;
+    builder->symbolNamesCapacity = ELF_SYMBOLS_INITIAL_CAPACITY;
+    assert(builder->symbolNames);
+
+    for (size_t section = 0; section < SECTIONS_COUNT; section++)
+    {
+        builder->debugSections     [section] = nullptr;
+        builder->debugSectionsSizes[section] = 0;
+    }
+}
+
+//------------------------------------------------------------------------------
+//! Makes the builder of a part of the text, which is compiled separately and 
+//! copied into the program's builder (see writeBytes()). Its offsets start from
+//! 0 and it has neither headers nor symbols.
+//------------------------------------------------------------------------------
+void constructPart(ElfBuilder* builder, size_t initialSize)
+{
+    assert(builder);
+    assert(initialSize > 0);
+
+    *builder = {};
+
+    builder->elfFile.bytecode = (uint8_t*) calloc(initialSize, sizeof(uint8_t));
+    assert(builder->elfFile.bytecode);
+
+    builder->elfFile.bytecodeCapacity = initialSize;
+    builder->offset                   = 0;
 }
 
 void destroy(ElfBuilder* builder)
@@ -57,13 +136,59 @@ void destroy(ElfBuilder* builder)
     ASSERT_ELF_BUILDER(builder);
 
     builder->elfFile.file = nullptr;
-    if (builder->elfFile.bytecode != nullptr)
+    if (builder->elfFile.isMapped)
+    {
+        munmap(builder->elfFile.bytecode, builder->elfFile.bytecodeCapacity);
+    }
+    else if (builder->elfFile.bytecode != nullptr)
     {
         free(builder->elfFile.bytecode);
     }
 
     builder->elfFile.bytecode         = nullptr;
     builder->elfFile.bytecodeCapacity = 0;
+    builder->elfFile.isMapped         = false;
+
+    free(builder->symbols);
+    free(builder->symbolNames);
+
+    builder->symbols     = nullptr;
+    builder->symbolNames = nullptr;
+}
+
+//------------------------------------------------------------------------------
+//! Makes the builder write straight into the output file, which is resized to 
+//! the current capacity and mapped to memory. The file has to be opened for 
+//! both reading and writing.
+//!
+//! @return Whether the file was mapped. If it wasn't (e.g. it's a pipe), the 
+//!         builder keeps the bytecode in memory and writes it in writeElfFile().
+//------------------------------------------------------------------------------
+bool mapOutputFile(ElfBuilder* builder)
+{
+    ASSERT_ELF_BUILDER(builder);
+    assert(builder->elfFile.file);
+    assert(!builder->elfFile.isMapped);
+
+    ElfFile* elfFile = &builder->elfFile;
+    int      fd      = fileno(elfFile->file);
+
+    if (ftruncate(fd, (off_t) elfFile->bytecodeCapacity) != 0) { return false; }
+
+    void* map = mmap(nullptr, elfFile->bytecodeCapacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) 
+    { 
+        ftruncate(fd, 0);
+        return false; 
+    }
+
+    memcpy(map, elfFile->bytecode, builder->offset);
+    free(elfFile->bytecode);
+
+    elfFile->bytecode = (uint8_t*) map;
+    elfFile->isMapped = true;
+
+    return true;
 }
 
 void writeElfFile(ElfFile* elfFile, size_t size)
@@ -85,7 +210,16 @@ void writeElfFile(ElfFile* elfFile, size_t size)
     memcpy(elfFile->bytecode + offset, (const void*) &elfFile->dataHeader, sizeof(elfFile->dataHeader));
     offset += sizeof(elfFile->dataHeader);
 
-    fwrite(elfFile->bytecode, sizeof(uint8_t), size, elfFile->file);
+    if (elfFile->isMapped)
+    {
+        /* The bytecode past the size isn't used anymore. */
+        int ftruncateResult = ftruncate(fileno(elfFile->file), (off_t) size);
+        assert(ftruncateResult == 0);
+    }
+    else
+    {
+        fwrite(elfFile->bytecode, sizeof(uint8_t), size, elfFile->file);
+    }
 }
 
 void setBuilderToStart(ElfBuilder* builder)
@@ -145,10 +279,21 @@ void endTextSegment(ElfBuilder* builder)
     endCurSegment(builder, &builder->elfFile.textHeader);
 }
 
-void endBssSegment(ElfBuilder* builder)
+//------------------------------------------------------------------------------
+//! Ends the .bss segment, which takes size bytes of memory and none of the 
+//! file. The next segment starts on the next page, which leaves the memory 
+//! free for it.
+//------------------------------------------------------------------------------
+void endBssSegment(ElfBuilder* builder, size_t size)
 {
     ASSERT_ELF_BUILDER(builder);
-    endCurSegment(builder, &builder->elfFile.bssHeader);
+
+    Elf64_Phdr* bssHeader = &builder->elfFile.bssHeader;
+    assert(builder->offset == bssHeader->p_offset);
+    assert(size <= PAGE_SIZE);
+
+    bssHeader->p_filesz = 0;
+    bssHeader->p_memsz  = size;
 }
 
 void endDataSegment(ElfBuilder* builder)
@@ -169,23 +314,291 @@ void writeBytes(ElfBuilder* builder, const uint8_t* buffer, size_t size)
 void writeByte(ElfBuilder* builder, uint8_t byte)
 {
     ASSERT_ELF_BUILDER(builder);
-    writeBytes(builder, &byte, sizeof(byte));
+    commitBytes(builder, storeByte(reserveBytes(builder, sizeof(byte)), byte));
 }
 
 void writeUInt16(ElfBuilder* builder, uint16_t word)
 {
     ASSERT_ELF_BUILDER(builder);
-    writeBytes(builder, (uint8_t*) &word, sizeof(word));
+    commitBytes(builder, storeUInt16(reserveBytes(builder, sizeof(word)), word));
 }
 
 void writeUInt32(ElfBuilder* builder, uint32_t doubleWord)
 {
     ASSERT_ELF_BUILDER(builder);
-    writeBytes(builder, (uint8_t*) &doubleWord, sizeof(doubleWord));
+    commitBytes(builder, storeUInt32(reserveBytes(builder, sizeof(doubleWord)), doubleWord));
 }
 
 void writeUInt64(ElfBuilder* builder, uint64_t quadWord)
 {
     ASSERT_ELF_BUILDER(builder);
-    writeBytes(builder, (uint8_t*) &quadWord, sizeof(quadWord));
-}
\ No newline at end of file
+    commitBytes(builder, storeUInt64(reserveBytes(builder, sizeof(quadWord)), quadWord));
+}
+
+//------------------------------------------------------------------------------
+//! Overwrites already written bytes at offset (e.g. to resolve a fixup).
+//------------------------------------------------------------------------------
+void patchUInt32(ElfBuilder* builder, uint64_t offset, uint32_t doubleWord)
+{
+    ASSERT_ELF_BUILDER(builder);
+    assert(offset + sizeof(doubleWord) <= builder->offset);
+
+    memcpy(builder->elfFile.bytecode + offset, &doubleWord, sizeof(doubleWord));
+}
+
+void patchUInt64(ElfBuilder* builder, uint64_t offset, uint64_t quadWord)
+{
+    ASSERT_ELF_BUILDER(builder);
+    assert(offset + sizeof(quadWord) <= builder->offset);
+
+    memcpy(builder->elfFile.bytecode + offset, &quadWord, sizeof(quadWord));
+}
+//------------------------------------------------------------------------------
+//! Adds the symbol to .symtab. Symbols have to be added in the order of their
+//! offsets. Sizes of functions and objects are set by writeSections() as 
+//! distances to the next symbol of the same type.
+//!
+//! @param offset Symbol's offset in the file.
+//! @param type   STT_FUNC, STT_OBJECT or STT_NOTYPE.
+//! @param binding STB_LOCAL or STB_GLOBAL.
+//------------------------------------------------------------------------------
+void addSymbol(ElfBuilder* builder, const char* name, uint64_t offset, 
+               uint8_t type, uint8_t binding)
+{
+    ASSERT_ELF_BUILDER(builder);
+    assert(name);
+    assert(builder->symbolsCount == 0 || 
+           builder->symbols[builder->symbolsCount - 1].st_value <= offset);
+
+    if (builder->symbolsCount == builder->symbolsCapacity)
+    {
+        builder->symbolsCapacity *= 2;
+        builder->symbols          = (Elf64_Sym*) realloc(builder->symbols, 
+                                                         builder->symbolsCapacity * sizeof(Elf64_Sym));
+        assert(builder->symbols);
+    }
+
+    size_t nameSize = strlen(name) + 1;
+    if (builder->symbolNamesSize + nameSize > builder->symbolNamesCapacity)
+    {
+        while (builder->symbolNamesSize + nameSize > builder->symbolNamesCapacity)
+        {
+            builder->symbolNamesCapacity *= 2;
+        }
+
+        builder->symbolNames = (char*) realloc(builder->symbolNames, builder->symbolNamesCapacity);
+        assert(builder->symbolNames);
+    }
+
+    Elf64_Sym symbol = {};
+    symbol.st_name   = (Elf64_Word) builder->symbolNamesSize;
+    symbol.st_info   = ELF64_ST_INFO(binding, type);
+    symbol.st_value  = offset;
+
+    memcpy(builder->symbolNames + builder->symbolNamesSize, name, nameSize);
+    builder->symbolNamesSize += nameSize;
+
+    builder->symbols[builder->symbolsCount++] = symbol;
+}
+
+//------------------------------------------------------------------------------
+//! Sets the contents of one of the .debug_* sections, which are written by
+//! writeSections() if all of them are set. The bytes have to stay valid until
+//! then.
+//------------------------------------------------------------------------------
+void setDebugSection(ElfBuilder* builder, ElfSection section, const uint8_t* bytes, size_t size)
+{
+    ASSERT_ELF_BUILDER(builder);
+    assert(FIRST_DEBUG_SECTION <= section && section < SECTIONS_COUNT);
+    assert(bytes);
+
+    builder->debugSections     [section] = bytes;
+    builder->debugSectionsSizes[section] = size;
+}
+
+//------------------------------------------------------------------------------
+//! Appends .symtab, .strtab, the debug sections (if set) and the section 
+//! header table after the last segment. Has to be called once all the 
+//! segments are ended.
+//------------------------------------------------------------------------------
+void writeSections(ElfBuilder* builder)
+{
+    ASSERT_ELF_BUILDER(builder);
+
+    ElfFile*   elfFile                  = &builder->elfFile;
+    Elf64_Shdr sections[SECTIONS_COUNT] = {};
+
+    sections[SECTION_TEXT] = segmentSection(&elfFile->textHeader, SHT_PROGBITS, SHF_ALLOC | SHF_EXECINSTR);
+    sections[SECTION_BSS]  = segmentSection(&elfFile->bssHeader,  SHT_NOBITS,   SHF_ALLOC | SHF_WRITE);
+    sections[SECTION_DATA] = segmentSection(&elfFile->dataHeader, SHT_PROGBITS, SHF_ALLOC);
+
+    setSymbolsSizes(builder);
+
+    /* Local symbols have to go before the global ones. */
+    alignBuilder(builder, SECTION_TABLE_ALIGNMENT);
+    Elf64_Shdr* symtab = &sections[SECTION_SYMTAB];
+    symtab->sh_type      = SHT_SYMTAB;
+    symtab->sh_offset    = builder->offset;
+    symtab->sh_link      = SECTION_STRTAB;
+    symtab->sh_addralign = SECTION_TABLE_ALIGNMENT;
+    symtab->sh_entsize   = sizeof(Elf64_Sym);
+
+    Elf64_Sym nullSymbol = {};
+    writeBytes(builder, (const uint8_t*) &nullSymbol, sizeof(nullSymbol));
+    writeSymbols(builder, STB_LOCAL);
+    symtab->sh_info = (Elf64_Word) ((builder->offset - symtab->sh_offset) / sizeof(Elf64_Sym));
+    writeSymbols(builder, STB_GLOBAL);
+    symtab->sh_size = builder->offset - symtab->sh_offset;
+
+    Elf64_Shdr* strtab = &sections[SECTION_STRTAB];
+    strtab->sh_type      = SHT_STRTAB;
+    strtab->sh_offset    = builder->offset;
+    strtab->sh_size      = builder->symbolNamesSize;
+    strtab->sh_addralign = 1;
+    writeBytes(builder, (const uint8_t*) builder->symbolNames, builder->symbolNamesSize);
+
+    size_t sectionsCount = SECTIONS_COUNT;
+    for (size_t section = FIRST_DEBUG_SECTION; section < SECTIONS_COUNT; section++)
+    {
+        if (builder->debugSections[section] == nullptr) { sectionsCount = FIRST_DEBUG_SECTION; }
+    }
+
+    for (size_t section = FIRST_DEBUG_SECTION; section < sectionsCount; section++)
+    {
+        sections[section].sh_type      = SHT_PROGBITS;
+        sections[section].sh_offset    = builder->offset;
+        sections[section].sh_size      = builder->debugSectionsSizes[section];
+        sections[section].sh_addralign = 1;
+        writeBytes(builder, builder->debugSections[section], builder->debugSectionsSizes[section]);
+    }
+
+    Elf64_Shdr* shstrtab = &sections[SECTION_SHSTRTAB];
+    shstrtab->sh_type      = SHT_STRTAB;
+    shstrtab->sh_offset    = builder->offset;
+    shstrtab->sh_addralign = 1;
+    for (size_t i = 0; i < sectionsCount; i++)
+    {
+        sections[i].sh_name = (Elf64_Word) (builder->offset - shstrtab->sh_offset);
+        writeBytes(builder, (const uint8_t*) SECTION_NAMES[i], strlen(SECTION_NAMES[i]) + 1);
+    }
+    shstrtab->sh_size = builder->offset - shstrtab->sh_offset;
+
+    alignBuilder(builder, SECTION_TABLE_ALIGNMENT);
+    elfFile->elfHeader.e_shoff     = builder->offset;
+    elfFile->elfHeader.e_shentsize = sizeof(Elf64_Shdr);
+    elfFile->elfHeader.e_shnum     = (Elf64_Half) sectionsCount;
+    elfFile->elfHeader.e_shstrndx  = SECTION_SHSTRTAB;
+
+    writeBytes(builder, (const uint8_t*) sections, sectionsCount * sizeof(Elf64_Shdr));
+}
+
+Elf64_Shdr segmentSection(const Elf64_Phdr* segment, uint32_t type, uint64_t flags)
+{
+    assert(segment);
+
+    Elf64_Shdr section   = {};
+    section.sh_type      = type;
+    section.sh_flags     = flags;
+    section.sh_addr      = segment->p_vaddr;
+    section.sh_offset    = segment->p_offset;
+    section.sh_size      = segment->p_memsz;
+    section.sh_addralign = 1;
+
+    return section;
+}
+
+//------------------------------------------------------------------------------
+//! @return Section of the segment the offset is in. Symbols at the very end of
+//!         a segment are considered to be in it.
+//------------------------------------------------------------------------------
+ElfSection symbolSection(const ElfFile* elfFile, uint64_t offset)
+{
+    assert(elfFile);
+
+    const Elf64_Phdr* segments[]        = {&elfFile->textHeader, &elfFile->bssHeader, &elfFile->dataHeader};
+    const ElfSection  segmentSections[] = {SECTION_TEXT,         SECTION_BSS,        SECTION_DATA};
+
+    for (size_t i = 0; i < USED_SEGMENTS_COUNT; i++)
+    {
+        if (segments[i]->p_offset <= offset && offset <= segments[i]->p_offset + segments[i]->p_memsz)
+        {
+            return segmentSections[i];
+        }
+    }
+
+    assert(!"Symbol is in one of the segments");
+    return SECTION_NULL;
+}
+
+void setSymbolsSizes(ElfBuilder* builder)
+{
+    ASSERT_ELF_BUILDER(builder);
+
+    ElfFile* elfFile = &builder->elfFile;
+
+    /* Going backwards, so the next function and object are already known. */
+    uint64_t   nextFunction = 0;
+    uint64_t   nextObject   = 0;
+    ElfSection curSection   = SECTION_NULL;
+
+    for (size_t i = builder->symbolsCount; i-- > 0;)
+    {
+        Elf64_Sym* symbol  = &builder->symbols[i];
+        ElfSection section = symbolSection(elfFile, symbol->st_value);
+
+        symbol->st_shndx = (Elf64_Section) section;
+
+        if (section != curSection)
+        {
+            const Elf64_Phdr* segment = section == SECTION_TEXT ? &elfFile->textHeader :
+                                        section == SECTION_BSS  ? &elfFile->bssHeader  :
+                                                                  &elfFile->dataHeader;
+
+            nextFunction = segment->p_offset + segment->p_memsz;
+            nextObject   = nextFunction;
+            curSection   = section;
+        }
+
+        switch (ELF64_ST_TYPE(symbol->st_info))
+        {
+            case STT_FUNC:
+                symbol->st_size = nextFunction - symbol->st_value;
+                nextFunction    = symbol->st_value;
+                break;
+
+            case STT_OBJECT:
+                symbol->st_size = nextObject - symbol->st_value;
+                nextObject      = symbol->st_value;
+                break;
+
+            default:
+                break;
+        }
+
+        symbol->st_value += VIRTUAL_ADDRESS_START;
+    }
+}
+
+void alignBuilder(ElfBuilder* builder, size_t alignment)
+{
+    ASSERT_ELF_BUILDER(builder);
+
+    size_t padding = (alignment - builder->offset % alignment) % alignment;
+
+    makeNeededSpace(builder, padding);
+    memset(builder->elfFile.bytecode + builder->offset, 0, padding);
+    builder->offset += padding;
+}
+
+void writeSymbols(ElfBuilder* builder, uint8_t binding)
+{
+    ASSERT_ELF_BUILDER(builder);
+
+    for (size_t i = 0; i < builder->symbolsCount; i++)
+    {
+        if (ELF64_ST_BIND(builder->symbols[i].st_info) == binding)
+        {
+            writeBytes(builder, (const uint8_t*) &builder->symbols[i], sizeof(Elf64_Sym));
+        }
+    }
+}
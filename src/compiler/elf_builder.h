@@ -4,14 +4,14 @@
 #include <assert.h>
 #include <elf.h>
 #include <stdio.h>
+#include <string.h>
 
-#define ASSERT_ELF_BUILDER(builder) assert(builder->elfFile.file);                               \
-                                    assert(builder->elfFile.bytecode);                           \
+#define ASSERT_ELF_BUILDER(builder) assert(builder->elfFile.bytecode);                           \
                                     assert(builder->offset < builder->elfFile.bytecodeCapacity); 
 
 struct ElfFile
 {
-    FILE*      file;
+    FILE*      file;     /* nullptr for a part of the text, see constructPart() */
     Elf64_Ehdr elfHeader;
     Elf64_Phdr textHeader;
     Elf64_Phdr bssHeader;
@@ -19,14 +19,59 @@ struct ElfFile
 
     uint8_t*   bytecode;
     size_t     bytecodeCapacity;
+    bool       isMapped; /* bytecode is the file itself, see mapOutputFile() */
+};
+
+enum ElfSection
+{
+    SECTION_NULL,
+    SECTION_TEXT,
+    SECTION_BSS,
+    SECTION_DATA,
+    SECTION_SYMTAB,
+    SECTION_STRTAB,
+    SECTION_SHSTRTAB,
+
+    /* Written only if their contents are set (see setDebugSection()). */
+    SECTION_DEBUG_ABBREV,
+    SECTION_DEBUG_INFO,
+    SECTION_DEBUG_LINE,
+    SECTION_DEBUG_FRAME,
+
+    SECTIONS_COUNT
+};
+
+static const ElfSection FIRST_DEBUG_SECTION = SECTION_DEBUG_ABBREV;
+
+static const char* SECTION_NAMES[SECTIONS_COUNT] = 
+{
+    "", ".text", ".bss", ".data", ".symtab", ".strtab", ".shstrtab",
+    ".debug_abbrev", ".debug_info", ".debug_line", ".debug_frame"
 };
 
 struct ElfBuilder
 {
-    ElfFile  elfFile;
-    uint64_t offset;
+    ElfFile    elfFile;
+    uint64_t   offset;
+
+    /* Symbols' values are their offsets in the file until writeSections(). */
+    Elf64_Sym* symbols;
+    size_t     symbolsCount;
+    size_t     symbolsCapacity;
+
+    /* Contents of .strtab. */
+    char*      symbolNames;
+    size_t     symbolNamesSize;
+    size_t     symbolNamesCapacity;
+
+    /* Not owned by the builder. */
+    const uint8_t* debugSections     [SECTIONS_COUNT];
+    size_t         debugSectionsSizes[SECTIONS_COUNT];
 };  
 
+static const size_t ELF_SYMBOLS_INITIAL_CAPACITY = 256;
+static const size_t SECTION_TABLE_ALIGNMENT      = 8;
+
 static const size_t USED_SEGMENTS_COUNT   = 3; 
 static const size_t VIRTUAL_ADDRESS_START = 0x400000;
 static const size_t PAGE_SIZE             = 0x1000; /* 4kB */
@@ -86,7 +131,9 @@ static const Elf64_Phdr DEFAULT_SEGMENT_HEADER =
 };
 
 void construct         (ElfBuilder* builder, FILE* file, size_t initialSize);
+void constructPart     (ElfBuilder* builder, size_t initialSize);
 void destroy           (ElfBuilder* builder);
+bool mapOutputFile     (ElfBuilder* builder);
 void writeElfFile      (ElfFile* elfFile, size_t size);
 
 void setBuilderToStart (ElfBuilder* builder);
@@ -94,7 +141,7 @@ void startTextSegment  (ElfBuilder* builder);
 void startBssSegment   (ElfBuilder* builder); 
 void startDataSegment  (ElfBuilder* builder); 
 void endTextSegment    (ElfBuilder* builder); 
-void endBssSegment     (ElfBuilder* builder); 
+void endBssSegment     (ElfBuilder* builder, size_t size); 
 void endDataSegment    (ElfBuilder* builder); 
 
 void writeBytes        (ElfBuilder* builder, const uint8_t* buffer, size_t size);
@@ -103,4 +150,79 @@ void writeUInt16       (ElfBuilder* builder, uint16_t word);
 void writeUInt32       (ElfBuilder* builder, uint32_t doubleWord);
 void writeUInt64       (ElfBuilder* builder, uint64_t quadWord);
 
+void addSymbol         (ElfBuilder* builder, const char* name, uint64_t offset, 
+                        uint8_t type, uint8_t binding);
+void setDebugSection   (ElfBuilder* builder, ElfSection section, const uint8_t* bytes, size_t size);
+void writeSections     (ElfBuilder* builder);
+
+void patchUInt32       (ElfBuilder* builder, uint64_t offset, uint32_t doubleWord);
+void patchUInt64       (ElfBuilder* builder, uint64_t offset, uint64_t quadWord);
+
+void growBytecode      (ElfBuilder* builder, size_t bytesNeeded);
+
+//==================================Fast path===================================
+// Instead of checking the space for every byte, the caller reserves the space 
+// for the whole instruction, stores its bytes without any checks and commits 
+// them:
+//
+//     uint8_t* cur = reserveBytes(builder, INSTRUCTION_MAX_SIZE);
+//     cur = storeByte  (cur, opcode);
+//     cur = storeUInt32(cur, imm32);
+//     commitBytes(builder, cur);
+//==================================Fast path===================================
+
+//------------------------------------------------------------------------------
+//! @return Where to store at most size bytes from the current offset.
+//------------------------------------------------------------------------------
+inline uint8_t* reserveBytes(ElfBuilder* builder, size_t size)
+{
+    if (builder->offset + size >= builder->elfFile.bytecodeCapacity)
+    {
+        growBytecode(builder, size);
+    }
+
+    return builder->elfFile.bytecode + builder->offset;
+}
+
+//------------------------------------------------------------------------------
+//! @param end Pointer right after the last stored byte.
+//------------------------------------------------------------------------------
+inline void commitBytes(ElfBuilder* builder, const uint8_t* end)
+{
+    assert(end >= builder->elfFile.bytecode + builder->offset);
+    assert(end <  builder->elfFile.bytecode + builder->elfFile.bytecodeCapacity);
+
+    builder->offset = (uint64_t) (end - builder->elfFile.bytecode);
+}
+
+inline uint8_t* storeBytes(uint8_t* dest, const uint8_t* bytes, size_t size)
+{
+    memcpy(dest, bytes, size);
+    return dest + size;
+}
+
+inline uint8_t* storeByte(uint8_t* dest, uint8_t byte)
+{
+    *dest = byte;
+    return dest + 1;
+}
+
+inline uint8_t* storeUInt16(uint8_t* dest, uint16_t word)
+{
+    memcpy(dest, &word, sizeof(word));
+    return dest + sizeof(word);
+}
+
+inline uint8_t* storeUInt32(uint8_t* dest, uint32_t doubleWord)
+{
+    memcpy(dest, &doubleWord, sizeof(doubleWord));
+    return dest + sizeof(doubleWord);
+}
+
+inline uint8_t* storeUInt64(uint8_t* dest, uint64_t quadWord)
+{
+    memcpy(dest, &quadWord, sizeof(quadWord));
+    return dest + sizeof(quadWord);
+}
+
 #endif
\ No newline at end of file
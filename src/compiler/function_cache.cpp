@@ -0,0 +1,413 @@
+#include <assert.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "function_cache.h"
+
+/* The code depends on the compiler's sources, so the Makefile sets their hash. */
+#ifndef COMPILER_SOURCES_HASH
+#error "COMPILER_SOURCES_HASH has to identify the compiler's sources (see the Makefile)"
+#endif
+
+const char CACHE_PACK_EXTENSION[]   = ".ptc";
+const char CACHE_TEMPORARY_SUFFIX[] = ".XXXXXX"; /* see mkstemp() */
+
+//------------------------------------------------------------------------------
+//! Beginning of a pack, followed by the index (see CachePackEntry) and then by
+//! the keys and the data.
+//------------------------------------------------------------------------------
+struct CachePackHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t sourcesHash; /* so that other compilers' packs are ignored */
+    uint64_t entriesCount;
+};
+
+uint64_t hashBytes      (const uint8_t* bytes, size_t size);
+uint64_t sourcesHash    ();
+bool     isInPack       (const CachePack* pack, uint64_t offset, uint64_t size);
+int      compareEntries (const void* first, const void* second);
+
+//==================================CacheBuffer=================================
+void construct(CacheBuffer* buffer)
+{
+    assert(buffer);
+
+    buffer->bytes    = (uint8_t*) calloc(CACHE_BUFFER_INITIAL_CAPACITY, sizeof(uint8_t));
+    buffer->size     = 0;
+    buffer->capacity = CACHE_BUFFER_INITIAL_CAPACITY;
+    assert(buffer->bytes);
+}
+
+void destroy(CacheBuffer* buffer)
+{
+    assert(buffer);
+
+    free(buffer->bytes);
+    *buffer = {};
+}
+
+//------------------------------------------------------------------------------
+//! @return Pointer to the size bytes added to the end of the buffer.
+//------------------------------------------------------------------------------
+uint8_t* reserveBytes(CacheBuffer* buffer, size_t size)
+{
+    assert(buffer);
+    assert(buffer->bytes);
+
+    if (buffer->size + size > buffer->capacity)
+    {
+        size_t newCapacity = buffer->capacity;
+        while (buffer->size + size > newCapacity) { newCapacity *= 2; }
+
+        buffer->bytes    = (uint8_t*) realloc(buffer->bytes, newCapacity);
+        buffer->capacity = newCapacity;
+        assert(buffer->bytes);
+    }
+
+    uint8_t* reserved = buffer->bytes + buffer->size;
+    buffer->size += size;
+
+    return reserved;
+}
+
+void appendBytes(CacheBuffer* buffer, const void* bytes, size_t size)
+{
+    assert(bytes || size == 0);
+
+    uint8_t* reserved = reserveBytes(buffer, size);
+    if (size > 0) { memcpy(reserved, bytes, size); }
+}
+
+void appendUInt32(CacheBuffer* buffer, uint32_t value)
+{
+    appendBytes(buffer, &value, sizeof(value));
+}
+
+void appendUInt64(CacheBuffer* buffer, uint64_t value)
+{
+    appendBytes(buffer, &value, sizeof(value));
+}
+
+//------------------------------------------------------------------------------
+//! Appends the value as writeVarUInt() writes it.
+//------------------------------------------------------------------------------
+void appendVarUInt(CacheBuffer* buffer, uint64_t value)
+{
+    uint8_t bytes[CACHE_VAR_UINT_MAX_SIZE] = {};
+
+    appendBytes(buffer, bytes, (size_t) (writeVarUInt(bytes, value) - bytes));
+}
+
+//------------------------------------------------------------------------------
+//! Appends the string with its terminating NUL.
+//------------------------------------------------------------------------------
+void appendString(CacheBuffer* buffer, const char* string)
+{
+    assert(string);
+
+    appendBytes(buffer, string, strlen(string) + 1);
+}
+
+//------------------------------------------------------------------------------
+//! Appends the program's absolute path, so that its packs are the same 
+//! wherever it's compiled from, or the name itself if it can't be resolved.
+//------------------------------------------------------------------------------
+void appendProgramPath(CacheBuffer* buffer, const char* programName)
+{
+    assert(programName);
+
+    char programPath[PATH_MAX] = "";
+    appendString(buffer, realpath(programName, programPath) ? programPath : programName);
+}
+//==================================CacheBuffer=================================
+
+//=================================FunctionCache================================
+//------------------------------------------------------------------------------
+//! Makes the directory if there is no such one yet.
+//------------------------------------------------------------------------------
+void construct(FunctionCache* cache, const char* directory)
+{
+    assert(cache);
+    assert(directory);
+
+    *cache = {};
+
+    cache->directory = directory;
+
+    mkdir(directory, 0755);
+}
+
+void destroy(FunctionCache* cache)
+{
+    assert(cache);
+
+    destroy(&cache->pack);
+
+    *cache = {};
+}
+
+//------------------------------------------------------------------------------
+//! Looks up the function in the pack opened for the program and counts it as 
+//! a hit or a miss (see findCacheEntry()).
+//------------------------------------------------------------------------------
+bool findCachedFunction(FunctionCache* cache, const CacheBuffer* key, CacheSlice* data)
+{
+    assert(cache);
+
+    bool isFound = findCacheEntry(&cache->pack, key, data);
+
+    if (isFound) { cache->hits++;   }
+    else         { cache->misses++; }
+
+    return isFound;
+}
+
+//=================================FunctionCache================================
+
+//==================================CachePack===================================
+//------------------------------------------------------------------------------
+//! FNV-1a, 64-bit, which takes 8 bytes at a time, as the whole keys and data
+//! are hashed for every function.
+//------------------------------------------------------------------------------
+uint64_t hashBytes(const uint8_t* bytes, size_t size)
+{
+    assert(bytes || size == 0);
+
+    uint64_t hash = 14695981039346656037ull;
+    size_t   i    = 0;
+
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+    {
+        uint64_t word = 0;
+        memcpy(&word, bytes + i, sizeof(word));
+
+        hash ^= word;
+        hash *= 1099511628211ull;
+        hash ^= hash >> 32;
+    }
+
+    for (; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+
+    return hash;
+}
+
+uint64_t sourcesHash()
+{
+    return hashBytes((const uint8_t*) COMPILER_SOURCES_HASH, sizeof(COMPILER_SOURCES_HASH) - 1);
+}
+
+//------------------------------------------------------------------------------
+//! Maps the pack with the key to memory, if there is a valid one. Only its
+//! header and the index's size are checked here, the entries are checked by
+//! findCacheEntry(), so that a damaged entry doesn't make the others miss.
+//------------------------------------------------------------------------------
+void openCachePack(CachePack* pack, const char* directory, const CacheBuffer* packKey)
+{
+    assert(pack);
+    assert(directory);
+    assert(packKey);
+
+    *pack = {};
+
+    int length = snprintf(pack->path, sizeof(pack->path), "%s/%016" PRIx64 "%s", directory,
+                          hashBytes(packKey->bytes, packKey->size), CACHE_PACK_EXTENSION);
+
+    if (length < 0 || length >= (int) sizeof(pack->path))
+    {
+        pack->path[0] = '\0';
+        return;
+    }
+
+    int descriptor = open(pack->path, O_RDONLY);
+    if (descriptor == -1) { return; }
+
+    struct stat fileInfo = {};
+    if (fstat(descriptor, &fileInfo) != 0 || (size_t) fileInfo.st_size < sizeof(CachePackHeader))
+    {
+        close(descriptor);
+        return;
+    }
+
+    size_t size  = (size_t) fileInfo.st_size;
+    void*  bytes = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    close(descriptor);
+
+    if (bytes == MAP_FAILED) { return; }
+
+    CachePackHeader header = {};
+    memcpy(&header, bytes, sizeof(header));
+
+    if (header.magic        != FUNCTION_CACHE_MAGIC   ||
+        header.version      != FUNCTION_CACHE_VERSION ||
+        header.sourcesHash  != sourcesHash()          ||
+        header.entriesCount >  (size - sizeof(header)) / sizeof(CachePackEntry))
+    {
+        munmap(bytes, size);
+        return;
+    }
+
+    pack->bytes        = (const uint8_t*) bytes;
+    pack->size         = size;
+    pack->entries      = (const CachePackEntry*) (pack->bytes + sizeof(header));
+    pack->entriesCount = header.entriesCount;
+}
+
+void destroy(CachePack* pack)
+{
+    assert(pack);
+
+    if (pack->bytes) { munmap((void*) pack->bytes, pack->size); }
+
+    *pack = {};
+}
+
+bool isInPack(const CachePack* pack, uint64_t offset, uint64_t size)
+{
+    assert(pack);
+
+    return offset <= pack->size && size <= pack->size - offset;
+}
+
+//------------------------------------------------------------------------------
+//! Looks up the entry with the key. Entries which have another key or are 
+//! damaged aren't found.
+//!
+//! @param data Is set to the entry's data inside the pack, which stays valid 
+//!             until the pack is destroyed.
+//!
+//! @return Whether the entry is found.
+//------------------------------------------------------------------------------
+bool findCacheEntry(const CachePack* pack, const CacheBuffer* key, CacheSlice* data)
+{
+    assert(pack);
+    assert(key);
+    assert(data);
+
+    uint64_t keyHash = hashBytes(key->bytes, key->size);
+
+    /* The first entry with the key's hash. */
+    size_t left  = 0;
+    size_t right = pack->entriesCount;
+
+    while (left < right)
+    {
+        size_t middle = left + (right - left) / 2;
+
+        if (pack->entries[middle].keyHash < keyHash) { left  = middle + 1; }
+        else                                         { right = middle;     }
+    }
+
+    for (size_t i = left; i < pack->entriesCount && pack->entries[i].keyHash == keyHash; i++)
+    {
+        const CachePackEntry* entry = &pack->entries[i];
+
+        if (entry->keySize == key->size                        &&
+            isInPack(pack, entry->keyOffset,  entry->keySize)  &&
+            isInPack(pack, entry->dataOffset, entry->dataSize) &&
+            memcmp(pack->bytes + entry->keyOffset, key->bytes, key->size) == 0 &&
+            hashBytes(pack->bytes + entry->dataOffset, entry->dataSize) == entry->dataHash)
+        {
+            data->bytes = pack->bytes + entry->dataOffset;
+            data->size  = entry->dataSize;
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+int compareEntries(const void* first, const void* second)
+{
+    uint64_t firstHash  = ((const CachePackEntry*) first)->keyHash;
+    uint64_t secondHash = ((const CachePackEntry*) second)->keyHash;
+
+    return (firstHash > secondHash) - (firstHash < secondHash);
+}
+
+//------------------------------------------------------------------------------
+//! Writes the entries to a temporary file, which then replaces the pack, so 
+//! that no one ever reads a partly written pack. Failing to store the pack 
+//! only makes its entries misses the next time. The entries may point into 
+//! the old pack, which stays mapped.
+//------------------------------------------------------------------------------
+void storeCachePack(const CachePack* pack, const CacheEntry* entries, size_t entriesCount)
+{
+    assert(pack);
+    assert(entries || entriesCount == 0);
+
+    if (pack->path[0] == '\0') { return; }
+
+    char temporaryPath[sizeof(pack->path) + sizeof(CACHE_TEMPORARY_SUFFIX)] = "";
+    snprintf(temporaryPath, sizeof(temporaryPath), "%s%s", pack->path, CACHE_TEMPORARY_SUFFIX);
+
+    int descriptor = mkstemp(temporaryPath);
+    if (descriptor == -1) { return; }
+
+    /* mkstemp() makes the file readable only by the owner. */
+    fchmod(descriptor, 0644);
+
+    FILE* file = fdopen(descriptor, "wb");
+    if (file == nullptr)
+    {
+        close(descriptor);
+        remove(temporaryPath);
+        return;
+    }
+
+    CachePackHeader header = {FUNCTION_CACHE_MAGIC, FUNCTION_CACHE_VERSION, sourcesHash(), entriesCount};
+
+    /* The keys and the data follow the index in the entries' order. */
+    CachePackEntry* index  = (CachePackEntry*) calloc(entriesCount + 1, sizeof(CachePackEntry));
+    uint64_t        offset = sizeof(header) + entriesCount * sizeof(CachePackEntry);
+    assert(index);
+
+    for (size_t i = 0; i < entriesCount; i++)
+    {
+        const CacheEntry* entry = &entries[i];
+
+        index[i].keyHash    = hashBytes(entry->key.bytes, entry->key.size);
+        index[i].keyOffset  = offset;
+        index[i].keySize    = entry->key.size;
+        index[i].dataOffset = offset + entry->key.size;
+        index[i].dataSize   = entry->data.size;
+        index[i].dataHash   = hashBytes(entry->data.bytes, entry->data.size);
+
+        offset += entry->key.size + entry->data.size;
+    }
+
+    qsort(index, entriesCount, sizeof(CachePackEntry), compareEntries);
+
+    bool isWritten = fwrite(&header, sizeof(header),         1,            file) == 1 &&
+                     fwrite(index,   sizeof(CachePackEntry), entriesCount, file) == entriesCount;
+
+    for (size_t i = 0; i < entriesCount && isWritten; i++)
+    {
+        const CacheEntry* entry = &entries[i];
+
+        isWritten = fwrite(entry->key.bytes,  sizeof(uint8_t), entry->key.size,  file) == entry->key.size &&
+                    fwrite(entry->data.bytes, sizeof(uint8_t), entry->data.size, file) == entry->data.size;
+    }
+
+    free(index);
+
+    isWritten = fclose(file) == 0 && isWritten;
+
+    if (!isWritten || rename(temporaryPath, pack->path) != 0)
+    {
+        remove(temporaryPath);
+    }
+}
+//==================================CachePack===================================
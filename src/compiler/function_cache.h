@@ -0,0 +1,125 @@
+//------------------------------------------------------------------------------
+//! On-disk cache of compiled functions. The functions of a program are kept in
+//! a single file, the program's pack (see CachePack), which is mapped to memory
+//! and rewritten at once. The functions' keys describe everything their code
+//! depends on (see compileCached()). The program's outputs are kept in a pack
+//! of their own too (see CachedOutputs).
+//!
+//! @file   function_cache.h
+//------------------------------------------------------------------------------
+
+#ifndef FUNCTION_CACHE_H
+#define FUNCTION_CACHE_H
+
+#include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+static const size_t   CACHE_BUFFER_INITIAL_CAPACITY = 256;
+static const uint32_t FUNCTION_CACHE_MAGIC          = 0x43545046; /* "FPTC" */
+static const uint32_t FUNCTION_CACHE_VERSION        = 3;
+static const size_t   CACHE_VAR_UINT_MAX_SIZE       = 10; /* see writeVarUInt() */
+
+struct CacheBuffer
+{
+    uint8_t* bytes;
+    size_t   size;
+    size_t   capacity;
+};
+
+//------------------------------------------------------------------------------
+//! Bytes owned by someone else (e.g. a buffer or the mapped pack).
+//------------------------------------------------------------------------------
+struct CacheSlice
+{
+    const uint8_t* bytes;
+    size_t         size;
+};
+
+//------------------------------------------------------------------------------
+//! Entry to be stored in the pack (see storeCachePack()).
+//------------------------------------------------------------------------------
+struct CacheEntry
+{
+    CacheSlice key;
+    CacheSlice data;
+};
+
+//------------------------------------------------------------------------------
+//! Entry in the pack's index, which is sorted by the hashes of the keys.
+//! The offsets are from the beginning of the pack.
+//------------------------------------------------------------------------------
+struct CachePackEntry
+{
+    uint64_t keyHash;
+    uint64_t keyOffset;
+    uint64_t keySize;
+    uint64_t dataOffset;
+    uint64_t dataSize;
+    uint64_t dataHash; /* so that damaged entries are ignored */
+};
+
+//------------------------------------------------------------------------------
+//! File of the cache's directory, named after the hash of the pack's key, with
+//! the entries found by the hashes of their keys. The pack keeps the whole 
+//! keys, so that colliding hashes are told apart, and the data, which it 
+//! doesn't interpret.
+//------------------------------------------------------------------------------
+struct CachePack
+{
+    char                  path[PATH_MAX]; /* empty if it doesn't fit */
+
+    /* Contents of the file, mapped to memory, or nullptr if there's none. */
+    const uint8_t*        bytes;
+    size_t                size;
+    const CachePackEntry* entries;
+    size_t                entriesCount;
+};
+
+struct FunctionCache
+{
+    const char* directory;
+    CachePack   pack;      /* of the compiled program's functions */
+
+    size_t      hits;
+    size_t      misses;
+};
+
+void     construct           (CacheBuffer* buffer);
+void     destroy             (CacheBuffer* buffer);
+uint8_t* reserveBytes        (CacheBuffer* buffer, size_t size);
+void     appendBytes         (CacheBuffer* buffer, const void* bytes, size_t size);
+void     appendUInt32        (CacheBuffer* buffer, uint32_t value);
+void     appendUInt64        (CacheBuffer* buffer, uint64_t value);
+void     appendVarUInt       (CacheBuffer* buffer, uint64_t value);
+void     appendString        (CacheBuffer* buffer, const char* string);
+void     appendProgramPath   (CacheBuffer* buffer, const char* programName);
+
+//------------------------------------------------------------------------------
+//! Writes the value in 7 bits per byte, the high bit telling whether more 
+//! bytes follow (LEB128), so that the small values take a byte.
+//!
+//! @return Pointer past the written bytes, of which there are at most
+//!         CACHE_VAR_UINT_MAX_SIZE.
+//------------------------------------------------------------------------------
+inline uint8_t* writeVarUInt(uint8_t* bytes, uint64_t value)
+{
+    do
+    {
+        *bytes++ = (uint8_t) ((value & 0x7F) | (value > 0x7F ? 0x80 : 0));
+        value >>= 7;
+    } while (value != 0);
+
+    return bytes;
+}
+
+void     construct           (FunctionCache* cache, const char* directory);
+void     destroy             (FunctionCache* cache);
+bool     findCachedFunction  (FunctionCache* cache, const CacheBuffer* key, CacheSlice* data);
+
+void     openCachePack       (CachePack* pack, const char* directory, const CacheBuffer* packKey);
+void     destroy             (CachePack* pack);
+bool     findCacheEntry      (const CachePack* pack, const CacheBuffer* key, CacheSlice* data);
+void     storeCachePack      (const CachePack* pack, const CacheEntry* entries, size_t entriesCount);
+
+#endif
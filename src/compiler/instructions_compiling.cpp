@@ -6,35 +6,38 @@ void writeInstruction(Compiler* compiler, const Instruction_x86_64* instruction)
 void writeComment (Compiler* compiler, Comment comment);
 void writeMem64   (Compiler* compiler, Mem64 mem64);
 
+uint8_t shortJumpOpcode(Opcode opcode);
+
 void writeInstruction(Compiler* compiler, const Instruction_x86_64* instruction)
 {
     ASSERT_COMPILER(compiler);
 
     ElfBuilder* builder = &compiler->builder;
+    uint8_t*    cur     = reserveBytes(builder, INSTRUCTION_MAX_SIZE);
 
     if (instruction->isRexUsed)
     {
-        writeByte(builder, rexToByte(instruction->rex));
+        cur = storeByte(cur, rexToByte(instruction->rex));
     }
 
-    writeBytes(builder, instruction->opcode.bytes, instruction->opcode.size);
+    cur = storeBytes(cur, instruction->opcode.bytes, instruction->opcode.size);
 
     if (instruction->isModrmUsed)
     {
-        writeByte(builder, modrmToByte(instruction->modrm));
+        cur = storeByte(cur, modrmToByte(instruction->modrm));
     }
 
     if (instruction->isSibUsed)
     {
-        writeByte(builder, sibToByte(instruction->sib));
+        cur = storeByte(cur, sibToByte(instruction->sib));
     }
 
     switch (instruction->dispSize)
     {
-        case 1:  { writeByte   (builder, instruction->disp.disp8 ); break; }
-        case 2:  { writeUInt16 (builder, instruction->disp.disp16); break; }
-        case 4:  { writeUInt32 (builder, instruction->disp.disp32); break; }
-        case 8:  { writeUInt64 (builder, instruction->disp.disp64); break; }
+        case 1:  { cur = storeByte   (cur, instruction->disp.disp8 ); break; }
+        case 2:  { cur = storeUInt16 (cur, instruction->disp.disp16); break; }
+        case 4:  { cur = storeUInt32 (cur, instruction->disp.disp32); break; }
+        case 8:  { cur = storeUInt64 (cur, instruction->disp.disp64); break; }
 
         case 0:  { break; }
         default: { assert(!"Valid displacement size."); }
@@ -42,14 +45,16 @@ void writeInstruction(Compiler* compiler, const Instruction_x86_64* instruction)
 
     switch (instruction->immSize)
     {
-        case 1:  { writeByte   (builder, instruction->imm.imm8 ); break; }
-        case 2:  { writeUInt16 (builder, instruction->imm.imm16); break; }
-        case 4:  { writeUInt32 (builder, instruction->imm.imm32); break; }
-        case 8:  { writeUInt64 (builder, instruction->imm.imm64); break; }
+        case 1:  { cur = storeByte   (cur, instruction->imm.imm8 ); break; }
+        case 2:  { cur = storeUInt16 (cur, instruction->imm.imm16); break; }
+        case 4:  { cur = storeUInt32 (cur, instruction->imm.imm32); break; }
+        case 8:  { cur = storeUInt64 (cur, instruction->imm.imm64); break; }
 
         case 0:  { break; }
         default: { assert(!"Valid immediate constant size."); }
     }
+
+    commitBytes(builder, cur);
 }
 
 void writeComment(Compiler* compiler, Comment comment)
@@ -99,6 +104,24 @@ void writeMem64(Compiler* compiler, Mem64 mem64)
     }
 }
 
+//------------------------------------------------------------------------------
+//! @return Opcode of the rel8 form of the jump or 0 if it doesn't have one.
+//------------------------------------------------------------------------------
+uint8_t shortJumpOpcode(Opcode opcode)
+{
+    if (opcode.size == 1 && opcode.bytes[0] == OPCODE_JMP_REL32.bytes[0])
+    {
+        return OPCODE_JMP_REL8.bytes[0];
+    }
+
+    if (opcode.size == 2 && opcode.bytes[0] == 0x0F && (opcode.bytes[1] & 0xF0) == 0x80)
+    {
+        return OPCODE_BASE_JCC_REL8.bytes[0] + (opcode.bytes[1] & 0x0F);
+    }
+
+    return 0;
+}
+
 //===================================GENERAL====================================
 void write_instruction_r64_r64(Compiler* compiler, Opcode opcode, Reg64 reg1, Reg64 reg2)
 {
@@ -121,7 +144,7 @@ void write_instruction_r64_r64(Compiler* compiler, Opcode opcode, Reg64 reg1, Re
     writeInstruction(compiler, &instruction);
 }
 
-void write_jump_rel32(Compiler* compiler, Opcode opcode, int32_t labelAddress)
+void write_jump_rel32(Compiler* compiler, Opcode opcode, LabelId label)
 {
     ASSERT_COMPILER(compiler);
 
@@ -129,10 +152,37 @@ void write_jump_rel32(Compiler* compiler, Opcode opcode, int32_t labelAddress)
     instruction.opcode    = opcode;
     instruction.immSize   = 4;
     
-    int32_t instructionLength = opcode.size + 4;
-    instruction.imm.imm32 = labelAddress - compiler->builder.offset - instructionLength;
+    LabelManager* labelManager = &compiler->labelManager;
+
+    /* All the jumps are encoded by relaxBranches(), as any of them can move. 
+     * Calls can't be shortened and may go to other parts of the program (see 
+     * constructPart()), so they are left to fixups, which move with the code. */
+    uint8_t shortOpcode = shortJumpOpcode(opcode);
+    if (compiler->isSizeOptimized && shortOpcode != 0)
+    {
+        uint64_t offset = compiler->builder.offset;
+        writeInstruction(compiler, &instruction);
+
+        addBranch(labelManager, {offset, label, (uint8_t) (opcode.size + 4), shortOpcode, false});
+        return;
+    }
+
+    bool isWritten = isLabelWritten(labelManager, label) && !compiler->isSizeOptimized;
+
+    if (isWritten)
+    {
+        int32_t instructionLength = opcode.size + 4;
+        instruction.imm.imm32     = getLabelOffset(labelManager, label) - 
+                                    compiler->builder.offset - instructionLength;
+    }
 
     writeInstruction(compiler, &instruction);
+
+    /* Forward jumps are resolved after the whole program is emitted. */
+    if (!isWritten)
+    {
+        addFixup(labelManager, {compiler->builder.offset - 4, label, FIXUP_REL32});
+    }
 }
 //===================================GENERAL====================================
 
@@ -201,6 +251,32 @@ void write_xor_r64_r64(Compiler* compiler, Reg64 reg1, Reg64 reg2, Comment comme
     writeComment(compiler, comment);
 }
 
+//------------------------------------------------------------------------------
+//! Writing to a 32-bit register zeroes its upper half, so xor of the lower 
+//! halves clears the whole registers without REX.W.
+//------------------------------------------------------------------------------
+void write_xor_r32_r32(Compiler* compiler, Reg64 reg1, Reg64 reg2, Comment comment)
+{
+    ASSERT_COMPILER(compiler);
+
+    /* ----------------BYTECODE---------------- */
+    Instruction_x86_64 instruction = {};
+    updateRexR(&instruction, reg2);
+    updateRexB(&instruction, reg1);
+
+    instruction.opcode = OPCODE_XOR_R64_R64;
+
+    addModrm(&instruction, 0b11);
+    updateModrmReg(&instruction, reg2);
+    updateModrmRm(&instruction, reg1);
+
+    writeInstruction(compiler, &instruction);
+
+    /* ------------------NASM------------------ */
+    writeIndented(compiler, "xor %s, %s", reg32ToString(reg1), reg32ToString(reg2));
+    writeComment(compiler, comment);
+}
+
 void write_cmp_r64_r64(Compiler* compiler, Reg64 reg1, Reg64 reg2, Comment comment)
 {
     ASSERT_COMPILER(compiler);
@@ -250,6 +326,13 @@ void write_add_r64_imm32(Compiler* compiler, Reg64 reg, int32_t imm, Comment com
     instruction.dispSize    = 4;
     instruction.disp.disp32 = imm;
 
+    if (compiler->isSizeOptimized && INT8_MIN <= imm && imm <= INT8_MAX)
+    {
+        instruction.opcode     = OPCODE_ADD_R64_IMM8;
+        instruction.dispSize   = 1;
+        instruction.disp.disp8 = (int8_t) imm;
+    }
+
     writeInstruction(compiler, &instruction);
 
     /* ------------------NASM------------------ */
@@ -291,6 +374,13 @@ void write_sub_r64_imm32(Compiler* compiler, Reg64 reg, int32_t imm, Comment com
     instruction.dispSize    = 4;
     instruction.disp.disp32 = imm;
 
+    if (compiler->isSizeOptimized && INT8_MIN <= imm && imm <= INT8_MAX)
+    {
+        instruction.opcode     = OPCODE_SUB_R64_IMM8;
+        instruction.dispSize   = 1;
+        instruction.disp.disp8 = (int8_t) imm;
+    }
+
     writeInstruction(compiler, &instruction);
 
     /* ------------------NASM------------------ */
@@ -431,7 +521,7 @@ void write_call_rel32(Compiler* compiler, Label label, Comment comment)
     ASSERT_COMPILER(compiler);
 
     /* ----------------BYTECODE---------------- */
-    write_jump_rel32(compiler, OPCODE_CALL_REL32, label.offset);
+    write_jump_rel32(compiler, OPCODE_CALL_REL32, label.id);
 
     /* ------------------NASM------------------ */
     writeIndented(compiler, "call %s", label.name);
@@ -462,7 +552,7 @@ void write_jmp_rel32(Compiler* compiler, Label label, Comment comment)
     ASSERT_COMPILER(compiler);
 
     /* ----------------BYTECODE---------------- */
-    write_jump_rel32(compiler, OPCODE_JMP_REL32, label.offset);
+    write_jump_rel32(compiler, OPCODE_JMP_REL32, label.id);
 
     /* ------------------NASM------------------ */
     writeIndented(compiler, "jmp %s", label.name);
@@ -479,7 +569,7 @@ void write_jz_rel32(Compiler* compiler, Label label, Comment comment)
     ASSERT_COMPILER(compiler);
 
     /* ----------------BYTECODE---------------- */
-    write_jump_rel32(compiler, OPCODE_JZ_REL32, label.offset);
+    write_jump_rel32(compiler, OPCODE_JZ_REL32, label.id);
 
     /* ------------------NASM------------------ */
     writeIndented(compiler, "jz %s", label.name);
@@ -494,7 +584,7 @@ void write_jz_rel32(Compiler* compiler, Label label, Comment comment)
 void write_je_rel32(Compiler* compiler, Label label, Comment comment)
 {
     /* ----------------BYTECODE---------------- */
-    write_jump_rel32(compiler, OPCODE_JE_REL32, label.offset);
+    write_jump_rel32(compiler, OPCODE_JE_REL32, label.id);
 
     /* ------------------NASM------------------ */
     writeIndented(compiler, "je %s", label.name);
@@ -509,7 +599,7 @@ void write_je_rel32(Compiler* compiler, Label label, Comment comment)
 void write_jne_rel32(Compiler* compiler, Label label, Comment comment)
 {
     /* ----------------BYTECODE---------------- */
-    write_jump_rel32(compiler, OPCODE_JNE_REL32, label.offset);
+    write_jump_rel32(compiler, OPCODE_JNE_REL32, label.id);
 
     /* ------------------NASM------------------ */
     writeIndented(compiler, "jne %s", label.name);
@@ -524,7 +614,7 @@ void write_jne_rel32(Compiler* compiler, Label label, Comment comment)
 void write_jl_rel32(Compiler* compiler, Label label, Comment comment)
 {
     /* ----------------BYTECODE---------------- */
-    write_jump_rel32(compiler, OPCODE_JL_REL32, label.offset);
+    write_jump_rel32(compiler, OPCODE_JL_REL32, label.id);
 
     /* ------------------NASM------------------ */
     writeIndented(compiler, "jl %s", label.name);
@@ -539,7 +629,7 @@ void write_jl_rel32(Compiler* compiler, Label label, Comment comment)
 void write_jg_rel32(Compiler* compiler, Label label, Comment comment)
 {
     /* ----------------BYTECODE---------------- */
-    write_jump_rel32(compiler, OPCODE_JG_REL32, label.offset);
+    write_jump_rel32(compiler, OPCODE_JG_REL32, label.id);
 
     /* ------------------NASM------------------ */
     writeIndented(compiler, "jg %s", label.name);
@@ -554,7 +644,7 @@ void write_jg_rel32(Compiler* compiler, Label label, Comment comment)
 void write_jle_rel32(Compiler* compiler, Label label, Comment comment)
 {
     /* ----------------BYTECODE---------------- */
-    write_jump_rel32(compiler, OPCODE_JLE_REL32, label.offset);
+    write_jump_rel32(compiler, OPCODE_JLE_REL32, label.id);
 
     /* ------------------NASM------------------ */
     writeIndented(compiler, "jle %s", label.name);
@@ -569,7 +659,7 @@ void write_jle_rel32(Compiler* compiler, Label label, Comment comment)
 void write_jge_rel32(Compiler* compiler, Label label, Comment comment)
 {
     /* ----------------BYTECODE---------------- */
-    write_jump_rel32(compiler, OPCODE_JGE_REL32, label.offset);
+    write_jump_rel32(compiler, OPCODE_JGE_REL32, label.id);
 
     /* ------------------NASM------------------ */
     writeIndented(compiler, "jge %s", label.name);
@@ -596,10 +686,21 @@ void write_mov_r64_r64(Compiler* compiler, Reg64 dest, Reg64 src, Comment commen
     writeComment(compiler, comment);
 }
 
+//------------------------------------------------------------------------------
+//! If the code is optimized for size, the shortest of the forms with the same
+//! result is used. Note that loading zero changes the flags in that case.
+//------------------------------------------------------------------------------
 void write_mov_r64_imm64(Compiler* compiler, Reg64 dest, int64_t imm, Comment comment)
 {
     ASSERT_COMPILER(compiler);
 
+    if (compiler->isSizeOptimized)
+    {
+        if (imm == 0)                     { write_xor_r32_r32   (compiler, dest, dest,           comment); return; }
+        if (0 < imm && imm <= UINT32_MAX) { write_mov_r32_imm32 (compiler, dest, (uint32_t) imm, comment); return; }
+        if (INT32_MIN <= imm && imm < 0)  { write_mov_r64_imm32 (compiler, dest, (int32_t) imm,  comment); return; }
+    }
+
     /* ----------------BYTECODE---------------- */
     Instruction_x86_64 instruction = {};
     
@@ -638,11 +739,25 @@ void write_mov_r64_imm64(Compiler* compiler, Reg64 dest, Label label, Comment co
     instruction.opcode           = OPCODE_BASE_MOV_R64_IMM64;
     instruction.opcode.bytes[0] += regSpecifier(dest);
 
-    instruction.dispSize    = 8;
-    instruction.disp.disp64 = label.offset + VIRTUAL_ADDRESS_START;
+    instruction.dispSize = 8;
+
+    /* Labels can move while branches are relaxed, so fixups are used for all
+     * of them if the code is optimized for size. */
+    LabelManager* labelManager = &compiler->labelManager;
+    bool          isWritten    = isLabelWritten(labelManager, label.id) && !compiler->isSizeOptimized;
+
+    if (isWritten)
+    {
+        instruction.disp.disp64 = getLabelOffset(labelManager, label.id) + VIRTUAL_ADDRESS_START;
+    }
 
     writeInstruction(compiler, &instruction);
 
+    if (!isWritten)
+    {
+        addFixup(labelManager, {compiler->builder.offset - 8, label.id, FIXUP_ABS64});
+    }
+
     /* ------------------NASM------------------ */
     writeIndented(compiler, "mov %s, %s", reg64ToString(dest), label.name);
     if (label.number != -1)
@@ -653,6 +768,62 @@ void write_mov_r64_imm64(Compiler* compiler, Reg64 dest, Label label, Comment co
     writeComment(compiler, comment);
 }
 
+//------------------------------------------------------------------------------
+//! Zero-extends imm to the whole register.
+//------------------------------------------------------------------------------
+void write_mov_r32_imm32(Compiler* compiler, Reg64 dest, uint32_t imm, Comment comment)
+{
+    ASSERT_COMPILER(compiler);
+
+    /* ----------------BYTECODE---------------- */
+    Instruction_x86_64 instruction = {};
+    updateRexB(&instruction, dest);
+
+    instruction.opcode           = OPCODE_BASE_MOV_R32_IMM32;
+    instruction.opcode.bytes[0] += regSpecifier(dest);
+
+    instruction.dispSize    = 4;
+    instruction.disp.disp32 = (int32_t) imm;
+
+    writeInstruction(compiler, &instruction);
+
+    /* ------------------NASM------------------ */
+    writeIndented(compiler, "mov %s, %" PRIu32, reg32ToString(dest), imm);
+    writeComment(compiler, comment);
+}
+
+//------------------------------------------------------------------------------
+//! Sign-extends imm to the whole register.
+//------------------------------------------------------------------------------
+void write_mov_r64_imm32(Compiler* compiler, Reg64 dest, int32_t imm, Comment comment)
+{
+    ASSERT_COMPILER(compiler);
+
+    /* ----------------BYTECODE---------------- */
+    Instruction_x86_64 instruction = {};
+    
+    addRex(&instruction);
+    instruction.rex.w = 1; /* long mode */
+    instruction.rex.r = 0; /* MODRM.reg extends the opcode, hence no need in REX.r */
+    instruction.rex.x = 0; /* SIB isn't used */
+    updateRexB(&instruction, dest);
+    
+    instruction.opcode = OPCODE_MOV_R64_IMM32;
+
+    addModrm(&instruction, 0b11);
+    instruction.modrm.reg = OPCODE_MOV_EXTENSION;
+    updateModrmRm(&instruction, dest);
+
+    instruction.dispSize    = 4;
+    instruction.disp.disp32 = imm;
+
+    writeInstruction(compiler, &instruction);
+
+    /* ------------------NASM------------------ */
+    writeIndented(compiler, "mov %s, %" PRId32, reg64ToString(dest), imm);
+    writeComment(compiler, comment);
+}
+
 void write_mov_m64_r64(Compiler* compiler, Mem64 dest, Reg64 src, Comment comment)
 {
     ASSERT_COMPILER(compiler);
@@ -660,6 +831,7 @@ void write_mov_m64_r64(Compiler* compiler, Mem64 dest, Reg64 src, Comment commen
     /* ----------------BYTECODE---------------- */
     Instruction_x86_64 instruction = {};
     setMemoryAddressing(&instruction, dest);
+    if (compiler->isSizeOptimized) { shortenDisplacement(&instruction); }
     
     updateRexR(&instruction, src);
     instruction.opcode = OPCODE_MOV_M64_R64;
@@ -682,6 +854,7 @@ void write_mov_r64_m64(Compiler* compiler, Reg64 dest, Mem64 src, Comment commen
     /* ----------------BYTECODE---------------- */
     Instruction_x86_64 instruction = {};
     setMemoryAddressing(&instruction, src);
+    if (compiler->isSizeOptimized) { shortenDisplacement(&instruction); }
     
     updateRexR(&instruction, dest);
     instruction.opcode = OPCODE_MOV_R64_M64;
@@ -12,7 +12,7 @@ typedef const char* Comment;
 //! @{
 
 void write_instruction_r64_r64 (Compiler* compiler, Opcode opcode, Reg64 reg1, Reg64 reg2);
-void write_jump_rel32          (Compiler* compiler, Opcode opcode, int32_t rel);
+void write_jump_rel32          (Compiler* compiler, Opcode opcode, LabelId label);
 
 //! @}
 //===================================GENERAL====================================
@@ -44,6 +44,7 @@ static const Opcode OPCODE_CMP_R64_R64  = {.size = 1, .bytes = {0x39}};
 
 void write_test_r64_r64 (Compiler* compiler, Reg64 reg1, Reg64 reg2, Comment comment = nullptr);
 void write_xor_r64_r64  (Compiler* compiler, Reg64 reg1, Reg64 reg2, Comment comment = nullptr);
+void write_xor_r32_r32  (Compiler* compiler, Reg64 reg1, Reg64 reg2, Comment comment = nullptr);
 void write_cmp_r64_r64  (Compiler* compiler, Reg64 reg1, Reg64 reg2, Comment comment = nullptr);
 
 //! @}
@@ -57,9 +58,11 @@ void write_cmp_r64_r64  (Compiler* compiler, Reg64 reg1, Reg64 reg2, Comment com
 
 static const Opcode  OPCODE_ADD_R64_R64    = {.size = 1, .bytes = {0x01}      };
 static const Opcode  OPCODE_ADD_R64_IMM32  = {.size = 1, .bytes = {0x81}      };
+static const Opcode  OPCODE_ADD_R64_IMM8   = {.size = 1, .bytes = {0x83}      };
 static const uint8_t OPCODE_ADD_EXTENSION  = 0b000;
 static const Opcode  OPCODE_SUB_R64_R64    = {.size = 1, .bytes = {0x29}      };
 static const Opcode  OPCODE_SUB_R64_IMM32  = {.size = 1, .bytes = {0x81}      };
+static const Opcode  OPCODE_SUB_R64_IMM8   = {.size = 1, .bytes = {0x83}      };
 static const uint8_t OPCODE_SUB_EXTENSION  = 0b101;
 static const Opcode  OPCODE_IMUL_R64_R64   = {.size = 2, .bytes = {0x0F, 0xAF}};
 static const Opcode  OPCODE_CQO            = {.size = 1, .bytes = {0x99}      };
@@ -101,6 +104,12 @@ static const Opcode   OPCODE_JL_REL32   = {.size = 2, .bytes = {0x0F, 0x8C}};
 static const Opcode   OPCODE_JG_REL32   = {.size = 2, .bytes = {0x0F, 0x8F}};
 static const Opcode   OPCODE_JLE_REL32  = {.size = 2, .bytes = {0x0F, 0x8E}};
 static const Opcode   OPCODE_JGE_REL32  = {.size = 2, .bytes = {0x0F, 0x8D}};
+
+/* Short forms of the jumps above, which are used by relaxBranches(). The 
+ * condition code of Jcc rel8 is the same as the lower 4 bits of Jcc rel32. */
+static const Opcode   OPCODE_JMP_REL8      = {.size = 1, .bytes = {0xEB}};
+static const Opcode   OPCODE_BASE_JCC_REL8 = {.size = 1, .bytes = {0x70}};
+static const uint8_t  SHORT_JUMP_SIZE      = 2;
  
 void write_syscall    (Compiler* compiler,              Comment comment = nullptr);
 void write_call_rel32 (Compiler* compiler, Label label, Comment comment = nullptr);
@@ -123,16 +132,21 @@ void write_jge_rel32  (Compiler* compiler, Label label, Comment comment = nullpt
 //! @addtogroup MOVE
 //! @{
 
-static const Opcode OPCODE_MOV_R64_R64        = {.size = 1, .bytes = {0x89}};
-static const Opcode OPCODE_BASE_MOV_R64_IMM64 = {.size = 1, .bytes = {0xB8}};
-static const Opcode OPCODE_MOV_M64_R64        = {.size = 1, .bytes = {0x89}};
-static const Opcode OPCODE_MOV_R64_M64        = {.size = 1, .bytes = {0x8B}};
-
-void write_mov_r64_r64   (Compiler* compiler, Reg64 dest, Reg64   src,   Comment comment = nullptr);
-void write_mov_r64_imm64 (Compiler* compiler, Reg64 dest, int64_t imm,   Comment comment = nullptr);
-void write_mov_r64_imm64 (Compiler* compiler, Reg64 dest, Label   label, Comment comment = nullptr);
-void write_mov_m64_r64   (Compiler* compiler, Mem64 dest, Reg64   src,   Comment comment = nullptr);
-void write_mov_r64_m64   (Compiler* compiler, Reg64 dest, Mem64   src,   Comment comment = nullptr);
+static const Opcode  OPCODE_MOV_R64_R64        = {.size = 1, .bytes = {0x89}};
+static const Opcode  OPCODE_BASE_MOV_R64_IMM64 = {.size = 1, .bytes = {0xB8}};
+static const Opcode  OPCODE_BASE_MOV_R32_IMM32 = {.size = 1, .bytes = {0xB8}};
+static const Opcode  OPCODE_MOV_R64_IMM32      = {.size = 1, .bytes = {0xC7}};
+static const uint8_t OPCODE_MOV_EXTENSION      = 0b000;
+static const Opcode  OPCODE_MOV_M64_R64        = {.size = 1, .bytes = {0x89}};
+static const Opcode  OPCODE_MOV_R64_M64        = {.size = 1, .bytes = {0x8B}};
+
+void write_mov_r64_r64   (Compiler* compiler, Reg64 dest, Reg64    src,   Comment comment = nullptr);
+void write_mov_r64_imm64 (Compiler* compiler, Reg64 dest, int64_t  imm,   Comment comment = nullptr);
+void write_mov_r64_imm64 (Compiler* compiler, Reg64 dest, Label    label, Comment comment = nullptr);
+void write_mov_r32_imm32 (Compiler* compiler, Reg64 dest, uint32_t imm,   Comment comment = nullptr);
+void write_mov_r64_imm32 (Compiler* compiler, Reg64 dest, int32_t  imm,   Comment comment = nullptr);
+void write_mov_m64_r64   (Compiler* compiler, Mem64 dest, Reg64    src,   Comment comment = nullptr);
+void write_mov_r64_m64   (Compiler* compiler, Reg64 dest, Mem64    src,   Comment comment = nullptr);
 
 //! @}
 //====================================MOVE======================================
@@ -1,69 +1,291 @@
-#include <string.h>
+#include <assert.h>
+#include <stdlib.h>
 #include "label_manager.h"
 
-const size_t DEFAULT_CAPACITY   = 8;
-const double REALLOC_MULTIPLIER = 1.8;
+void construct(LabelManager* labelManager)
+{
+    assert(labelManager);
+
+    resetLabelNumbers(labelManager);
+
+    labelManager->offsets  = (int64_t*) calloc(LABEL_MANAGER_INITIAL_CAPACITY, sizeof(int64_t));
+    labelManager->count    = 0;
+    labelManager->capacity = LABEL_MANAGER_INITIAL_CAPACITY;
+    assert(labelManager->offsets);
+
+    construct(&labelManager->namedLabels);
 
-#define STRUCT   LabelArray
-#define ELEMENTS labels
-#define INSERT   insertLabel
-#define FIND     findLabel
-#define elem_t   Label
+    labelManager->fixups         = (Fixup*) calloc(LABEL_MANAGER_INITIAL_CAPACITY, sizeof(Fixup));
+    labelManager->fixupsCount    = 0;
+    labelManager->fixupsCapacity = LABEL_MANAGER_INITIAL_CAPACITY;
+    assert(labelManager->fixups);
 
-#undef DYNAMIC_ARRAY_CPP
-#include "../../libs/dynamic_array/dynamic_array.cpp"
+    labelManager->branches         = (Branch*) calloc(LABEL_MANAGER_INITIAL_CAPACITY, sizeof(Branch));
+    labelManager->branchesCount    = 0;
+    labelManager->branchesCapacity = LABEL_MANAGER_INITIAL_CAPACITY;
+    assert(labelManager->branches);
 
-#undef STRUCT             
-#undef ELEMENTS      
-#undef INSERT             
-#undef FIND               
-#undef elem_t 
+    labelManager->symbols         = (LabelSymbol*) calloc(LABEL_MANAGER_INITIAL_CAPACITY, sizeof(LabelSymbol));
+    labelManager->symbolsCount    = 0;
+    labelManager->symbolsCapacity = LABEL_MANAGER_INITIAL_CAPACITY;
+    assert(labelManager->symbols);
 
-int cmpLabels(Label firstLabel, Label secondLabel)
+    labelManager->program     = nullptr;
+    labelManager->firstPartId = 0;
+
+    labelManager->exports         = nullptr;
+    labelManager->exportsCount    = 0;
+    labelManager->exportsCapacity = 0;
+}
+
+//------------------------------------------------------------------------------
+//! Makes the manager of a part of the program, which is compiled separately 
+//! from the rest (e.g. by another thread) and merged into it by mergePart().
+//! The part's labels continue the program's ones. The program's labels can be
+//! referenced by the part, but are never written for it, as the part's offsets
+//! are relative to its own start. The ones the part writes become its exports.
+//! Named labels are looked up among the program's ones, so all of them have to
+//! be allocated by then.
+//------------------------------------------------------------------------------
+void constructPart(LabelManager* labelManager, const LabelManager* program)
 {
-    assert(firstLabel.name);
-    assert(secondLabel.name);
+    assert(labelManager);
+    assert(program);
+    assert(program->program == nullptr);
 
-    bool firstHasFunctionName  = firstLabel.functionName  != nullptr; 
-    bool secondHasFunctionName = secondLabel.functionName != nullptr; 
+    construct(labelManager);
 
-    if (firstHasFunctionName != secondHasFunctionName) { return -1; }
+    labelManager->program     = program;
+    labelManager->firstPartId = (LabelId) program->count;
 
-    if (firstHasFunctionName && 
-        (strcmp(firstLabel.functionName, secondLabel.functionName) != 0))
+    labelManager->exports         = (LabelExport*) calloc(LABEL_EXPORTS_INITIAL_CAPACITY, sizeof(LabelExport));
+    labelManager->exportsCapacity = LABEL_EXPORTS_INITIAL_CAPACITY;
+    assert(labelManager->exports);
+}
+
+void destroy(LabelManager* labelManager)
+{
+    assert(labelManager);
+
+    free(labelManager->offsets);
+    destroy(&labelManager->namedLabels);
+    free(labelManager->fixups);
+    free(labelManager->branches);
+    free(labelManager->symbols);
+    free(labelManager->exports);
+
+    *labelManager = {};
+}
+
+void resetLabelNumbers(LabelManager* labelManager)
+{
+    assert(labelManager);
+
+    for (uint32_t i = 0; i < TOTAL_LABELS; i++)
     {
-        return -1;
+        labelManager->curLabelNumbers[i] = 0;
     }
+}
 
-    if (strcmp(firstLabel.name, secondLabel.name) != 0) 
-    { 
-        return -1;
+//------------------------------------------------------------------------------
+//! @return Id of the first of count new consecutive labels, which aren't 
+//!         written yet.
+//------------------------------------------------------------------------------
+LabelId newLabelIds(LabelManager* labelManager, size_t count)
+{
+    assert(labelManager);
+    assert(labelManager->offsets);
+
+    size_t newCapacity = labelManager->capacity;
+    while (labelManager->count + count > newCapacity) { newCapacity *= 2; }
+
+    if (newCapacity != labelManager->capacity)
+    {
+        int64_t* newOffsets = (int64_t*) realloc(labelManager->offsets, newCapacity * sizeof(int64_t));
+        assert(newOffsets);
+
+        labelManager->offsets  = newOffsets;
+        labelManager->capacity = newCapacity;
     }
 
-    return secondLabel.number - firstLabel.number;
+    LabelId first = labelManager->firstPartId + (LabelId) labelManager->count;
+    for (size_t i = 0; i < count; i++)
+    {
+        labelManager->offsets[labelManager->count++] = LABEL_NOT_WRITTEN;
+    }
+
+    return first;
 }
 
-void construct(LabelManager* labelManager)
+LabelId newLabelId(LabelManager* labelManager)
+{
+    return newLabelIds(labelManager, 1);
+}
+
+//------------------------------------------------------------------------------
+//! @param name Has to be interned or one of the compiler's label constants, as
+//!             names are compared by pointers.
+//!
+//! @return Id of the label with the name, which is allocated on the first call.
+//------------------------------------------------------------------------------
+LabelId namedLabelId(LabelManager* labelManager, const char* name)
 {
     assert(labelManager);
-    
-    resetLabelNumbers(labelManager);
-    construct(&labelManager->labelArray, cmpLabels);
+    assert(name);
+
+    /* A part can't allocate the named labels, as they'd differ in each part. */
+    if (labelManager->program != nullptr)
+    {
+        LabelId label = findIndexedName(&labelManager->program->namedLabels, name);
+        assert(label != -1);
+
+        return label;
+    }
+
+    LabelId label = findIndexedName(&labelManager->namedLabels, name);
+    if (label != -1) { return label; }
+
+    label = newLabelId(labelManager);
+    indexName(&labelManager->namedLabels, name, label);
+
+    return label;
 }
 
-void destroy(LabelManager* labelManager)
+//------------------------------------------------------------------------------
+//! A part's offset of the program's label is recorded as the part's export.
+//------------------------------------------------------------------------------
+void setLabelOffset(LabelManager* labelManager, LabelId label, int64_t offset)
 {
     assert(labelManager);
+    assert(0 <= label && (size_t) label < (size_t) labelManager->firstPartId + labelManager->count);
+
+    if (label >= labelManager->firstPartId)
+    {
+        labelManager->offsets[label - labelManager->firstPartId] = offset;
+        return;
+    }
 
-    destroy(&labelManager->labelArray, nullptr);
+    if (labelManager->exportsCount == labelManager->exportsCapacity)
+    {
+        labelManager->exportsCapacity *= 2;
+        labelManager->exports          = (LabelExport*) realloc(labelManager->exports, 
+                                                                labelManager->exportsCapacity * sizeof(LabelExport));
+        assert(labelManager->exports);
+    }
+
+    labelManager->exports[labelManager->exportsCount++] = {label, offset};
 }
 
-void resetLabelNumbers(LabelManager* labelManager)
+int64_t getLabelOffset(const LabelManager* labelManager, LabelId label)
 {
     assert(labelManager);
+    assert(label >= labelManager->firstPartId);
+    assert((size_t) (label - labelManager->firstPartId) < labelManager->count);
 
-    for (uint32_t i = 0; i < TOTAL_LABELS; i++)
+    return labelManager->offsets[label - labelManager->firstPartId];
+}
+
+//------------------------------------------------------------------------------
+//! @return Whether the label's offset is known. Part's offsets of the program's
+//!         labels never are, so references to them always become fixups.
+//------------------------------------------------------------------------------
+bool isLabelWritten(const LabelManager* labelManager, LabelId label)
+{
+    assert(labelManager);
+
+    return label >= labelManager->firstPartId && getLabelOffset(labelManager, label) != LABEL_NOT_WRITTEN;
+}
+
+void addFixup(LabelManager* labelManager, Fixup fixup)
+{
+    assert(labelManager);
+    assert(labelManager->fixups);
+
+    if (labelManager->fixupsCount == labelManager->fixupsCapacity)
     {
-        labelManager->curLabelNumbers[i] = 0;
+        labelManager->fixupsCapacity *= 2;
+        labelManager->fixups          = (Fixup*) realloc(labelManager->fixups, 
+                                                         labelManager->fixupsCapacity * sizeof(Fixup));
+        assert(labelManager->fixups);
+    }
+
+    labelManager->fixups[labelManager->fixupsCount++] = fixup;
+}
+
+void addBranch(LabelManager* labelManager, Branch branch)
+{
+    assert(labelManager);
+    assert(labelManager->branches);
+
+    if (labelManager->branchesCount == labelManager->branchesCapacity)
+    {
+        labelManager->branchesCapacity *= 2;
+        labelManager->branches          = (Branch*) realloc(labelManager->branches, 
+                                                            labelManager->branchesCapacity * sizeof(Branch));
+        assert(labelManager->branches);
+    }
+
+    labelManager->branches[labelManager->branchesCount++] = branch;
+}
+
+void addLabelSymbol(LabelManager* labelManager, LabelSymbol symbol)
+{
+    assert(labelManager);
+    assert(labelManager->symbols);
+
+    if (labelManager->symbolsCount == labelManager->symbolsCapacity)
+    {
+        labelManager->symbolsCapacity *= 2;
+        labelManager->symbols          = (LabelSymbol*) realloc(labelManager->symbols, 
+                                                                labelManager->symbolsCapacity * sizeof(LabelSymbol));
+        assert(labelManager->symbols);
+    }
+
+    labelManager->symbols[labelManager->symbolsCount++] = symbol;
+}
+
+//------------------------------------------------------------------------------
+//! Appends the labels, fixups and symbols of the part (see constructPart()), 
+//! whose code is placed at the offset, to the program's ones. The part's 
+//! branches have to be encoded by then.
+//!
+//! @return Shift of the part's own labels' ids (see mergedLabelId()).
+//------------------------------------------------------------------------------
+LabelId mergePart(LabelManager* labelManager, const LabelManager* part, uint64_t offset)
+{
+    assert(labelManager);
+    assert(part);
+    assert(part->program == labelManager);
+    assert(part->branchesCount == 0);
+
+    LabelId shift = newLabelIds(labelManager, part->count) - part->firstPartId;
+
+    for (size_t i = 0; i < part->count; i++)
+    {
+        int64_t partOffset = part->offsets[i];
+        setLabelOffset(labelManager, part->firstPartId + (LabelId) i + shift, 
+                       partOffset != LABEL_NOT_WRITTEN ? partOffset + (int64_t) offset : LABEL_NOT_WRITTEN);
+    }
+
+    for (size_t i = 0; i < part->exportsCount; i++)
+    {
+        LabelExport labelExport = part->exports[i];
+        setLabelOffset(labelManager, labelExport.label, labelExport.offset + (int64_t) offset);
+    }
+
+    for (size_t i = 0; i < part->fixupsCount; i++)
+    {
+        Fixup fixup = part->fixups[i];
+        addFixup(labelManager, {fixup.offset + offset, mergedLabelId(part, fixup.label, shift), fixup.type});
     }
-}
\ No newline at end of file
+
+    for (size_t i = 0; i < part->symbolsCount; i++)
+    {
+        LabelSymbol symbol = part->symbols[i];
+        symbol.label.id    = mergedLabelId(part, symbol.label.id, shift);
+
+        addLabelSymbol(labelManager, symbol);
+    }
+
+    return shift;
+}
@@ -2,6 +2,7 @@
 #define LABEL_H
 
 #include <stdint.h>
+#include "../symbol_table/names_index.h"
 
 enum LabelPurposeType
 {
@@ -12,42 +13,134 @@ enum LabelPurposeType
     TOTAL_LABELS
 };
 
+typedef int32_t LabelId;
+
+static const size_t  LABEL_MANAGER_INITIAL_CAPACITY = 256;
+static const size_t  LABEL_EXPORTS_INITIAL_CAPACITY = 16;
+static const int64_t LABEL_NOT_WRITTEN              = -1;
+
+enum FixupType
+{
+    FIXUP_REL32, /* jump's displacement from the end of the field */
+    FIXUP_ABS64  /* label's virtual address */
+};
+
+//------------------------------------------------------------------------------
+//! Reference to a label which wasn't written yet. The field is filled in once
+//! the whole program is emitted and all the labels' offsets are known.
+//------------------------------------------------------------------------------
+struct Fixup
+{
+    uint64_t  offset; /* of the field in the binary file */
+    LabelId   label;
+    FixupType type;
+};
+
+//------------------------------------------------------------------------------
+//! Jump or call, which is emitted in its rel32 form and encoded only after the
+//! whole text is emitted, so that it could be shortened to rel8 (used when the
+//! code is optimized for size).
+//------------------------------------------------------------------------------
+struct Branch
+{
+    uint64_t offset;      /* of the instruction in the binary file */
+    LabelId  label;
+    uint8_t  longSize;    /* of the rel32 form */
+    uint8_t  shortOpcode; /* of the rel8 form or 0 if there is no such form */
+    bool     isShort;
+};
+
 struct Label
 {
-    /* Label's offset in the binary file. */
-    int64_t offset; 
+    /* Index of the label's offset in the LabelManager. */
+    LabelId     id;
 
-    /* Label's name in the format: 
-     * <functionName><name><number> (e.g. "main.WHILE_9").
-     * If number is -1, then it is not used. */
-    const char* functionName;
+    /* Label's name in the NASM listing in the format <name><number>
+     * (e.g. ".WHILE_9"). If number is -1, then it is not used. */
     const char* name;
     int32_t     number;
 };
 
-#define STRUCT   LabelArray
-#define ELEMENTS labels
-#define INSERT   insertLabel
-#define FIND     findLabel
-#define elem_t   Label
+//------------------------------------------------------------------------------
+//! Written label, which becomes a symbol of the ELF file.
+//------------------------------------------------------------------------------
+struct LabelSymbol
+{
+    Label       label;
+    const char* function; /* the local label (e.g. ".WHILE_9") is in */
+};
 
-#undef DYNAMIC_ARRAY_H
-#include "../../libs/dynamic_array/dynamic_array.h"
-#undef STRUCT             
-#undef ELEMENTS      
-#undef INSERT             
-#undef FIND               
-#undef elem_t
+//------------------------------------------------------------------------------
+//! Label of the program written by a part (see constructPart()), e.g. the 
+//! label of a function compiled by the part.
+//------------------------------------------------------------------------------
+struct LabelExport
+{
+    LabelId label;
+    int64_t offset; /* in the part */
+};
 
 struct LabelManager
 {
-    LabelArray labelArray;
+    /* Label id - firstPartId -> label's offset in the binary file or 
+     * LABEL_NOT_WRITTEN. */
+    int64_t*   offsets;
+    size_t     count;
+    size_t     capacity;
+
+    /* Labels of functions, strings etc. are allocated once, by their names. */
+    NamesIndex namedLabels;
+
+    /* Manager of the whole program if this one is a part's (see constructPart()),
+     * otherwise nullptr. Ids below firstPartId are the program's labels. */
+    const LabelManager* program;
+    LabelId             firstPartId;
+
+    LabelExport* exports;
+    size_t       exportsCount;
+    size_t       exportsCapacity;
+
+    Fixup*     fixups;
+    size_t     fixupsCount;
+    size_t     fixupsCapacity;
+
+    Branch*    branches;
+    size_t     branchesCount;
+    size_t     branchesCapacity;
+
+    /* In the order of writing, which is the order of the offsets. */
+    LabelSymbol* symbols;
+    size_t       symbolsCount;
+    size_t       symbolsCapacity;
+
     int32_t    curLabelNumbers[TOTAL_LABELS];
 };
 
-int  cmpLabels         (Label firstLabel, Label secondLabel);
-void construct         (LabelManager* labelManager);
-void destroy           (LabelManager* labelManager);
-void resetLabelNumbers (LabelManager* labelManager);
+void    construct         (LabelManager* labelManager);
+void    constructPart     (LabelManager* labelManager, const LabelManager* program);
+void    destroy           (LabelManager* labelManager);
+LabelId mergePart         (LabelManager* labelManager, const LabelManager* part, uint64_t offset);
+void    resetLabelNumbers (LabelManager* labelManager);
+
+LabelId newLabelIds       (LabelManager* labelManager, size_t count);
+LabelId newLabelId        (LabelManager* labelManager);
+LabelId namedLabelId      (LabelManager* labelManager, const char* name);
+
+void    setLabelOffset    (LabelManager* labelManager, LabelId label, int64_t offset);
+int64_t getLabelOffset    (const LabelManager* labelManager, LabelId label);
+bool    isLabelWritten    (const LabelManager* labelManager, LabelId label);
+void    addFixup          (LabelManager* labelManager, Fixup fixup);
+void    addBranch         (LabelManager* labelManager, Branch branch);
+void    addLabelSymbol    (LabelManager* labelManager, LabelSymbol symbol);
+
+//------------------------------------------------------------------------------
+//! @param shift Returned by mergePart() for the part.
+//!
+//! @return Id in the program of the part's label.
+//------------------------------------------------------------------------------
+inline LabelId mergedLabelId(const LabelManager* part, LabelId label, LabelId shift)
+{
+    return label < part->firstPartId ? label : label + shift;
+}
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,194 @@
+#include <stdlib.h>
+#include <string.h>
+#include "listing_writer.h"
+
+const size_t MAX_DECIMAL_LENGTH = 20; /* digits of UINT64_MAX */
+
+void makeListingSpace(ListingWriter* writer, size_t bytesNeeded);
+
+void makeListingSpace(ListingWriter* writer, size_t bytesNeeded)
+{
+    ASSERT_LISTING_WRITER(writer);
+    assert(bytesNeeded <= LISTING_BUFFER_CAPACITY);
+
+    if (writer->size + bytesNeeded > LISTING_BUFFER_CAPACITY)
+    {
+        flush(writer);
+    }
+}
+
+void construct(ListingWriter* writer, FILE* file)
+{
+    assert(writer);
+    assert(file);
+
+    writer->file   = file;
+    writer->buffer = (char*) calloc(LISTING_BUFFER_CAPACITY, sizeof(char));
+    writer->size   = 0;
+    assert(writer->buffer);
+}
+
+void destroy(ListingWriter* writer)
+{
+    assert(writer);
+
+    if (writer->buffer != nullptr)
+    {
+        flush(writer);
+        free(writer->buffer);
+    }
+
+    writer->file   = nullptr;
+    writer->buffer = nullptr;
+    writer->size   = 0;
+}
+
+void flush(ListingWriter* writer)
+{
+    ASSERT_LISTING_WRITER(writer);
+
+    if (writer->size == 0) { return; }
+
+    fwrite(writer->buffer, sizeof(char), writer->size, writer->file);
+    writer->size = 0;
+}
+
+void writeChars(ListingWriter* writer, const char* chars, size_t count)
+{
+    ASSERT_LISTING_WRITER(writer);
+    assert(chars);
+
+    /* Doesn't make sense to copy chunks that don't fit even an empty buffer. */
+    if (count > LISTING_BUFFER_CAPACITY)
+    {
+        flush(writer);
+        fwrite(chars, sizeof(char), count, writer->file);
+        return;
+    }
+
+    makeListingSpace(writer, count);
+    memcpy(writer->buffer + writer->size, chars, count);
+    writer->size += count;
+}
+
+void writeString(ListingWriter* writer, const char* string)
+{
+    ASSERT_LISTING_WRITER(writer);
+    assert(string);
+
+    writeChars(writer, string, strlen(string));
+}
+
+void writeRepeated(ListingWriter* writer, char symbol, size_t count)
+{
+    ASSERT_LISTING_WRITER(writer);
+
+    while (count > 0)
+    {
+        size_t chunk = count < LISTING_BUFFER_CAPACITY ? count : LISTING_BUFFER_CAPACITY;
+
+        makeListingSpace(writer, chunk);
+        memset(writer->buffer + writer->size, symbol, chunk);
+        writer->size += chunk;
+
+        count -= chunk;
+    }
+}
+
+void writeDecimal(ListingWriter* writer, int64_t number)
+{
+    ASSERT_LISTING_WRITER(writer);
+
+    if (number < 0)
+    {
+        writeChars(writer, "-", 1);
+        writeUnsignedDecimal(writer, -(uint64_t) number);
+    }
+    else
+    {
+        writeUnsignedDecimal(writer, (uint64_t) number);
+    }
+}
+
+void writeUnsignedDecimal(ListingWriter* writer, uint64_t number)
+{
+    ASSERT_LISTING_WRITER(writer);
+
+    char  digits[MAX_DECIMAL_LENGTH] = {};
+    char* first = digits + MAX_DECIMAL_LENGTH;
+
+    do
+    {
+        *--first = (char) ('0' + number % 10);
+        number /= 10;
+    } while (number != 0);
+
+    writeChars(writer, first, (size_t) (digits + MAX_DECIMAL_LENGTH - first));
+}
+
+//------------------------------------------------------------------------------
+//! Small replacement of vfprintf() which knows only the conversions used by
+//! the compiler: %s, %c, %%, and %d and %u with the h, hh, l, ll and z length
+//! modifiers (which is what PRId8, PRIu32, PRId64 etc. expand to). Neither
+//! flags nor field width are supported.
+//------------------------------------------------------------------------------
+void writeFormatted(ListingWriter* writer, const char* format, va_list args)
+{
+    ASSERT_LISTING_WRITER(writer);
+    assert(format);
+
+    while (*format != '\0')
+    {
+        const char* literal = format;
+        while (*format != '\0' && *format != '%') { format++; }
+
+        writeChars(writer, literal, (size_t) (format - literal));
+        if (*format == '\0') { break; }
+
+        format++;
+
+        bool isLong = false;
+        while (*format == 'h' || *format == 'l' || *format == 'z')
+        {
+            if (*format != 'h') { isLong = true; }
+            format++;
+        }
+
+        assert(*format != '\0');
+        if (*format == '\0') { break; }
+
+        switch (*format)
+        {
+            case 's':
+                writeString(writer, va_arg(args, const char*));
+                break;
+
+            case 'c':
+            {
+                char symbol = (char) va_arg(args, int);
+                writeChars(writer, &symbol, 1);
+                break;
+            }
+
+            case 'd':
+                if (isLong) { writeDecimal(writer, va_arg(args, int64_t)); }
+                else        { writeDecimal(writer, va_arg(args, int));     }
+                break;
+
+            case 'u':
+                if (isLong) { writeUnsignedDecimal(writer, va_arg(args, uint64_t));     }
+                else        { writeUnsignedDecimal(writer, va_arg(args, unsigned int)); }
+                break;
+
+            case '%':
+                writeChars(writer, "%", 1);
+                break;
+
+            default:
+                assert(!"Unsupported conversion in the listing's format");
+                break;
+        }
+
+        format++;
+    }
+}
@@ -0,0 +1,37 @@
+#ifndef LISTING_WRITER_H
+#define LISTING_WRITER_H
+
+#include <assert.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define ASSERT_LISTING_WRITER(writer) assert(writer);         \
+                                      assert(writer->file);   \
+                                      assert(writer->buffer);
+
+static const size_t LISTING_BUFFER_CAPACITY = 1 << 16;
+
+//------------------------------------------------------------------------------
+//! Text of the NASM listing, which is gathered in a buffer and written to the
+//! file in blocks of LISTING_BUFFER_CAPACITY bytes.
+//------------------------------------------------------------------------------
+struct ListingWriter
+{
+    FILE*  file;
+    char*  buffer;
+    size_t size;
+};
+
+void construct             (ListingWriter* writer, FILE* file);
+void destroy               (ListingWriter* writer);
+void flush                 (ListingWriter* writer);
+
+void writeChars            (ListingWriter* writer, const char* chars, size_t count);
+void writeString           (ListingWriter* writer, const char* string);
+void writeRepeated         (ListingWriter* writer, char symbol, size_t count);
+void writeDecimal          (ListingWriter* writer, int64_t number);
+void writeUnsignedDecimal  (ListingWriter* writer, uint64_t number);
+void writeFormatted        (ListingWriter* writer, const char* format, va_list args);
+
+#endif
@@ -0,0 +1,94 @@
+#include <assert.h>
+#include "reachability.h"
+
+void markUsedString (SymbolTable* table, const CompactTree* tree, NodeIndex node);
+
+void markReachableSymbols(SymbolTable* table, const CompactTree* tree)
+{
+    assert(table);
+    assert(tree);
+
+    Function* functions      = table->functionsData.functions;
+    size_t    functionsCount = table->functionsData.count;
+
+    /* Function's index -> its declaration in the tree. */
+    NodeIndex* declarations = (NodeIndex*) calloc(functionsCount + 1, sizeof(NodeIndex));
+    int*       stack        = (int*)       calloc(functionsCount + 1, sizeof(int));
+    assert(declarations && stack);
+
+    size_t declarationsCount = 0;
+    for (NodeIndex declaration = tree->root; declaration != NO_NODE; declaration = leftChild(tree, declaration))
+    {
+        if (nodeType(tree, declaration) == FDECL_TYPE) { declarations[declarationsCount++] = declaration; }
+    }
+    assert(declarationsCount == functionsCount);
+
+    for (size_t i = 0; i < functionsCount; i++) { functions[i].isReachable = false; }
+
+    for (size_t i = 0; i < table->stringsData.count; i++) { table->stringsData.strings[i].isReachable = false; }
+
+    size_t stackSize    = 0;
+    int    mainFunction = findIndexedName(&table->functionsIndex, intern(MAIN_FUNCTION_NAME));
+
+    if (mainFunction != -1)
+    {
+        functions[mainFunction].isReachable = true;
+        stack[stackSize++]                  = mainFunction;
+    }
+
+    /* Every function is pushed once, when it's found to be reachable. */
+    while (stackSize > 0)
+    {
+        NodeIndex declaration = declarations[stack[--stackSize]];
+        NodeIndex end         = declarationEnd(tree, declaration);
+
+        for (NodeIndex node = declaration + 1; node < end; node++)
+        {
+            markUsedString(table, tree, node);
+            if (nodeType(tree, node) != CALL_TYPE) { continue; }
+
+            const char* name   = nodeData(tree, leftChild(tree, node)).id.name;
+            int         callee = findIndexedName(&table->functionsIndex, name);
+
+            if (callee != -1 && !functions[callee].isReachable)
+            {
+                functions[callee].isReachable = true;
+                stack[stackSize++]            = callee;
+            }
+        }
+    }
+
+    free(declarations);
+    free(stack);
+}
+
+//------------------------------------------------------------------------------
+//! Marks the string used by the node (as a literal or by its name) if any.
+//------------------------------------------------------------------------------
+void markUsedString(SymbolTable* table, const CompactTree* tree, NodeIndex node)
+{
+    assert(table);
+    assert(tree);
+
+    int string = NO_STRING;
+
+    switch (nodeType(tree, node))
+    {
+        case STRING_TYPE:
+        {
+            string = getStringByContent(table, nodeData(tree, node).string);
+            break;
+        }
+
+        case ID_TYPE:
+        {
+            IdData id = nodeData(tree, node).id;
+            if (id.varSlot == NO_VAR_SLOT) { string = getStringByName(table, id.name); }
+            break;
+        }
+
+        default: { break; }
+    }
+
+    if (string != NO_STRING) { table->stringsData.strings[string].isReachable = true; }
+}
@@ -0,0 +1,23 @@
+//------------------------------------------------------------------------------
+//! Whole-program reachability of functions and strings, which lets the 
+//! compiler skip the ones that can never be used.
+//!
+//! @file   reachability.h
+//------------------------------------------------------------------------------
+
+#ifndef REACHABILITY_H
+#define REACHABILITY_H
+
+#include "../symbol_table/symbol_table.h"
+#include "../parser/expression_tree.h"
+
+//------------------------------------------------------------------------------
+//! Builds the call graph of the program's functions and marks the functions 
+//! reachable from main, as well as the strings they use, as isReachable.
+//!
+//! @param table Has to contain the tree's functions in the order of their 
+//!              declarations.
+//------------------------------------------------------------------------------
+void markReachableSymbols (SymbolTable* table, const CompactTree* tree);
+
+#endif
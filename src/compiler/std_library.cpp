@@ -0,0 +1,59 @@
+#include <assert.h>
+#include <string.h>
+#include "std_library.h"
+#include "../parser/syntax.h"
+
+#define STD_LIBRARY(FUNCTION) FUNCTION(accio_bombarda)    \
+                              FUNCTION(accio)             \
+                              FUNCTION(flagrate_bombarda) \
+                              FUNCTION(flagrate_s)        \
+                              FUNCTION(flagrate)          \
+                              FUNCTION(crucio)
+
+/* The files are found by the assembler, which has to be given the library's 
+ * directory with -Wa,-I (see the Makefile). */
+#define EMBED_FILE(symbol, filename) ".global std_" #symbol "\n"     \
+                                     "std_" #symbol ":\n"            \
+                                     ".incbin \"" filename "\"\n"    \
+                                     ".global std_" #symbol "_end\n" \
+                                     "std_" #symbol "_end:\n"
+
+#define EMBED_STD_FUNCTION(name) EMBED_FILE(name##_bytecode, #name ".bytecode") \
+                                 EMBED_FILE(name##_nasm,     #name ".nasm")
+
+__asm__(".pushsection .rodata\n"
+        STD_LIBRARY(EMBED_STD_FUNCTION)
+        ".popsection\n");
+
+#define DECLARE_STD_FUNCTION(name) extern "C" const uint8_t std_##name##_bytecode[];     \
+                                   extern "C" const uint8_t std_##name##_bytecode_end[]; \
+                                   extern "C" const char    std_##name##_nasm[];         \
+                                   extern "C" const char    std_##name##_nasm_end[];
+
+STD_LIBRARY(DECLARE_STD_FUNCTION)
+
+#define STD_FUNCTION_CODE(name) { #name,                                                          \
+                                  std_##name##_bytecode,                                          \
+                                  (size_t) (std_##name##_bytecode_end - std_##name##_bytecode),   \
+                                  std_##name##_nasm,                                              \
+                                  (size_t) (std_##name##_nasm_end - std_##name##_nasm) },
+
+static const StdFunctionCode STD_FUNCTIONS_CODE[] = { STD_LIBRARY(STD_FUNCTION_CODE) };
+
+static_assert(sizeof(STD_FUNCTIONS_CODE) / sizeof(StdFunctionCode) == STANDARD_FUNCTIONS_COUNT,
+              "Every standard function has to be embedded");
+
+const StdFunctionCode* getStdFunctionCode(const char* workingName)
+{
+    assert(workingName);
+
+    for (size_t i = 0; i < STANDARD_FUNCTIONS_COUNT; i++)
+    {
+        if (strcmp(STD_FUNCTIONS_CODE[i].workingName, workingName) == 0)
+        {
+            return &STD_FUNCTIONS_CODE[i];
+        }
+    }
+
+    return nullptr;
+}
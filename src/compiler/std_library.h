@@ -0,0 +1,32 @@
+//------------------------------------------------------------------------------
+//! Machine code and NASM listings of the standard functions, which are 
+//! embedded in the compiler from potter_tongue_libs/io at build time.
+//!
+//! @file   std_library.h
+//------------------------------------------------------------------------------
+
+#ifndef STD_LIBRARY_H
+#define STD_LIBRARY_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+struct StdFunctionCode
+{
+    const char*    workingName;
+
+    const uint8_t* bytecode;
+    size_t         bytecodeSize;
+
+    const char*    nasm;
+    size_t         nasmSize;
+};
+
+//------------------------------------------------------------------------------
+//! @param workingName One of STANDARD_FUNCTIONS' working names.
+//!
+//! @return Code of the standard function or nullptr if there is no such one.
+//------------------------------------------------------------------------------
+const StdFunctionCode* getStdFunctionCode(const char* workingName);
+
+#endif
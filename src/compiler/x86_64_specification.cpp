@@ -242,6 +242,20 @@ bool setMemoryAddressing(Instruction_x86_64* instruction, Mem64 memory)
     return true;
 }
 
+void shortenDisplacement(Instruction_x86_64* instruction)
+{
+    assert(instruction);
+
+    if (!instruction->isModrmUsed || instruction->modrm.mod != 0b10) { return; }
+
+    int32_t displacement = instruction->disp.disp32;
+    if (displacement < INT8_MIN || displacement > INT8_MAX)          { return; }
+
+    instruction->modrm.mod  = 0b01;
+    instruction->dispSize   = 1;
+    instruction->disp.disp8 = (int8_t) displacement;
+}
+
 const char* reg64ToString(Reg64 reg)
 {
     assert(reg < TOTAL_REGISTERS_64);
@@ -249,6 +263,13 @@ const char* reg64ToString(Reg64 reg)
     return REGISTERS_64_STRINGS[reg];
 }
 
+const char* reg32ToString(Reg64 reg)
+{
+    assert(reg < TOTAL_REGISTERS_64);
+
+    return REGISTERS_32_STRINGS[reg];
+}
+
 Mem64 mem64BaseDisp(Reg64 base, int32_t displacement) 
 {
     Mem64 address        = {};
@@ -36,6 +36,15 @@ static const char* REGISTERS_64_STRINGS[TOTAL_REGISTERS_64] =
     "r8",  "r9",  "r10", "r11", "r12", "r13", "r14", "r15"
 };
 
+//------------------------------------------------------------------------------
+//! String representations of the lower 32-bit halves of 64-bit registers.
+//------------------------------------------------------------------------------
+static const char* REGISTERS_32_STRINGS[TOTAL_REGISTERS_64] = 
+{
+    "eax", "ecx", "edx", "ebx", "esp", "ebp", "esi", "edi",
+    "r8d", "r9d", "r10d", "r11d", "r12d", "r13d", "r14d", "r15d"
+};
+
 //------------------------------------------------------------------------------
 //! Specifies memory-addressing used in several instructions. If all the fields
 //! are used then the address is calculated the following way: 
@@ -207,6 +216,10 @@ struct Instruction_x86_64
     Immediate    imm;
 };
 
+/* Rex, opcode, modrm, sib, and the largest displacement and immediate. */
+static const size_t INSTRUCTION_MAX_SIZE = 1 + OPCODE_MAX_SIZE + 1 + 1 + 
+                                           sizeof(Displacement) + sizeof(Immediate);
+
 //------------------------------------------------------------------------------
 //! @param reg
 //! 
@@ -360,6 +373,14 @@ void updateSibBase(Instruction_x86_64* instruction, Reg64 reg);
 //------------------------------------------------------------------------------
 bool setMemoryAddressing(Instruction_x86_64* instruction, Mem64 memory);
 
+//------------------------------------------------------------------------------
+//! Replaces disp32 of the base + disp32 addressing (MODRM.mod = 0b10) with 
+//! disp8 (MODRM.mod = 0b01) if the displacement fits in it.
+//! 
+//! @param instruction
+//------------------------------------------------------------------------------
+void shortenDisplacement(Instruction_x86_64* instruction);
+
 //------------------------------------------------------------------------------
 //! @param reg
 //! 
@@ -368,6 +389,14 @@ bool setMemoryAddressing(Instruction_x86_64* instruction, Mem64 memory);
 //------------------------------------------------------------------------------
 const char* reg64ToString(Reg64 reg);
 
+//------------------------------------------------------------------------------
+//! @param reg
+//! 
+//! @return String representation of the lower half of reg using lower-case 
+//!         ASCII characters, for example "edi" if reg = RDI.
+//------------------------------------------------------------------------------
+const char* reg32ToString(Reg64 reg);
+
 //------------------------------------------------------------------------------
 //! @param base
 //! @param displacement
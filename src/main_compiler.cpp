@@ -2,8 +2,13 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
 
 #include "parser/tokenizer.h"
+#include "parser/char_scanner.h"
+#include "parser/source_file.h"
 #include "parser/parser.h"
 #include "compiler/compiler.h"
 #include <file_manager/file_manager.h>
@@ -20,7 +25,14 @@ enum Error
     INPUT_LOAD_FAILED,
     OUTPUT_LOAD_FAILED,
     NASM_OUTPUT_LOAD_FAILED,
-    COMPILATION_FAILED
+    COMPILATION_FAILED,
+
+    /* The errors are the exit codes, so the new ones go after the old ones. */
+    JOBS_COUNT_INVALID,
+    CACHE_DIR_UNSPECIFIED,
+    MANIFEST_UNSPECIFIED,
+    BATCH_FLAG_UNSUPPORTED,
+    MANIFEST_LOAD_FAILED
 };
 
 enum Flag
@@ -33,6 +45,13 @@ enum Flag
     FLAG_TREE_DUMP,
     FLAG_SYMB_TABLE_DUMP,
     FLAG_USE_NUMERICS,
+    FLAG_LEXER_BENCHMARK,
+    FLAG_JOBS,
+    FLAG_SIZE_OPTIMIZATION,
+    FLAG_MAP_OUTPUT,
+    FLAG_DEBUG_INFO,
+    FLAG_CACHE_DIR,
+    FLAG_BATCH,
     FLAG_HELP,
     FLAG_OUTPUT,
 
@@ -47,9 +66,68 @@ struct FlagManager
     const char*  input;
     const char*  output;
     const char*  nasmOutput;
+    const char*  cacheDir;
+    const char*  manifest;
+    size_t       jobsCount;
     bool         flagEnabled[TOTAL_FLAGS];
 };
 
+//------------------------------------------------------------------------------
+//! Program to compile, either the one given by the flags or one of the batch's.
+//------------------------------------------------------------------------------
+struct SourceJob
+{
+    const char* input;
+    const char* output;
+    const char* nasmOutput;    /* nullptr if the listing isn't needed */
+    char*       defaultOutput; /* output made of the input's name, if any */
+    FILE*       errorsFile;    /* where the program's errors are reported */
+
+    /* Errors gathered while compiling the batch (see compileBatchJobs()). */
+    char*       errors;
+    size_t      errorsSize;
+
+    Error       result;
+    size_t      cacheHits;
+    size_t      cacheMisses;
+};
+
+//------------------------------------------------------------------------------
+//! Programs of the batch, which the threads take one by one.
+//------------------------------------------------------------------------------
+struct BatchQueue
+{
+    FlagManager     flagManager;
+
+    char*           text;     /* manifest, which the names point into */
+    SourceJob*      jobs;
+    size_t          jobsCount;
+
+    pthread_mutex_t lock;
+    size_t          nextJob;
+};
+
+//------------------------------------------------------------------------------
+//! The program's outputs kept in the cache's directory (see --cache-dir) in a 
+//! pack of their own, which are taken from there without even parsing the 
+//! program if it didn't change.
+//------------------------------------------------------------------------------
+struct CachedOutputs
+{
+    CacheBuffer key;  /* the source, its name and the options */
+    CachePack   pack;
+};
+
+//------------------------------------------------------------------------------
+//! Beginning of the outputs' data, followed by the ELF file and the listing.
+//------------------------------------------------------------------------------
+struct CachedOutputsHeader
+{
+    uint64_t elfSize;
+    uint64_t nasmSize;
+    uint64_t functionsCount; /* reported as the cache's hits */
+};
+
 struct FlagSpecification
 {
     Flag        flag;
@@ -66,17 +144,51 @@ Error processFlagOpenGraphDump     (FlagManager* flagManager);
 Error processFlagTreeDump          (FlagManager* flagManager);
 Error processFlagSymbTableDump     (FlagManager* flagManager);
 Error processFlagUseNumerics       (FlagManager* flagManager);
+Error processFlagLexerBenchmark    (FlagManager* flagManager);
+Error processFlagJobs              (FlagManager* flagManager);
+Error processFlagSizeOptimization  (FlagManager* flagManager);
+Error processFlagMapOutput         (FlagManager* flagManager);
+Error processFlagDebugInfo         (FlagManager* flagManager);
+Error processFlagCacheDir          (FlagManager* flagManager);
+Error processFlagBatch             (FlagManager* flagManager);
 Error processFlagHelp              (FlagManager* flagManager);
 Error processFlagOutput            (FlagManager* flagManager);
 
 Error processFlags  (FlagManager* flagManager);
 void  printHelp     ();
-Error compile       (const FlagManager* flagManager);
+Error compile       (const FlagManager* flagManager, SourceJob* job);
+Error writeProgram  (const FlagManager* flagManager, SourceJob* job, Node* tree, SymbolTable* table);
+Error compileBatch  (const FlagManager* flagManager);
+bool  readManifest  (BatchQueue* queue, const char* manifest);
+char* defaultOutput (const char* input);
+void  destroy       (BatchQueue* queue);
 void  makeGraphDump (const FlagManager* flagManager, const Node* tree, bool detailed);
 
+bool  openCachedOutputs  (CachedOutputs* outputs, const FlagManager* flagManager, const SourceJob* job, 
+                          const SourceFile* source);
+bool  writeCachedOutputs (const CachedOutputs* outputs, SourceJob* job, Error* result);
+void  storeCachedOutputs (const CachedOutputs* outputs, const SourceJob* job);
+void  destroy            (CachedOutputs* outputs);
+void  benchLexer    (const FlagManager* flagManager, const char* buffer, size_t bufferSize);
+
+typedef void (*SourceScan) (const char* buffer, size_t bufferSize);
+
+void   scanLines  (const char* buffer, size_t bufferSize);
+void   scanTokens (const char* buffer, size_t bufferSize);
+double benchScan  (SourceScan scan, const char* buffer, size_t bufferSize);
+
+static void* compileBatchJobs (void* batchQueue);
+
 const char*  DEFAULT_OUTPUT      = "a.asm";
 const size_t MAX_FILENAME_LENGTH = 128;
 const size_t MAX_COMMAND_LENGTH  = 256;
+const size_t BENCH_MIN_RUNS      = 3;
+const double BENCH_MIN_SECONDS   = 0.5;
+
+const size_t BATCH_INITIAL_CAPACITY   = 16;
+const size_t BATCH_MAX_THREADS        = 64;
+const size_t MANIFEST_FIELDS_COUNT    = 3;
+const char   BATCH_OUTPUT_EXTENSION[] = ".elf";
 
 const char* FLAGS_HELP_MESSAGES[TOTAL_FLAGS] = 
 {
@@ -127,6 +239,42 @@ const char* FLAGS_HELP_MESSAGES[TOTAL_FLAGS] =
     /*==========FLAG_USE_NUMERICS=========*/
     "\tAllow using numbers (e.g. '3' instead of 'tria', or '22').\n",
 
+    /*========FLAG_LEXER_BENCHMARK========*/
+    "\tTokenize the input repeatedly with every supported scanning level (scalar, sse2)\n"
+    "\tand print the lexer's throughput in MB/s before compiling it, as well as the throughput\n"
+    "\tof the scanning functions alone: finding the new lines and walking the tokens\n"
+    "\t(spaces, identifiers and quoted strings).\n",
+
+    /*=============FLAG_JOBS=============*/
+    "\tTokenize the input and compile the functions with up to the specified number of threads,\n"
+    "\tsplitting the input at new lines and the program between functions.\n"
+    "\tOnly inputs of several hundred kilobytes and bigger are split.\n",
+
+    /*=======FLAG_SIZE_OPTIMIZATION=======*/
+    "\tOptimize the code for size: use short jumps where their targets are close enough,\n"
+    "\tas well as the shortest forms of immediate constants and displacements.\n",
+
+    /*===========FLAG_MAP_OUTPUT==========*/
+    "\tWrite the program straight into the output file mapped to memory instead of copying it\n"
+    "\tthere at the end. Falls back to the usual writing if the file can't be mapped.\n",
+
+    /*===========FLAG_DEBUG_INFO==========*/
+    "\tWrite DWARF debug info: the source line of every statement (.debug_line) and\n"
+    "\tthe frames of the functions (.debug_frame), so that debuggers can show and unwind them.\n",
+
+    /*===========FLAG_CACHE_DIR===========*/
+    "\tKeep the compiled functions in the specified directory and take the unchanged ones from there\n"
+    "\tinstead of compiling them again. The outputs of a program which didn't change at all are\n"
+    "\ttaken from there without compiling it. Prints the numbers of the functions found (hits)\n"
+    "\tand compiled (misses).\n",
+
+    /*=============FLAG_BATCH=============*/
+    "\tCompile every program listed in the specified manifest, one per line in the format\n"
+    "\t'<program> [<ELF file> [<NASM listing>]]'. The ELF file is by default the program's name\n"
+    "\twith the extension replaced by '.elf'. Empty lines and lines starting with '#' are skipped.\n"
+    "\tWith -j up to the specified number of programs are compiled at once, each in one thread.\n"
+    "\tDumps, -S and -o aren't supported in this mode.\n",
+
     /*=============FLAG_HELP=============*/
     "\tPrint this message.\n",
 
@@ -176,6 +324,41 @@ const FlagSpecification FLAG_SPECIFICATIONS[TOTAL_FLAGS] =
       processFlagUseNumerics,
       FLAGS_HELP_MESSAGES[FLAG_USE_NUMERICS] },
 
+    { FLAG_LEXER_BENCHMARK,
+      "-fbench-lexer",
+      processFlagLexerBenchmark,
+      FLAGS_HELP_MESSAGES[FLAG_LEXER_BENCHMARK] },
+
+    { FLAG_JOBS,
+      "-j",
+      processFlagJobs,
+      FLAGS_HELP_MESSAGES[FLAG_JOBS] },
+
+    { FLAG_SIZE_OPTIMIZATION,
+      "-Os",
+      processFlagSizeOptimization,
+      FLAGS_HELP_MESSAGES[FLAG_SIZE_OPTIMIZATION] },
+
+    { FLAG_MAP_OUTPUT,
+      "-fmmap-output",
+      processFlagMapOutput,
+      FLAGS_HELP_MESSAGES[FLAG_MAP_OUTPUT] },
+
+    { FLAG_DEBUG_INFO,
+      "-g",
+      processFlagDebugInfo,
+      FLAGS_HELP_MESSAGES[FLAG_DEBUG_INFO] },
+
+    { FLAG_CACHE_DIR,
+      "--cache-dir",
+      processFlagCacheDir,
+      FLAGS_HELP_MESSAGES[FLAG_CACHE_DIR] },
+
+    { FLAG_BATCH,
+      "--batch",
+      processFlagBatch,
+      FLAGS_HELP_MESSAGES[FLAG_BATCH] },
+
     { FLAG_HELP,
       "-h",
       processFlagHelp,
@@ -187,6 +370,31 @@ const FlagSpecification FLAG_SPECIFICATIONS[TOTAL_FLAGS] =
       FLAGS_HELP_MESSAGES[FLAG_OUTPUT] },      
 };
 
+//------------------------------------------------------------------------------
+//! Flags which work in the batch mode. The rest either write to the same files
+//! for every program or have their files set for the whole run.
+//------------------------------------------------------------------------------
+const bool FLAGS_ALLOWED_IN_BATCH[TOTAL_FLAGS] = 
+{
+    /* FLAG_NASM_DUMP           */ false,
+    /* FLAG_TOKEN_DUMP          */ false,
+    /* FLAG_SIMPLE_GRAPH_DUMP   */ false,
+    /* FLAG_DETAILED_GRAPH_DUMP */ false,
+    /* FLAG_OPEN_GRAPH_DUMP     */ false,
+    /* FLAG_TREE_DUMP           */ false,
+    /* FLAG_SYMB_TABLE_DUMP     */ false,
+    /* FLAG_USE_NUMERICS        */ true,
+    /* FLAG_LEXER_BENCHMARK     */ false,
+    /* FLAG_JOBS                */ true,
+    /* FLAG_SIZE_OPTIMIZATION   */ true,
+    /* FLAG_MAP_OUTPUT          */ true,
+    /* FLAG_DEBUG_INFO          */ true,
+    /* FLAG_CACHE_DIR           */ true,
+    /* FLAG_BATCH               */ true,
+    /* FLAG_HELP                */ true,
+    /* FLAG_OUTPUT              */ false,
+};
+
 #include "compiler/x86_64_specification.h"
 
 int main(int argc, const char* argv[])
@@ -194,6 +402,7 @@ int main(int argc, const char* argv[])
     FlagManager flagManager = {};
     flagManager.argc = argc;
     flagManager.argv = argv;
+    flagManager.jobsCount = 1;
 
     if (argc > 1) { flagManager.input = argv[1]; }
 
@@ -203,6 +412,14 @@ int main(int argc, const char* argv[])
         return flagProcessingResult;
     }
 
+    if (flagManager.flagEnabled[FLAG_BATCH])
+    {
+        Error batchResult = compileBatch(&flagManager);
+        destroyInternPool();
+
+        return batchResult;
+    }
+
     if (flagManager.input == nullptr)
     {
         printf("Input file unspecified!\n");
@@ -211,7 +428,21 @@ int main(int argc, const char* argv[])
 
     if (flagManager.output == nullptr) { flagManager.output = DEFAULT_OUTPUT; }
 
-    return compile(&flagManager);
+    SourceJob job = {};
+    job.input      = flagManager.input;
+    job.output     = flagManager.output;
+    job.nasmOutput = flagManager.flagEnabled[FLAG_NASM_DUMP] ? flagManager.nasmOutput : nullptr;
+    job.errorsFile = stdout;
+
+    Error result = compile(&flagManager, &job);
+    if (result == NO_ERROR && flagManager.flagEnabled[FLAG_CACHE_DIR])
+    {
+        printf("Function cache: %zu hits, %zu misses\n", job.cacheHits, job.cacheMisses);
+    }
+
+    destroyInternPool();
+
+    return result;
 }
 
 Error processFlags(FlagManager* flagManager) 
@@ -313,6 +544,97 @@ Error processFlagUseNumerics(FlagManager* flagManager)
     return NO_ERROR;
 }
 
+Error processFlagLexerBenchmark(FlagManager* flagManager)
+{
+    assert(flagManager);
+
+    flagManager->flagEnabled[FLAG_LEXER_BENCHMARK] = true;
+    return NO_ERROR;
+}
+
+Error processFlagJobs(FlagManager* flagManager)
+{
+    assert(flagManager);
+
+    flagManager->flagEnabled[FLAG_JOBS] = true;
+
+    char* jobsEnd   = nullptr;
+    long  jobsCount = 0;
+
+    if (flagManager->curArg + 1 < flagManager->argc)
+    {
+        jobsCount = strtol(flagManager->argv[flagManager->curArg + 1], &jobsEnd, 10);
+    }
+
+    if (jobsEnd == nullptr || *jobsEnd != '\0' || jobsCount < 1)
+    {
+        printf("Number of jobs has to be a positive integer!\n");
+        return JOBS_COUNT_INVALID;
+    }
+
+    flagManager->jobsCount = (size_t) jobsCount;
+
+    return NO_ERROR;
+}
+
+Error processFlagSizeOptimization(FlagManager* flagManager)
+{
+    assert(flagManager);
+
+    flagManager->flagEnabled[FLAG_SIZE_OPTIMIZATION] = true;
+    return NO_ERROR;
+}
+
+Error processFlagMapOutput(FlagManager* flagManager)
+{
+    assert(flagManager);
+
+    flagManager->flagEnabled[FLAG_MAP_OUTPUT] = true;
+    return NO_ERROR;
+}
+
+Error processFlagDebugInfo(FlagManager* flagManager)
+{
+    assert(flagManager);
+
+    flagManager->flagEnabled[FLAG_DEBUG_INFO] = true;
+    return NO_ERROR;
+}
+
+Error processFlagCacheDir(FlagManager* flagManager)
+{
+    assert(flagManager);
+
+    flagManager->flagEnabled[FLAG_CACHE_DIR] = true;
+
+    if (flagManager->curArg + 1 >= flagManager->argc)
+    {
+        printf("Cache directory unspecified!\n");
+        return CACHE_DIR_UNSPECIFIED;
+    }
+
+    flagManager->cacheDir = flagManager->argv[flagManager->curArg + 1];
+
+    return NO_ERROR;
+}
+
+Error processFlagBatch(FlagManager* flagManager)
+{
+    assert(flagManager);
+
+    flagManager->flagEnabled[FLAG_BATCH] = true;
+
+    if (flagManager->curArg + 1 >= flagManager->argc)
+    {
+        printf("Manifest unspecified!\n");
+        return MANIFEST_UNSPECIFIED;
+    }
+
+    flagManager->manifest = flagManager->argv[flagManager->curArg + 1];
+
+    return NO_ERROR;
+}
+
 Error processFlagHelp(FlagManager* flagManager)
 {
     assert(flagManager);
@@ -369,26 +691,68 @@ void makeGraphDump(const FlagManager* flagManager, const Node* tree, bool detail
     }
 }
 
-Error compile(const FlagManager* flagManager)
+//------------------------------------------------------------------------------
+//! Compiles the job's program with the flags. Everything it makes is freed 
+//! and all the files it opens are closed whatever the result, so that many 
+//! programs can be compiled one after another in the same process (see 
+//! compileBatch()).
+//------------------------------------------------------------------------------
+Error compile(const FlagManager* flagManager, SourceJob* job)
 {
     assert(flagManager);
+    assert(job);
 
-    const char* input = flagManager->input;
+    const char* input = job->input;
 
-    char*  buffer     = nullptr;
-    size_t bufferSize = 0;
+    SourceFile source = {};
+    if (!loadSource(&source, input))
+    {
+        fprintf(job->errorsFile, "Couldn't load file '%s'\n", input);
+        return INPUT_LOAD_FAILED;
+    }
 
-    if (!loadFile(input, &buffer, &bufferSize))
+    if (source.size > TOKENIZER_MAX_BUFFER_SIZE)
     {
-        printf("Couldn't load file '%s'\n", input);
+        fprintf(job->errorsFile, "File '%s' is too big: %zu bytes, at most %zu are supported\n", 
+                input, source.size, TOKENIZER_MAX_BUFFER_SIZE);
+        destroy(&source);
+
         return INPUT_LOAD_FAILED;
     }
 
+    CachedOutputs outputs         = {};
+    bool          isOutputsCached = openCachedOutputs(&outputs, flagManager, job, &source);
+    Error         cachedResult    = NO_ERROR;
+
+    if (isOutputsCached && writeCachedOutputs(&outputs, job, &cachedResult))
+    {
+        destroy(&outputs);
+        destroy(&source);
+
+        return cachedResult;
+    }
+
+    const char* buffer     = source.buffer;
+    size_t      bufferSize = source.size;
+
+    if (flagManager->flagEnabled[FLAG_LEXER_BENCHMARK])
+    {
+        benchLexer(flagManager, buffer, bufferSize);
+    }
+
     Node* tree = nullptr;
 
+    /* Unless all the tokens have to be dumped or tokenized in parallel, they 
+     * are produced by the tokenizer only when the parser needs them. */
+    bool streamTokens = !flagManager->flagEnabled[FLAG_TOKEN_DUMP] && flagManager->jobsCount == 1;
+
     Tokenizer tokenizer = {};
-    construct(&tokenizer, buffer, bufferSize, flagManager->flagEnabled[FLAG_USE_NUMERICS]);
-    tokenizeBuffer(&tokenizer);
+    construct(&tokenizer, buffer, bufferSize, flagManager->flagEnabled[FLAG_USE_NUMERICS], streamTokens);
+
+    if (!streamTokens)
+    {
+        tokenizeParallel(&tokenizer, flagManager->jobsCount);
+    }
 
     if (flagManager->flagEnabled[FLAG_TOKEN_DUMP])
     {
@@ -405,12 +769,224 @@ Error compile(const FlagManager* flagManager)
 
     Parser parser = {};
     construct(&parser, &tokenizer);
+    setErrorsFile(&parser, job->errorsFile);
+
+    if (flagManager->flagEnabled[FLAG_DEBUG_INFO])
+    {
+        recordLines(&parser);
+    }
+
+    Error result = NO_ERROR;
+
     if (parseProgram(&parser, &table, &tree) != PARSE_NO_ERROR)
     {
-        printf("Couldn't compile the program.\n");
-        return COMPILATION_FAILED;
+        fprintf(job->errorsFile, "Couldn't compile the program.\n");
+        result = COMPILATION_FAILED;
+    }
+    else if (tree == nullptr)
+    {
+        /* An empty or comment-only input parses to no tree. */
+        fprintf(job->errorsFile, "File '%s' has no program\n", input);
+        result = INPUT_LOAD_FAILED;
+    }
+    else
+    {
+        result = writeProgram(flagManager, job, tree, &table);
+    }
+
+    if (isOutputsCached && result == NO_ERROR)
+    {
+        storeCachedOutputs(&outputs, job);
+    }
+
+    destroy(&outputs);
+    destroy(&table);
+    destroy(&tokenizer);
+    destroy(&parser);
+    destroy(&source);
+
+    return result;
+}
+
+//------------------------------------------------------------------------------
+//! Opens the pack of the program's outputs, unless the program has to be 
+//! parsed anyway for the dumps or the benchmark.
+//!
+//! @return Whether the outputs are cached.
+//------------------------------------------------------------------------------
+bool openCachedOutputs(CachedOutputs* outputs, const FlagManager* flagManager, const SourceJob* job, 
+                       const SourceFile* source)
+{
+    assert(outputs);
+    assert(flagManager);
+    assert(job);
+    assert(source);
+
+    const Flag PARSING_FLAGS[] = {FLAG_TOKEN_DUMP, FLAG_SIMPLE_GRAPH_DUMP, FLAG_DETAILED_GRAPH_DUMP, 
+                                  FLAG_OPEN_GRAPH_DUMP, FLAG_TREE_DUMP, FLAG_SYMB_TABLE_DUMP, 
+                                  FLAG_LEXER_BENCHMARK};
+
+    if (!flagManager->flagEnabled[FLAG_CACHE_DIR]) { return false; }
+
+    for (size_t i = 0; i < sizeof(PARSING_FLAGS) / sizeof(PARSING_FLAGS[0]); i++)
+    {
+        if (flagManager->flagEnabled[PARSING_FLAGS[i]]) { return false; }
+    }
+
+    uint32_t options = (uint32_t) flagManager->flagEnabled[FLAG_SIZE_OPTIMIZATION]   |
+                       (uint32_t) flagManager->flagEnabled[FLAG_DEBUG_INFO]     << 1 |
+                       (uint32_t) flagManager->flagEnabled[FLAG_USE_NUMERICS]   << 2 |
+                       (uint32_t) (job->nasmOutput != nullptr)                  << 3;
+
+    /* The debug info names the source as it's given. The source is big, so the
+     * key is allocated at once. */
+    size_t inputSize = strlen(job->input) + 1;
+
+    construct(&outputs->key);
+    reserveBytes(&outputs->key, sizeof(options) + inputSize + sizeof(uint64_t) + source->size);
+    outputs->key.size = 0;
+
+    appendUInt32(&outputs->key, options);
+    appendBytes (&outputs->key, job->input, inputSize);
+    appendUInt64(&outputs->key, source->size);
+    appendBytes (&outputs->key, source->buffer, source->size);
+
+    /* Unlike the functions' pack's key (see compileCached()), it ends with the name. */
+    CacheBuffer packKey = {};
+    construct(&packKey);
+
+    appendProgramPath(&packKey, job->input);
+    appendUInt32     (&packKey, options);
+    appendString     (&packKey, "outputs");
+
+    openCachePack(&outputs->pack, flagManager->cacheDir, &packKey);
+    destroy(&packKey);
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+//! Writes the outputs found in the cache, if any, instead of compiling the 
+//! program.
+//!
+//! @param result Is set to the result of writing the outputs.
+//!
+//! @return Whether the outputs are found.
+//------------------------------------------------------------------------------
+bool writeCachedOutputs(const CachedOutputs* outputs, SourceJob* job, Error* result)
+{
+    assert(outputs);
+    assert(job);
+    assert(result);
+
+    CacheSlice          data   = {};
+    CachedOutputsHeader header = {};
+
+    if (!findCacheEntry(&outputs->pack, &outputs->key, &data) || data.size < sizeof(header))
+    {
+        return false;
+    }
+
+    memcpy(&header, data.bytes, sizeof(header));
+
+    size_t filesSize = data.size - sizeof(header);
+    if (header.elfSize > filesSize || header.nasmSize != filesSize - header.elfSize) { return false; }
+
+    const uint8_t* elf  = data.bytes + sizeof(header);
+    const uint8_t* nasm = elf + header.elfSize;
+
+    FILE* elfFile = fopen(job->output, "w");
+    if (elfFile == nullptr)
+    {
+        fprintf(job->errorsFile, "Couldn't load file '%s'\n", job->output);
+        *result = OUTPUT_LOAD_FAILED;
+        return true;
     }
 
+    fwrite(elf, sizeof(uint8_t), header.elfSize, elfFile);
+    fclose(elfFile);
+
+    if (job->nasmOutput != nullptr)
+    {
+        FILE* nasmFile = fopen(job->nasmOutput, "w");
+        if (nasmFile == nullptr)
+        {
+            fprintf(job->errorsFile, "Couldn't load file '%s'\n", job->nasmOutput);
+            *result = NASM_OUTPUT_LOAD_FAILED;
+            return true;
+        }
+
+        fwrite(nasm, sizeof(uint8_t), header.nasmSize, nasmFile);
+        fclose(nasmFile);
+    }
+
+    job->cacheHits   = header.functionsCount;
+    job->cacheMisses = 0;
+
+    *result = NO_ERROR;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+//! Keeps the outputs just written in the cache. Failing to read them back only
+//! makes them a miss the next time.
+//------------------------------------------------------------------------------
+void storeCachedOutputs(const CachedOutputs* outputs, const SourceJob* job)
+{
+    assert(outputs);
+    assert(job);
+
+    SourceFile elf  = {};
+    SourceFile nasm = {};
+
+    if (!loadSource(&elf, job->output)) { return; }
+    if (job->nasmOutput != nullptr && !loadSource(&nasm, job->nasmOutput))
+    {
+        destroy(&elf);
+        return;
+    }
+
+    CachedOutputsHeader header = {elf.size, nasm.size, job->cacheHits + job->cacheMisses};
+
+    CacheBuffer data = {};
+    construct(&data);
+
+    uint8_t* bytes = reserveBytes(&data, sizeof(header) + elf.size + nasm.size);
+    memcpy(bytes,                  &header,    sizeof(header));
+    memcpy(bytes + sizeof(header), elf.buffer, elf.size);
+
+    if (job->nasmOutput != nullptr)
+    {
+        memcpy(bytes + sizeof(header) + elf.size, nasm.buffer, nasm.size);
+    }
+
+    CacheEntry entry = {{outputs->key.bytes, outputs->key.size}, {data.bytes, data.size}};
+    storeCachePack(&outputs->pack, &entry, 1);
+
+    destroy(&data);
+    if (job->nasmOutput != nullptr) { destroy(&nasm); }
+    destroy(&elf);
+}
+
+void destroy(CachedOutputs* outputs)
+{
+    assert(outputs);
+
+    destroy(&outputs->key);
+    destroy(&outputs->pack);
+}
+
+//------------------------------------------------------------------------------
+//! Writes the parsed program's ELF file and listing, as well as the dumps of 
+//! its tree and symbol table.
+//------------------------------------------------------------------------------
+Error writeProgram(const FlagManager* flagManager, SourceJob* job, Node* tree, SymbolTable* table)
+{
+    assert(flagManager);
+    assert(job);
+    assert(tree);
+    assert(table);
+
     if (flagManager->flagEnabled[FLAG_SIMPLE_GRAPH_DUMP])
     {
         makeGraphDump(flagManager, tree, false);
@@ -421,13 +997,6 @@ Error compile(const FlagManager* flagManager)
         makeGraphDump(flagManager, tree, true);
     }
 
-    if (flagManager->flagEnabled[FLAG_SYMB_TABLE_DUMP])
-    {   
-        printf("\n");
-        dump(&table);
-        printf("\n");
-    }
-
     if (flagManager->flagEnabled[FLAG_TREE_DUMP])
     {
         FILE* file = fopen("../examples/log/dumped_tree.txt", "w");
@@ -438,45 +1007,438 @@ Error compile(const FlagManager* flagManager)
         fclose(file);
     }   
 
-    Compiler compiler = {};
-    construct(&compiler, tree, &table);
-
-    FILE* elfFile = fopen(flagManager->output, "w");
+    /* Mapping a file to memory for writing needs it to be readable too. */
+    bool  isOutputMapped = flagManager->flagEnabled[FLAG_MAP_OUTPUT];
+    FILE* elfFile        = fopen(job->output, isOutputMapped ? "w+" : "w");
     if (elfFile == nullptr)
     {
-        printf("Couldn't load file '%s'\n", flagManager->output);
+        fprintf(job->errorsFile, "Couldn't load file '%s'\n", job->output);
         return OUTPUT_LOAD_FAILED;
     }
-    addElfFile(&compiler, elfFile);
 
-    if (flagManager->flagEnabled[FLAG_NASM_DUMP])
+    FILE* nasmFile = nullptr;
+    if (job->nasmOutput != nullptr)
     {
-        FILE* nasmFile = fopen(flagManager->nasmOutput, "w");
+        nasmFile = fopen(job->nasmOutput, "w");
         if (nasmFile == nullptr)
         {
-            printf("Couldn't load file '%s'\n", flagManager->nasmOutput);
+            fprintf(job->errorsFile, "Couldn't load file '%s'\n", job->nasmOutput);
+            fclose(elfFile);
             return NASM_OUTPUT_LOAD_FAILED;
         }
+    }
+
+    Compiler compiler = {};
+    construct(&compiler, tree, table);
+    setErrorsFile(&compiler, job->errorsFile);
+
+    if (flagManager->flagEnabled[FLAG_SYMB_TABLE_DUMP])
+    {   
+        printf("\n");
+        dump(table);
+        printf("\n");
+    }
+
+    addElfFile(&compiler, elfFile);
+
+    if (isOutputMapped)
+    {
+        mapOutputFile(&compiler.builder);
+    }
+
+    if (flagManager->flagEnabled[FLAG_SIZE_OPTIMIZATION])
+    {
+        optimizeSize(&compiler);
+    }
+
+    if (flagManager->flagEnabled[FLAG_DEBUG_INFO])
+    {
+        addDebugInfo(&compiler, job->input);
+    }
+
+    if (flagManager->jobsCount > 1)
+    {
+        useThreads(&compiler, flagManager->jobsCount);
+    }
+
+    if (flagManager->flagEnabled[FLAG_CACHE_DIR])
+    {
+        useCache(&compiler, flagManager->cacheDir, job->input);
+    }
+
+    if (nasmFile != nullptr)
+    {
         addNasmFile(&compiler, nasmFile);
     }
 
+    Error result = NO_ERROR;
+
     if (compile(&compiler) != COMPILER_NO_ERROR)
     {
-        printf("Couldn't compile the program.\n");
-        return COMPILATION_FAILED;
+        fprintf(job->errorsFile, "Couldn't compile the program.\n");
+        result = COMPILATION_FAILED;
     }
 
-    if (compiler.isNasmNeeded)
+    if (compiler.isCacheUsed)
     {
-        fclose(compiler.nasmFile);
+        job->cacheHits   = compiler.cache.hits;
+        job->cacheMisses = compiler.cache.misses;
     }
 
+    /* The listing is flushed by destroying the compiler. */
+    destroy(&compiler);
+
+    if (nasmFile != nullptr) { fclose(nasmFile); }
     fclose(elfFile);
 
-    destroy(&table);
-    destroy(&tokenizer);
-    destroy(&parser);
-    destroy(&compiler);
+    return result;
+}
 
-    return NO_ERROR;
+//------------------------------------------------------------------------------
+//! Compiles the programs listed in the manifest with up to jobsCount threads,
+//! each of which takes the next program once it's done with the previous one.
+//! The programs share the process' intern pool (see shareInternPool()) and 
+//! the embedded standard library.
+//------------------------------------------------------------------------------
+Error compileBatch(const FlagManager* flagManager)
+{
+    assert(flagManager);
+
+    for (int flag = 0; flag < TOTAL_FLAGS; flag++)
+    {
+        if (flagManager->flagEnabled[flag] && !FLAGS_ALLOWED_IN_BATCH[flag])
+        {
+            printf("Flag '%s' isn't supported in batch mode!\n", FLAG_SPECIFICATIONS[flag].string);
+            return BATCH_FLAG_UNSUPPORTED;
+        }
+    }
+
+    BatchQueue queue = {};
+    if (!readManifest(&queue, flagManager->manifest))
+    {
+        printf("Couldn't load manifest '%s'\n", flagManager->manifest);
+        return MANIFEST_LOAD_FAILED;
+    }
+
+    /* The threads compile different programs, each of them in one thread. */
+    queue.flagManager           = *flagManager;
+    queue.flagManager.jobsCount = 1;
+    pthread_mutex_init(&queue.lock, nullptr);
+
+    size_t threadsCount = flagManager->jobsCount;
+    if (threadsCount > queue.jobsCount)   { threadsCount = queue.jobsCount;   }
+    if (threadsCount > BATCH_MAX_THREADS) { threadsCount = BATCH_MAX_THREADS; }
+
+    shareInternPool();
+
+    pthread_t threads[BATCH_MAX_THREADS]        = {};
+    bool      threadsStarted[BATCH_MAX_THREADS] = {};
+
+    /* The main thread is the first of them, so it does all the work if no 
+     * other thread could be started. */
+    for (size_t i = 1; i < threadsCount; i++)
+    {
+        threadsStarted[i] = pthread_create(&threads[i], nullptr, compileBatchJobs, &queue) == 0;
+    }
+
+    compileBatchJobs(&queue);
+
+    for (size_t i = 1; i < threadsCount; i++)
+    {
+        if (threadsStarted[i]) { pthread_join(threads[i], nullptr); }
+    }
+
+    size_t compiledCount = 0;
+    size_t cacheHits     = 0;
+    size_t cacheMisses   = 0;
+
+    for (size_t i = 0; i < queue.jobsCount; i++)
+    {
+        SourceJob* job = &queue.jobs[i];
+
+        if (job->result == NO_ERROR) { compiledCount++; }
+        else                         { printf("Couldn't compile '%s':\n", job->input); }
+
+        /* Printed in the manifest's order, whichever thread compiled them. */
+        if (job->errorsSize > 0) { fwrite(job->errors, sizeof(char), job->errorsSize, stdout); }
+
+        cacheHits   += job->cacheHits;
+        cacheMisses += job->cacheMisses;
+    }
+
+    printf("Compiled %zu of %zu programs\n", compiledCount, queue.jobsCount);
+
+    if (flagManager->flagEnabled[FLAG_CACHE_DIR])
+    {
+        printf("Function cache: %zu hits, %zu misses\n", cacheHits, cacheMisses);
+    }
+
+    Error result = compiledCount == queue.jobsCount ? NO_ERROR : COMPILATION_FAILED;
+
+    pthread_mutex_destroy(&queue.lock);
+    destroy(&queue);
+
+    return result;
+}
+
+//------------------------------------------------------------------------------
+//! Compiles the queue's programs until there are none left. Each program's 
+//! errors are gathered in its job, so that the threads' ones don't mix.
+//------------------------------------------------------------------------------
+static void* compileBatchJobs(void* batchQueue)
+{
+    assert(batchQueue);
+
+    BatchQueue* queue = (BatchQueue*) batchQueue;
+
+    while (true)
+    {
+        pthread_mutex_lock(&queue->lock);
+        size_t next = queue->nextJob++;
+        pthread_mutex_unlock(&queue->lock);
+
+        if (next >= queue->jobsCount) { break; }
+
+        SourceJob* job = &queue->jobs[next];
+
+        job->errorsFile = open_memstream(&job->errors, &job->errorsSize);
+        assert(job->errorsFile);
+
+        job->result = compile(&queue->flagManager, job);
+
+        fclose(job->errorsFile);
+        job->errorsFile = nullptr;
+    }
+
+    return nullptr;
+}
+
+//------------------------------------------------------------------------------
+//! Reads the jobs from the manifest, whose every line is 
+//! "<program> [<ELF file> [<NASM listing>]]". Empty lines and lines starting
+//! with '#' are skipped. The ELF file is by default the program's name with 
+//! the extension replaced by ".elf", and the listing isn't written unless
+//! it's specified.
+//------------------------------------------------------------------------------
+bool readManifest(BatchQueue* queue, const char* manifest)
+{
+    assert(queue);
+    assert(manifest);
+
+    SourceFile source = {};
+    if (!loadSource(&source, manifest)) { return false; }
+
+    /* The names are cut out of the copy by terminating them in place. */
+    queue->text = (char*) calloc(source.size + 1, sizeof(char));
+    assert(queue->text);
+
+    memcpy(queue->text, source.buffer, source.size);
+    destroy(&source);
+
+    size_t capacity = BATCH_INITIAL_CAPACITY;
+    queue->jobs = (SourceJob*) calloc(capacity, sizeof(SourceJob));
+    assert(queue->jobs);
+
+    char* line = queue->text;
+    while (*line != '\0')
+    {
+        char* lineEnd = strchr(line, '\n');
+        char* next    = lineEnd != nullptr ? lineEnd + 1 : line + strlen(line);
+        if (lineEnd != nullptr) { *lineEnd = '\0'; }
+
+        const char* fields[MANIFEST_FIELDS_COUNT] = {};
+        size_t      fieldsCount = 0;
+
+        for (char* field = strtok(line, " \t\r"); field != nullptr; field = strtok(nullptr, " \t\r"))
+        {
+            if (fieldsCount < MANIFEST_FIELDS_COUNT) { fields[fieldsCount] = field; }
+            fieldsCount++;
+        }
+
+        line = next;
+        if (fieldsCount == 0 || fields[0][0] == '#') { continue; }
+
+        if (queue->jobsCount == capacity)
+        {
+            capacity   *= 2;
+            queue->jobs = (SourceJob*) realloc(queue->jobs, capacity * sizeof(SourceJob));
+            assert(queue->jobs);
+        }
+
+        SourceJob* job = &queue->jobs[queue->jobsCount++];
+        *job = {};
+
+        job->input      = fields[0];
+        job->output     = fields[1];
+        job->nasmOutput = fields[2];
+
+        if (job->output == nullptr)
+        {
+            job->defaultOutput = defaultOutput(job->input);
+            job->output        = job->defaultOutput;
+        }
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+//! @return Program's name with the extension replaced by ".elf", which has to
+//!         be freed.
+//------------------------------------------------------------------------------
+char* defaultOutput(const char* input)
+{
+    assert(input);
+
+    const char* name      = strrchr(input, '/');
+    const char* extension = strrchr(name != nullptr ? name : input, '.');
+    size_t      length    = extension != nullptr && extension != name + 1 && extension != input ? 
+                            (size_t) (extension - input) : strlen(input);
+
+    char* output = (char*) calloc(length + sizeof(BATCH_OUTPUT_EXTENSION), sizeof(char));
+    assert(output);
+
+    memcpy(output, input, length);
+    strcat(output, BATCH_OUTPUT_EXTENSION);
+
+    return output;
+}
+
+void destroy(BatchQueue* queue)
+{
+    assert(queue);
+
+    for (size_t i = 0; i < queue->jobsCount; i++)
+    {
+        free(queue->jobs[i].defaultOutput);
+        free(queue->jobs[i].errors);
+    }
+
+    free(queue->jobs);
+    free(queue->text);
+
+    *queue = {};
+}
+
+void benchLexer(const FlagManager* flagManager, const char* buffer, size_t bufferSize)
+{
+    assert(flagManager);
+    assert(buffer);
+
+    CharScannerLevel defaultLevel = getCharScannerLevel();
+
+    for (uint32_t level = 0; level < TOTAL_CHAR_SCANNER_LEVELS; level++)
+    {
+        if (!isCharScannerLevelSupported((CharScannerLevel) level)) { continue; }
+        setCharScannerLevel((CharScannerLevel) level);
+
+        size_t runs    = 0;
+        double seconds = 0;
+
+        while (runs < BENCH_MIN_RUNS || seconds < BENCH_MIN_SECONDS)
+        {
+            timespec start = {};
+            timespec end   = {};
+
+            Tokenizer tokenizer = {};
+            construct(&tokenizer, buffer, bufferSize, flagManager->flagEnabled[FLAG_USE_NUMERICS], false);
+
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            tokenizeBuffer(&tokenizer);
+            clock_gettime(CLOCK_MONOTONIC, &end);
+
+            destroy(&tokenizer);
+
+            seconds += (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) * 1e-9;
+            runs++;
+        }
+
+        printf("lexer   (%-6s): %9.2lf MB/s (%zu runs over %zu bytes)\n", 
+               CHAR_SCANNER_LEVEL_STRINGS[level], 
+               (double) (runs * bufferSize) / seconds / 1e6,
+               runs, 
+               bufferSize);
+
+        printf("scanner (%-6s): lines %9.2lf MB/s, tokens %9.2lf MB/s\n",
+               CHAR_SCANNER_LEVEL_STRINGS[level],
+               benchScan(scanLines,  buffer, bufferSize),
+               benchScan(scanTokens, buffer, bufferSize));
+    }
+
+    setCharScannerLevel(defaultLevel);
+}
+
+//------------------------------------------------------------------------------
+//! Finds every new line, as the tokenizer does when splitting the input.
+//------------------------------------------------------------------------------
+void scanLines(const char* buffer, size_t bufferSize)
+{
+    assert(buffer);
+
+    const char* bufferEnd = buffer + bufferSize;
+    const char* newLine   = findEither(buffer, bufferEnd, '\n', '\n');
+
+    while (newLine < bufferEnd)
+    {
+        newLine = findEither(newLine + 1, bufferEnd, '\n', '\n');
+    }
+}
+
+//------------------------------------------------------------------------------
+//! Walks the input the way the tokenizer does, but only with the scanning
+//! functions: skips the spaces, spans the identifiers and finds the ends of
+//! the quoted strings. Any other symbol is stepped over.
+//------------------------------------------------------------------------------
+void scanTokens(const char* buffer, size_t bufferSize)
+{
+    assert(buffer);
+
+    const char* bufferEnd = buffer + bufferSize;
+    const char* cur       = buffer;
+
+    while (cur < bufferEnd)
+    {
+        cur += spanSpaces(cur, bufferEnd);
+        if (cur == bufferEnd) { break; }
+
+        size_t idLength = spanIdSymbols(cur, bufferEnd);
+
+        if (idLength > 0)   { cur += idLength; }
+        else if (*cur == '\"')
+        {
+            cur = findEither(cur + 1, bufferEnd, '\"', '\n');
+            if (cur < bufferEnd) { cur++; }
+        }
+        else                { cur++; }
+    }
+}
+
+//------------------------------------------------------------------------------
+//! The scanning functions are in another translation unit, so the scans aren't
+//! optimized out even though their results are unused.
+//!
+//! @return Throughput of the scan over the buffer in MB/s.
+//------------------------------------------------------------------------------
+double benchScan(SourceScan scan, const char* buffer, size_t bufferSize)
+{
+    assert(scan);
+    assert(buffer);
+
+    size_t runs    = 0;
+    double seconds = 0;
+
+    while (runs < BENCH_MIN_RUNS || seconds < BENCH_MIN_SECONDS)
+    {
+        timespec start = {};
+        timespec end   = {};
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        scan(buffer, bufferSize);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        seconds += (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) * 1e-9;
+        runs++;
+    }
+
+    return (double) (runs * bufferSize) / seconds / 1e6;
 }
\ No newline at end of file
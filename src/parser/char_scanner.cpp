@@ -0,0 +1,165 @@
+#include <assert.h>
+#include <stdint.h>
+
+#include "char_scanner.h"
+#include "syntax.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <emmintrin.h>
+#define CHAR_SCANNER_X86
+#endif
+
+typedef const char* (*FindEither) (const char* start, const char* end, char first, char second);
+
+//------------------------------------------------------------------------------
+//! Identifiers' symbols are checked as ((byte | 0x20) - 'a') < 26 instead of
+//! being looked up in ID_VALID_SYMBOLS, so the two have to agree.
+//------------------------------------------------------------------------------
+constexpr bool isIdSymbol(uint8_t byte)
+{
+    return (uint8_t) ((byte | 0x20) - 'a') < 26;
+}
+
+constexpr bool idSymbolsMatchSyntax()
+{
+    for (size_t byte = 0; byte < 256; byte++)
+    {
+        bool inSyntax = false;
+        for (const char* symbol = ID_VALID_SYMBOLS; *symbol != '\0'; symbol++)
+        {
+            inSyntax = inSyntax || (uint8_t) *symbol == byte;
+        }
+
+        if (inSyntax != isIdSymbol((uint8_t) byte)) { return false; }
+    }
+
+    return true;
+}
+
+static_assert(idSymbolsMatchSyntax(), "isIdSymbol() has to be updated along with ID_VALID_SYMBOLS");
+
+//====================================Scalar====================================
+const char* findEitherScalar (const char* start, const char* end, char first, char second);
+
+const char* findEitherScalar(const char* start, const char* end, char first, char second)
+{
+    const char* cur = start;
+    while (cur < end && *cur != first && *cur != second) { cur++; }
+
+    return cur;
+}
+//====================================Scalar====================================
+
+#ifdef CHAR_SCANNER_X86
+//=====================================SSE2=====================================
+const char* findEitherSse2   (const char* start, const char* end, char first, char second);
+
+const char* findEitherSse2(const char* start, const char* end, char first, char second)
+{
+    const __m128i firsts  = _mm_set1_epi8(first);
+    const __m128i seconds = _mm_set1_epi8(second);
+
+    const char* cur = start;
+    for (; cur + 16 <= end; cur += 16)
+    {
+        __m128i  bytes = _mm_loadu_si128((const __m128i*) cur);
+        __m128i  match = _mm_or_si128(_mm_cmpeq_epi8(bytes, firsts), _mm_cmpeq_epi8(bytes, seconds));
+        uint32_t mask  = (uint32_t) _mm_movemask_epi8(match);
+
+        if (mask != 0) { return cur + __builtin_ctz(mask); }
+    }
+
+    return findEitherScalar(cur, end, first, second);
+}
+//=====================================SSE2=====================================
+#endif
+
+static const FindEither FIND_EITHER_LEVELS[TOTAL_CHAR_SCANNER_LEVELS] =
+{
+    findEitherScalar,
+
+#ifdef CHAR_SCANNER_X86
+    findEitherSse2
+#else
+    findEitherScalar
+#endif
+};
+
+CharScannerLevel detectCharScannerLevel();
+
+static CharScannerLevel charScannerLevel  = detectCharScannerLevel();
+static FindEither       findEitherAtLevel = FIND_EITHER_LEVELS[charScannerLevel];
+
+bool isCharScannerLevelSupported(CharScannerLevel level)
+{
+    switch (level)
+    {
+        case CHAR_SCANNER_SCALAR: { return true; }
+
+#ifdef CHAR_SCANNER_X86
+        case CHAR_SCANNER_SSE2:   { return __builtin_cpu_supports("sse2"); }
+#endif
+
+        default:                  { return false; }
+    }
+}
+
+CharScannerLevel detectCharScannerLevel()
+{
+#ifdef CHAR_SCANNER_X86
+    /* Called during static initialization, possibly before libgcc's own. */
+    __builtin_cpu_init();
+#endif
+
+    for (int level = TOTAL_CHAR_SCANNER_LEVELS - 1; level > CHAR_SCANNER_SCALAR; level--)
+    {
+        if (isCharScannerLevelSupported((CharScannerLevel) level)) { return (CharScannerLevel) level; }
+    }
+
+    return CHAR_SCANNER_SCALAR;
+}
+
+CharScannerLevel getCharScannerLevel()
+{
+    return charScannerLevel;
+}
+
+void setCharScannerLevel(CharScannerLevel level)
+{
+    assert(isCharScannerLevelSupported(level));
+
+    charScannerLevel  = level;
+    findEitherAtLevel = FIND_EITHER_LEVELS[level];
+}
+
+size_t spanSpaces(const char* start, const char* end)
+{
+    assert(start);
+    assert(end);
+
+    const char* cur = start;
+    while (cur < end && (*cur == ' ' || *cur == '\t')) { cur++; }
+
+    return cur - start;
+}
+
+size_t spanIdSymbols(const char* start, const char* end)
+{
+    assert(start);
+    assert(end);
+
+    const char* cur = start;
+    while (cur < end && isIdSymbol((uint8_t) *cur)) { cur++; }
+
+    return cur - start;
+}
+
+const char* findEither(const char* start, const char* end, char first, char second)
+{
+    assert(start);
+    assert(end);
+
+    if (start >= end) { return end; }
+
+    return findEitherAtLevel(start, end, first, second);
+}
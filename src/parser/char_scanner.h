@@ -0,0 +1,62 @@
+#ifndef CHAR_SCANNER_H
+#define CHAR_SCANNER_H
+
+#include <stdlib.h>
+
+//------------------------------------------------------------------------------
+//! Character-class scanning used in the tokenizer's hot loop. Spaces and 
+//! identifiers span a few bytes, where setting up vectors costs more than it
+//! saves, so only findEither(), which goes through whole lines, comments and
+//! strings, has an SSE2 version besides the scalar one. The best version the
+//! cpu supports is chosen at startup. None of the functions read at or past
+//! end.
+//------------------------------------------------------------------------------
+
+enum CharScannerLevel
+{
+    CHAR_SCANNER_SCALAR,
+    CHAR_SCANNER_SSE2,
+
+    TOTAL_CHAR_SCANNER_LEVELS
+};
+
+static const char* CHAR_SCANNER_LEVEL_STRINGS[TOTAL_CHAR_SCANNER_LEVELS] =
+{
+    "scalar",
+    "sse2"
+};
+
+//------------------------------------------------------------------------------
+//! @return Whether the cpu supports level.
+//------------------------------------------------------------------------------
+bool             isCharScannerLevelSupported (CharScannerLevel level);
+
+//------------------------------------------------------------------------------
+//! @return Level currently in use.
+//------------------------------------------------------------------------------
+CharScannerLevel getCharScannerLevel         ();
+
+//------------------------------------------------------------------------------
+//! Forces the scanning level (e.g. in order to benchmark them).
+//!
+//! @param level Has to be supported.
+//------------------------------------------------------------------------------
+void             setCharScannerLevel         (CharScannerLevel level);
+
+//------------------------------------------------------------------------------
+//! @return Number of spaces and tabs at the beginning of [start, end).
+//------------------------------------------------------------------------------
+size_t           spanSpaces                  (const char* start, const char* end);
+
+//------------------------------------------------------------------------------
+//! @return Number of ID_VALID_SYMBOLS at the beginning of [start, end).
+//------------------------------------------------------------------------------
+size_t           spanIdSymbols               (const char* start, const char* end);
+
+//------------------------------------------------------------------------------
+//! @return Pointer to the first first or second symbol in [start, end) or end
+//!         if there are none.
+//------------------------------------------------------------------------------
+const char*      findEither                  (const char* start, const char* end, char first, char second);
+
+#endif
@@ -51,24 +51,74 @@ const size_t LEFT_CHILD_LENGTH    = strlen("{ } { ");
 int  counterFileUpdate (const char* filename);
 void graphDumpSubtree  (FILE* file, const Node* node, bool detailed);
 
-void destroySubtree(Node* root)
+struct NodeArenaBlock
 {
-    CHECK_NULL(root, return);
+    NodeArenaBlock* previous;
+    size_t          capacity;
+    Node*           nodes;
+};
 
-    destroySubtree(root->left);
-    destroySubtree(root->right);
+static_assert(sizeof(NodeArenaBlock) % alignof(Node) == 0, "Nodes placed after a block's header have to be aligned");
 
-    deleteNode(root);
+void construct(NodeArena* arena)
+{
+    assert(arena);
+
+    arena->block      = nullptr;
+    arena->used       = 0;
+    arena->nodesCount = 0;
 }
 
-Node* newNode()
+//------------------------------------------------------------------------------
+//! Releases all the nodes allocated from the arena, which takes one free() 
+//! per block, i.e. O(log(nodesCount)).
+//------------------------------------------------------------------------------
+void destroy(NodeArena* arena)
 {
-    return (Node*) calloc(1, sizeof(Node));
+    assert(arena);
+
+    while (arena->block != nullptr)
+    {
+        NodeArenaBlock* previous = arena->block->previous;
+
+        free(arena->block);
+        arena->block = previous;
+    }
+
+    construct(arena);
 }
 
-Node* newNode(NodeType type, NodeData data, Node* left, Node* right)
+Node* newNode(NodeArena* arena)
 {
-    Node* node = newNode();
+    assert(arena);
+
+    if (arena->block == nullptr || arena->used == arena->block->capacity)
+    {
+        size_t capacity = arena->block == nullptr ? NODE_ARENA_FIRST_BLOCK_SIZE : 2 * arena->block->capacity;
+
+        /* Nodes are placed right after the block's header. */
+        NodeArenaBlock* block = (NodeArenaBlock*) malloc(sizeof(NodeArenaBlock) + capacity * sizeof(Node));
+        CHECK_NULL(block, return nullptr);
+
+        block->previous = arena->block;
+        block->capacity = capacity;
+        block->nodes    = (Node*) (block + 1);
+
+        arena->block = block;
+        arena->used  = 0;
+    }
+
+    Node* node = &arena->block->nodes[arena->used++];
+    *node = {};
+
+    arena->nodesCount++;
+
+    return node;
+}
+
+Node* newNode(NodeArena* arena, NodeType type, NodeData data, Node* left, Node* right)
+{
+    Node* node = newNode(arena);
     CHECK_NULL(node, return nullptr);
 
     node->type   = type;
@@ -84,17 +134,6 @@ Node* newNode(NodeType type, NodeData data, Node* left, Node* right)
     return node;
 }
 
-void deleteNode(Node* node)
-{
-    assert(node);
-
-    node->parent = nullptr;
-    node->left   = nullptr;
-    node->right  = nullptr;
-
-    free(node);
-}
-
 void setLeft(Node* root, Node* left)
 {
     assert(root);
@@ -117,6 +156,7 @@ void copyNode(Node* dest, const Node* src)
     assert(src);
 
     dest->type   = src->type;
+    dest->line   = src->line;
     dest->data   = src->data;
     dest->parent = src->parent;
     dest->left   = src->left;
@@ -126,13 +166,185 @@ void copyNode(Node* dest, const Node* src)
     if (src->right != nullptr) { src->right->parent = dest; }
 }
 
-Node* copyTree(const Node* node)
+Node* copyTree(NodeArena* arena, const Node* node)
 {
     if (node == nullptr) { return nullptr; }
 
-    return newNode(node->type, node->data, copyTree(node->left), copyTree(node->right));
+    Node* copy = newNode(arena, node->type, node->data, copyTree(arena, node->left), copyTree(arena, node->right));
+    CHECK_NULL(copy, return nullptr);
+
+    copy->line = node->line;
+
+    return copy;
+}
+
+//=================================CompactTree==================================
+static NodeIndex addNode          (CompactTree* tree, const Node* node);
+static size_t    reserveSiblings  (CompactTree* tree, size_t count);
+static NodeIndex flattenList      (CompactTree* tree, const Node* list, const Node* firstLink);
+static NodeIndex flattenSubtree   (CompactTree* tree, const Node* node);
+
+//------------------------------------------------------------------------------
+//! Builds the compact form of the tree. The chain of declarations at the root
+//! (linked by left) is flattened iteratively, as it may be arbitrarily long.
+//! Every declaration is directly followed by its subtree's nodes.
+//------------------------------------------------------------------------------
+void construct(CompactTree* tree, const Node* root)
+{
+    assert(tree);
+
+    tree->types            = (uint8_t*)   calloc(COMPACT_TREE_INITIAL_CAPACITY, sizeof(uint8_t));
+    tree->data             = (NodeData*)  calloc(COMPACT_TREE_INITIAL_CAPACITY, sizeof(NodeData));
+    tree->lefts            = (NodeIndex*) calloc(COMPACT_TREE_INITIAL_CAPACITY, sizeof(NodeIndex));
+    tree->rights           = (NodeIndex*) calloc(COMPACT_TREE_INITIAL_CAPACITY, sizeof(NodeIndex));
+    tree->lines            = (uint32_t*)  calloc(COMPACT_TREE_INITIAL_CAPACITY, sizeof(uint32_t));
+    tree->siblings         = (NodeIndex*) calloc(COMPACT_TREE_INITIAL_CAPACITY, sizeof(NodeIndex));
+    assert(tree->types && tree->data && tree->lefts && tree->rights && tree->lines && tree->siblings);
+
+    tree->count            = 0;
+    tree->capacity         = COMPACT_TREE_INITIAL_CAPACITY;
+    tree->siblingsCount    = 0;
+    tree->siblingsCapacity = COMPACT_TREE_INITIAL_CAPACITY;
+    tree->root             = NO_NODE;
+
+    NodeIndex prevDeclaration = NO_NODE;
+
+    for (const Node* declaration = root; declaration != nullptr; declaration = declaration->left)
+    {
+        NodeIndex index = addNode(tree, declaration);
+
+        if (prevDeclaration == NO_NODE) { tree->root                   = index; }
+        else                            { tree->lefts[prevDeclaration] = index; }
+
+        NodeIndex right = flattenSubtree(tree, declaration->right);
+        tree->rights[index] = right;
+
+        prevDeclaration = index;
+    }
 }
 
+void destroy(CompactTree* tree)
+{
+    assert(tree);
+
+    free(tree->types);
+    free(tree->data);
+    free(tree->lefts);
+    free(tree->rights);
+    free(tree->lines);
+    free(tree->siblings);
+
+    *tree = {};
+    tree->root = NO_NODE;
+}
+
+static NodeIndex addNode(CompactTree* tree, const Node* node)
+{
+    assert(tree);
+    assert(tree->count < NO_NODE);
+
+    if (tree->count == tree->capacity)
+    {
+        size_t newCapacity = 2 * tree->capacity;
+
+        tree->types  = (uint8_t*)   realloc(tree->types,  newCapacity * sizeof(uint8_t));
+        tree->data   = (NodeData*)  realloc(tree->data,   newCapacity * sizeof(NodeData));
+        tree->lefts  = (NodeIndex*) realloc(tree->lefts,  newCapacity * sizeof(NodeIndex));
+        tree->rights = (NodeIndex*) realloc(tree->rights, newCapacity * sizeof(NodeIndex));
+        tree->lines  = (uint32_t*)  realloc(tree->lines,  newCapacity * sizeof(uint32_t));
+        assert(tree->types && tree->data && tree->lefts && tree->rights && tree->lines);
+
+        tree->capacity = newCapacity;
+    }
+
+    NodeIndex index = (NodeIndex) tree->count++;
+
+    tree->types[index]  = (uint8_t) node->type;
+    tree->data[index]   = node->data;
+    tree->lefts[index]  = NO_NODE;
+    tree->rights[index] = NO_NODE;
+    tree->lines[index]  = node->line;
+
+    return index;
+}
+
+//------------------------------------------------------------------------------
+//! @return Position of the first of count consecutive sibling slots.
+//------------------------------------------------------------------------------
+static size_t reserveSiblings(CompactTree* tree, size_t count)
+{
+    assert(tree);
+
+    size_t newCapacity = tree->siblingsCapacity;
+    while (tree->siblingsCount + count > newCapacity) { newCapacity *= 2; }
+
+    if (newCapacity != tree->siblingsCapacity)
+    {
+        tree->siblings = (NodeIndex*) realloc(tree->siblings, newCapacity * sizeof(NodeIndex));
+        assert(tree->siblings);
+
+        tree->siblingsCapacity = newCapacity;
+    }
+
+    size_t first = tree->siblingsCount;
+    tree->siblingsCount += count;
+
+    return first;
+}
+
+//------------------------------------------------------------------------------
+//! Replaces the chain starting with firstLink by list's node with the chain's
+//! lefts as its children. Slots for the children are reserved beforehand, so
+//! that the children's own lists are placed after them.
+//------------------------------------------------------------------------------
+static NodeIndex flattenList(CompactTree* tree, const Node* list, const Node* firstLink)
+{
+    assert(tree);
+    assert(list);
+
+    size_t length = 0;
+    for (const Node* link = firstLink; link != nullptr; link = link->right) { length++; }
+
+    NodeIndex index        = addNode(tree, list);
+    size_t    firstSibling = reserveSiblings(tree, length);
+
+    tree->lefts[index]  = (NodeIndex) firstSibling;
+    tree->rights[index] = (NodeIndex) length;
+
+    size_t sibling = firstSibling;
+    for (const Node* link = firstLink; link != nullptr; link = link->right)
+    {
+        NodeIndex child = flattenSubtree(tree, link->left);
+        tree->siblings[sibling++] = child;
+    }
+
+    return index;
+}
+
+static NodeIndex flattenSubtree(CompactTree* tree, const Node* node)
+{
+    assert(tree);
+
+    if (node == nullptr) { return NO_NODE; }
+
+    switch (node->type)
+    {
+        case BLOCK_TYPE:     { return flattenList(tree, node, node->right); }
+        case EXPR_LIST_TYPE: { return flattenList(tree, node, node);        }
+        default:             { break;                                       }
+    }
+
+    NodeIndex index = addNode(tree, node);
+    NodeIndex left  = flattenSubtree(tree, node->left);
+    NodeIndex right = flattenSubtree(tree, node->right);
+
+    tree->lefts[index]  = left;
+    tree->rights[index] = right;
+
+    return index;
+}
+//=================================CompactTree==================================
+
 bool isLeft(const Node* node)
 {
     assert(node);
@@ -170,7 +382,7 @@ void setDataId(Node* node, const char* id)
     assert(node);
 
     node->type    = ID_TYPE;
-    node->data.id = id;
+    node->data.id = { id, NO_VAR_SLOT };
 }
 
 void setDataIsVoidFunction(Node* node, bool isVoidFunction)
@@ -262,7 +474,7 @@ void graphDumpSubtree(FILE* file, const Node* node, bool detailed)
         case ADECL_TYPE:      { fprintf(file, "Array");       break; }
 
         case MEM_ACCESS_TYPE: { fprintf(file, "[ ]");         break; }
-        case ID_TYPE:         { fprintf(file, "%s", data.id); break; } 
+        case ID_TYPE:         { fprintf(file, "%s", data.id.name); break; } 
         case EXPR_LIST_TYPE:  { fprintf(file, "param");       break; } 
         
         case BLOCK_TYPE:      { fprintf(file, "Block");       break; }
@@ -336,25 +548,25 @@ void dumpToFile(FILE* file, const Node* node)
     }
     else if (node->type == ID_TYPE)
     {
-        if (strcmp(node->data.id, MAIN_FUNCTION_NAME) == 0)
+        if (strcmp(node->data.id.name, MAIN_FUNCTION_NAME) == 0)
         {
             fprintf(file, "%s ", UNIVERSAL_MAIN_NAME);
         }
-        else if (strcmp(node->data.id, KEYWORDS[PRINT_KEYWORD].string) == 0)
+        else if (strcmp(node->data.id.name, KEYWORDS[PRINT_KEYWORD].string) == 0)
         {
             fprintf(file, "%s ", UNIVERSAL_PRINT_NAME);   
         }
-        else if (strcmp(node->data.id, KEYWORDS[SCAN_KEYWORD].string) == 0)
+        else if (strcmp(node->data.id.name, KEYWORDS[SCAN_KEYWORD].string) == 0)
         {
             fprintf(file, "%s ", UNIVERSAL_SCAN_NAME);   
         }
-        else if (strcmp(node->data.id, KEYWORDS[SQRT_KEYWORD].string) == 0)
+        else if (strcmp(node->data.id.name, KEYWORDS[SQRT_KEYWORD].string) == 0)
         {
             fprintf(file, "%s ", UNIVERSAL_SQRT_NAME);   
         }
         else
         {
-            fprintf(file, "%s ", node->data.id);
+            fprintf(file, "%s ", node->data.id.name);
         }
     }
     else 
@@ -372,8 +584,10 @@ void dumpToFile(FILE* file, const Node* node)
 }
 
 // TODO: add new features support
-Node* readTreeFromFile(const char* filename)
+Node* readTreeFromFile(NodeArena* arena, const char* filename)
 {
+    assert(arena);
+
     char*  buffer     = nullptr;
     size_t bufferSize = 0;
     size_t ofs        = 0;
@@ -383,7 +597,7 @@ Node* readTreeFromFile(const char* filename)
         return nullptr;
     }
 
-    Node* node = newNode(FDECL_TYPE, {}, nullptr, nullptr);
+    Node* node = newNode(arena, FDECL_TYPE, {}, nullptr, nullptr);
     ofs += FIRST_FDECL_LENGTH; // to skip the first decl info
 
     while (ofs < bufferSize)
@@ -400,7 +614,7 @@ Node* readTreeFromFile(const char* filename)
 
             if (ofs + LEFT_CHILD_LENGTH < bufferSize && strncmp(buffer + ofs, "{ } { ", LEFT_CHILD_LENGTH) == 0)
             {
-                setRight(node, newNode());
+                setRight(node, newNode(arena));
                 node = node->right;
                 ofs += LEFT_CHILD_LENGTH;
                 continue;
@@ -408,7 +622,7 @@ Node* readTreeFromFile(const char* filename)
 
             if (node->left == nullptr)
             {
-                setLeft(node, newNode());
+                setLeft(node, newNode(arena));
                 node = node->left;
             }
             else if (buffer[ofs + 2] == '}') // in case '{ }'
@@ -418,7 +632,7 @@ Node* readTreeFromFile(const char* filename)
             }
             else
             {
-                setRight(node, newNode());
+                setRight(node, newNode(arena));
                 node = node->right;
             }
 
@@ -447,23 +661,23 @@ Node* readTreeFromFile(const char* filename)
 
             if (strncmp(buffer + ofs, UNIVERSAL_MAIN_NAME, len) == 0)
             {
-                node->data.id = MAIN_FUNCTION_NAME;
+                node->data.id = { intern(MAIN_FUNCTION_NAME), NO_VAR_SLOT };
             }
             else if (strncmp(buffer + ofs, UNIVERSAL_PRINT_NAME, len) == 0)
             {
-                node->data.id = KEYWORDS[PRINT_KEYWORD].string;
+                node->data.id = { intern(KEYWORDS[PRINT_KEYWORD].string), NO_VAR_SLOT };
             }
             else if (strncmp(buffer + ofs, UNIVERSAL_SCAN_NAME, len) == 0)
             {
-                node->data.id = KEYWORDS[SCAN_KEYWORD].string;
+                node->data.id = { intern(KEYWORDS[SCAN_KEYWORD].string), NO_VAR_SLOT };
             }
             else if (strncmp(buffer + ofs, UNIVERSAL_SQRT_NAME, len) == 0)
             {
-                node->data.id = KEYWORDS[SQRT_KEYWORD].string;
+                node->data.id = { intern(KEYWORDS[SQRT_KEYWORD].string), NO_VAR_SLOT };
             }
             else
             {
-                node->data.id = copyString(buffer + ofs, len);
+                node->data.id = { intern(buffer + ofs, len), NO_VAR_SLOT };
             }
         }
         else
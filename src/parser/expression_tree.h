@@ -2,13 +2,24 @@
 #define EXPRESSION_TREE_H
 
 #include <stdarg.h>
+#include <stdio.h>
 #include "syntax.h"
+#include "../symbol_table/intern_pool.h"
+#include "../symbol_table/functions_data.h"
+
+/* Identifiers which name the current function's variables are resolved to 
+ * their slots by the parser, so that the compiler doesn't look names up. */
+struct IdData
+{
+    const char* name;
+    int         varSlot; /* NO_VAR_SLOT if not a variable */
+};
 
 union NodeData
 {
     int64_t     number;
     MathOp      operation;
-    const char* id;
+    IdData      id;
     
     bool        isVoidFunction;
     const char* string;
@@ -47,6 +58,7 @@ enum NodeType
 struct Node
 {
     NodeType type;
+    uint32_t line; /* of a statement or a function's name, 0 if unknown */
     NodeData data;
 
     Node*    parent;
@@ -54,20 +66,67 @@ struct Node
     Node*    right;
 };
 
-#define BINARY_OP(op, root1, root2) newNode(MATH_TYPE, { .operation = op##_OP  }, root1,   root2)
-#define ID(idString)                newNode(ID_TYPE,   { .id        = idString }, nullptr, nullptr)
+/* Nodes are bump-allocated from blocks, each twice as big as the previous 
+ * one, so that nodes allocated one after another are next to each other in 
+ * memory. Nodes are never freed separately, the whole arena is released at 
+ * once instead. */
+static const size_t NODE_ARENA_FIRST_BLOCK_SIZE = 256;
+
+struct NodeArenaBlock;
+
+struct NodeArena
+{
+    NodeArenaBlock* block;      /* the newest one, which nodes are taken from */
+    size_t          used;       /* nodes taken from block */
+    size_t          nodesCount;
+};
+
+typedef uint32_t NodeIndex;
+
+static const NodeIndex NO_NODE                       = UINT32_MAX;
+static const size_t    COMPACT_TREE_INITIAL_CAPACITY = 256;
+
+//------------------------------------------------------------------------------
+//! Read-only form of the tree, which the compiler walks. Nodes are numbered in
+//! preorder, and their fields are kept in parallel arrays indexed by number.
+//! Chains of statements (BLOCK_TYPE's right, linked by STATEMENT_TYPE nodes) 
+//! and of expressions (linked by EXPR_LIST_TYPE nodes) are replaced by a single
+//! BLOCK_TYPE or EXPR_LIST_TYPE node, whose children (the lefts of the chain's 
+//! links, in the same order) are stored next to each other in siblings. For 
+//! such nodes lefts holds the position of the first child in siblings and 
+//! rights holds the number of children.
+//------------------------------------------------------------------------------
+struct CompactTree
+{
+    uint8_t*   types;
+    NodeData*  data;
+    NodeIndex* lefts;
+    NodeIndex* rights;
+    uint32_t*  lines;
+    size_t     count;
+    size_t     capacity;
+
+    NodeIndex* siblings;
+    size_t     siblingsCount;
+    size_t     siblingsCapacity;
+
+    NodeIndex  root;
+};
 
-void   destroySubtree    (Node* root);
+#define BINARY_OP(arena, op, root1, root2) newNode(arena, MATH_TYPE, { .operation = op##_OP  }, root1,   root2)
+#define ID(arena, idString)                newNode(arena, ID_TYPE,   { .id        = { intern(idString), NO_VAR_SLOT } }, nullptr, nullptr)
 
-Node*  newNode           ();
-Node*  newNode           (NodeType type, NodeData data, Node* left, Node* right);
-void   deleteNode        (Node* node);
+void   construct         (NodeArena* arena);
+void   destroy           (NodeArena* arena);
+
+Node*  newNode           (NodeArena* arena);
+Node*  newNode           (NodeArena* arena, NodeType type, NodeData data, Node* left, Node* right);
 
 void   setLeft           (Node* root, Node* left);
 void   setRight          (Node* root, Node* right);
 
 void   copyNode          (Node* dest, const Node* src);
-Node*  copyTree          (const Node* root);
+Node*  copyTree          (NodeArena* arena, const Node* root);
 
 bool   isLeft            (const Node* node);
 
@@ -81,8 +140,30 @@ void   setDataString     (Node* node, const char* string);
 int    counterFileUpdate (const char* filename);
 void   graphDump         (const Node* root, const char* treeFilename, const char* outputFilename, bool detailed);
 
+void   construct         (CompactTree* tree, const Node* root);
+void   destroy           (CompactTree* tree);
+
+inline NodeType         nodeType     (const CompactTree* tree, NodeIndex node) { return (NodeType) tree->types[node]; }
+inline NodeData         nodeData     (const CompactTree* tree, NodeIndex node) { return tree->data[node];             }
+inline NodeIndex        leftChild    (const CompactTree* tree, NodeIndex node) { return tree->lefts[node];            }
+inline NodeIndex        rightChild   (const CompactTree* tree, NodeIndex node) { return tree->rights[node];           }
+inline uint32_t         nodeLine     (const CompactTree* tree, NodeIndex node) { return tree->lines[node];            }
+
+inline size_t           listLength   (const CompactTree* tree, NodeIndex list) { return tree->rights[list];                  }
+inline const NodeIndex* listChildren (const CompactTree* tree, NodeIndex list) { return tree->siblings + tree->lefts[list]; }
+
+//------------------------------------------------------------------------------
+//! @return Index after the last node of the declaration's subtree, as the 
+//!         subtree's nodes go right after the declaration.
+//------------------------------------------------------------------------------
+inline NodeIndex declarationEnd(const CompactTree* tree, NodeIndex declaration)
+{
+    NodeIndex next = tree->lefts[declaration];
+    return next != NO_NODE ? next : (NodeIndex) tree->count;
+}
+
 void   dumpToFile        (FILE* file, const Node* root);
-Node*  readTreeFromFile  (const char* filename);
+Node*  readTreeFromFile  (NodeArena* arena, const char* filename);
 
 const char* nodeTypeToString(NodeType type);
 
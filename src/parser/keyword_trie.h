@@ -0,0 +1,147 @@
+//------------------------------------------------------------------------------
+//! Keyword recognizer in the form of a DFA (a trie over the keywords' bytes),
+//! which is generated from KEYWORDS at compile time.
+//!
+//! @file   keyword_trie.h
+//------------------------------------------------------------------------------
+
+#ifndef KEYWORD_TRIE_H
+#define KEYWORD_TRIE_H
+
+#include <stdint.h>
+#include "syntax.h"
+
+static constexpr uint8_t  CHAR_FLAG_DIGIT       = 1 << 0;
+static constexpr uint8_t  CHAR_FLAG_SIGN        = 1 << 1;
+
+static constexpr uint16_t KEYWORD_TRIE_DEAD     = 0;
+static constexpr uint16_t KEYWORD_TRIE_ROOT     = 1;
+
+//------------------------------------------------------------------------------
+//! @return Total length of all the keywords, which is the upper bound of the
+//!         number of non-root trie nodes.
+//------------------------------------------------------------------------------
+constexpr size_t keywordsTotalLength()
+{
+    size_t length = 0;
+
+    for (size_t i = 0; i < KEYWORDS_COUNT; i++)
+    {
+        length += KEYWORDS[i].length;
+    }
+
+    return length;
+}
+
+//------------------------------------------------------------------------------
+//! @return Number of distinct bytes used in keywords plus one (class 0 is
+//!         reserved for bytes that can't be met in any keyword).
+//------------------------------------------------------------------------------
+constexpr size_t keywordsAlphabetSize()
+{
+    bool   used[256] = {};
+    size_t count     = 1;
+
+    for (size_t i = 0; i < KEYWORDS_COUNT; i++)
+    {
+        for (size_t j = 0; j < KEYWORDS[i].length; j++)
+        {
+            uint8_t byte = (uint8_t) KEYWORDS[i].string[j];
+
+            if (!used[byte])
+            {
+                used[byte] = true;
+                count++;
+            }
+        }
+    }
+
+    return count;
+}
+
+static constexpr size_t KEYWORD_TRIE_MAX_NODES     = keywordsTotalLength() + 2; /* + dead + root */
+static constexpr size_t KEYWORD_TRIE_ALPHABET_SIZE = keywordsAlphabetSize();
+
+static_assert(KEYWORD_TRIE_MAX_NODES <= UINT16_MAX,    "Trie nodes have to fit in uint16_t");
+static_assert(KEYWORD_TRIE_ALPHABET_SIZE <= UINT8_MAX, "Byte classes have to fit in uint8_t");
+
+struct KeywordTrie
+{
+    /* Byte -> its class in the transition table (0 if not used in keywords). */
+    uint8_t     charClass[256];
+
+    /* Byte -> CHAR_FLAG_* mask, used to find numbers. */
+    uint8_t     charFlags[256];
+
+    /* Transition table, node KEYWORD_TRIE_DEAD loops onto itself. */
+    uint16_t    next[KEYWORD_TRIE_MAX_NODES][KEYWORD_TRIE_ALPHABET_SIZE];
+
+    /* Keyword which ends in the node or INVALID_KEYWORD. */
+    KeywordCode accept[KEYWORD_TRIE_MAX_NODES];
+
+    size_t      nodesCount;
+};
+
+//------------------------------------------------------------------------------
+//! Builds the trie from KEYWORDS. As every keyword is inserted separately, the
+//! trie itself doesn't depend on the keywords' order, while the longest match
+//! is achieved by the caller remembering the last accepting node.
+//!
+//! @return The built trie.
+//------------------------------------------------------------------------------
+constexpr KeywordTrie buildKeywordTrie()
+{
+    KeywordTrie trie = {};
+
+    uint8_t nextClass = 1;
+    for (size_t i = 0; i < KEYWORDS_COUNT; i++)
+    {
+        for (size_t j = 0; j < KEYWORDS[i].length; j++)
+        {
+            uint8_t byte = (uint8_t) KEYWORDS[i].string[j];
+
+            if (trie.charClass[byte] == 0)
+            {
+                trie.charClass[byte] = nextClass++;
+            }
+        }
+    }
+
+    for (char digit = '0'; digit <= '9'; digit++)
+    {
+        trie.charFlags[(uint8_t) digit] |= CHAR_FLAG_DIGIT;
+    }
+
+    trie.charFlags[(uint8_t) '+'] |= CHAR_FLAG_SIGN;
+    trie.charFlags[(uint8_t) '-'] |= CHAR_FLAG_SIGN;
+
+    for (size_t node = 0; node < KEYWORD_TRIE_MAX_NODES; node++)
+    {
+        trie.accept[node] = INVALID_KEYWORD;
+    }
+
+    trie.nodesCount = KEYWORD_TRIE_ROOT + 1;
+
+    for (size_t i = 0; i < KEYWORDS_COUNT; i++)
+    {
+        uint16_t node = KEYWORD_TRIE_ROOT;
+
+        for (size_t j = 0; j < KEYWORDS[i].length; j++)
+        {
+            uint8_t charClass = trie.charClass[(uint8_t) KEYWORDS[i].string[j]];
+
+            if (trie.next[node][charClass] == KEYWORD_TRIE_DEAD)
+            {
+                trie.next[node][charClass] = (uint16_t) trie.nodesCount++;
+            }
+
+            node = trie.next[node][charClass];
+        }
+
+        trie.accept[node] = KEYWORDS[i].code;
+    }
+
+    return trie;
+}
+
+#endif
@@ -9,90 +9,121 @@
                               assert(parser->tokenizer);           \
                               assert(parser->tokenizer);           \
                               assert(parser->tokenizer->buffer);   \
-                              assert(parser->tokenizer->position); \
-                              assert(parser->tokenizer->tokens); 
+                              assert(parser->tokenizer->position);
 
-#define CHECK_END_REACHED(returnValue) if (tokensLeft(parser) <= 0) { return returnValue; } 
+#define CHECK_END_REACHED(returnValue) if (!hasToken(parser->tokenizer, parser->offset)) { return returnValue; } 
 
 #define SYNTAX_ERROR(error) syntaxError(parser, error); return nullptr;
 
 #define REQUIRE_ID(id)                  if (!requireIdToken(parser, id))                  { return nullptr; }
 #define REQUIRE_KEYWORD(keyword, error) if (!requireKeywordToken(parser, keyword, error)) { return nullptr; }
 #define REQUIRE_NEW_LINES()             if (!requireNewLines(parser))                     { return nullptr; }
-#define REQUIRE_VAR_DECLARED(var)       if (getVarOffset(parser->curFunction, var) == -1)        \
+#define REQUIRE_VAR_DECLARED(id)        if (!resolveVar(parser, id))                             \
                                         {                                                        \
                                             proceed(parser, -1);                                 \
                                             SYNTAX_ERROR(PARSE_ERROR_VARIABLE_UNDECLARED_USAGE); \
                                         }
 
-Token* curToken            (Parser* parser);
-void   proceed             (Parser* parser, int step);
-void   proceed             (Parser* parser);
-int    tokensLeft          (Parser* parser);
-bool   isEndReached        (Parser* parser);
+Token        curToken            (Parser* parser);
+uint32_t     curLine             (Parser* parser);
+void         proceed             (Parser* parser, int step);
+void         proceed             (Parser* parser);
+bool         isEndReached        (Parser* parser);
+void         releaseTokens       (Parser* parser);
 
-bool   requireIdToken      (Parser* parser, const char* id);
-bool   requireKeywordToken (Parser* parser, KeywordCode keywordCode, ParseError error);
-bool   requireNewLines     (Parser* parser);
+bool         requireIdToken      (Parser* parser, const char* id);
+bool         requireKeywordToken (Parser* parser, KeywordCode keywordCode, ParseError error);
+bool         requireNewLines     (Parser* parser);
 
-void   syntaxError         (Parser* parser, ParseError error);
+void         syntaxError         (Parser* parser, ParseError error);
 
-Node*  parseProgramBody    (Parser* parser);
-Node*  parseSDeclaration   (Parser* parser);
-Node*  parseFDeclaration   (Parser* parser);
+Node*        parseProgramBody    (Parser* parser);
+Node*        parseSDeclaration   (Parser* parser);
+Node*        parseFDeclaration   (Parser* parser);
 
-Node*  parseBlock          (Parser* parser);
-Node*  parseStatement      (Parser* parser);
-Node*  parseCmdLine        (Parser* parser);
-Node*  parseJump           (Parser* parser);
+Node*        parseBlock          (Parser* parser);
+Node*        parseStatement      (Parser* parser);
+Node*        parseCmdLine        (Parser* parser);
+Node*        parseJump           (Parser* parser);
 
-Node*  parseExpression     (Parser* parser);
-Node*  parseComparand      (Parser* parser);
-Node*  parseTerm           (Parser* parser);
-Node*  parseFactor         (Parser* parser);
+Node*        parseExpression     (Parser* parser);
+Node*        parseComparand      (Parser* parser);
+Node*        parseTerm           (Parser* parser);
+Node*        parseFactor         (Parser* parser);
 
-Node*  parseCondition      (Parser* parser);
-Node*  parseLoop           (Parser* parser);
+Node*        parseCondition      (Parser* parser);
+Node*        parseLoop           (Parser* parser);
 
-Node*  parseVDeclaration   (Parser* parser);
-Node*  parseADeclaration   (Parser* parser);
+Node*        parseVDeclaration   (Parser* parser);
+Node*        parseADeclaration   (Parser* parser);
 
-Node*  parseAssignment     (Parser* parser);
-Node*  parseLValue         (Parser* parser);
+Node*        parseAssignment     (Parser* parser);
+Node*        parseLValue         (Parser* parser);
 
-Node*  parseCall           (Parser* parser);
-Node*  parsePrintFloat     (Parser* parser);
-Node*  parsePrintString    (Parser* parser);
-Node*  parsePrint          (Parser* parser);
-Node*  parseStandardFunc   (Parser* parser, KeywordCode keywordCode);
+Node*        parseCall           (Parser* parser);
+Node*        parsePrintFloat     (Parser* parser);
+Node*        parsePrintString    (Parser* parser);
+Node*        parsePrint          (Parser* parser);
+Node*        parseStandardFunc   (Parser* parser, KeywordCode keywordCode);
 
-Node*  parseExprList       (Parser* parser);
-Node*  parseParamList      (Parser* parser);
+Node*        parseExprList       (Parser* parser);
+Node*        parseParamList      (Parser* parser);
 
-Node*  parseStringId       (Parser* parser);
-Node*  parseQuotedString   (Parser* parser);
-Node*  parseId             (Parser* parser);
-Node*  parseMemAccess      (Parser* parser);
-Node*  parseNumber         (Parser* parser);
+Node*        parseStringId       (Parser* parser);
+Node*        parseQuotedString   (Parser* parser);
+Node*        parseId             (Parser* parser);
+bool         resolveVar          (Parser* parser, Node* id);
+Node*        parseMemAccess      (Parser* parser);
+Node*        parseNumber         (Parser* parser);
 
 void construct(Parser* parser, Tokenizer* tokenizer)
 {
     assert(parser);
     assert(tokenizer);
-    assert(tokenizer->tokens);
 
-    parser->tokenizer = tokenizer;
-    parser->offset    = 0;
-    parser->status    = PARSE_NO_ERROR;
+    parser->tokenizer      = tokenizer;
+    parser->offset         = 0;
+    parser->pinnedOffset   = PARSER_NOTHING_PINNED;
+    parser->status         = PARSE_NO_ERROR;
+    parser->areLinesNeeded = false;
+    parser->errorsFile     = stdout;
+
+    construct(&parser->arena);
+}
+
+//------------------------------------------------------------------------------
+//! Makes the parser mark statements and functions' names with the lines they 
+//! start on (see Node::line), which the debug info is made of.
+//------------------------------------------------------------------------------
+void recordLines(Parser* parser)
+{
+    assert(parser);
+
+    parser->areLinesNeeded = true;
+}
+
+void setErrorsFile(Parser* parser, FILE* errorsFile)
+{
+    assert(parser);
+    assert(errorsFile);
+
+    parser->errorsFile = errorsFile;
 }
 
+//------------------------------------------------------------------------------
+//! Also releases the parsed tree, so it has to be destroyed after the tree 
+//! is no longer needed.
+//------------------------------------------------------------------------------
 void destroy(Parser* parser)
 {
     assert(parser);
 
-    parser->tokenizer = nullptr;
-    parser->offset    = 0;
-    parser->status    = PARSE_NO_ERROR;
+    parser->tokenizer    = nullptr;
+    parser->offset       = 0;
+    parser->pinnedOffset = PARSER_NOTHING_PINNED;
+    parser->status       = PARSE_NO_ERROR;
+
+    destroy(&parser->arena);
 }
 
 const char* errorString(ParseError error)
@@ -105,10 +136,23 @@ const char* errorString(ParseError error)
     return "UNDEFINED error";
 }
 
-Token* curToken(Parser* parser)
+Token curToken(Parser* parser)
 {
     ASSERT_PARSER(parser);
-    return parser->tokenizer->tokens + parser->offset;
+    return fetchToken(parser->tokenizer, parser->offset);
+}
+
+//------------------------------------------------------------------------------
+//! @return Line of the current token counting from 1, or 0 if lines aren't 
+//!         recorded (see recordLines()).
+//------------------------------------------------------------------------------
+uint32_t curLine(Parser* parser)
+{
+    ASSERT_PARSER(parser);
+
+    if (!parser->areLinesNeeded) { return 0; }
+
+    return (uint32_t) tokenLine(parser->tokenizer, curToken(parser)) + 1;
 }
 
 void proceed(Parser* parser, int step)
@@ -116,13 +160,16 @@ void proceed(Parser* parser, int step)
     ASSERT_PARSER(parser);
 
     assert(step >= 0 || (step < 0 && ((int) parser->offset) >= -step));
+    assert(step >= -(int) PARSER_MAX_REWIND);
 
     parser->offset += step;
 
-    if (parser->offset > parser->tokenizer->tokensCount)
+    if (step > 0 && !hasToken(parser->tokenizer, parser->offset - 1))
     {
-        parser->offset = parser->tokenizer->tokensCount;
+        parser->offset = tokensCount(parser->tokenizer);
     }
+
+    releaseTokens(parser);
 }
 
 void proceed(Parser* parser)
@@ -132,19 +179,24 @@ void proceed(Parser* parser)
     proceed(parser, 1);
 }
 
-int tokensLeft(Parser* parser)
+bool isEndReached(Parser* parser)
 {
     assert(parser);
-    assert(parser->tokenizer);
 
-    return parser->tokenizer->tokensCount - parser->offset;
+    return !hasToken(parser->tokenizer, parser->offset + 1);
 }
 
-bool isEndReached(Parser* parser)
+//------------------------------------------------------------------------------
+//! Lets the tokenizer discard the tokens which can't be rewound to anymore.
+//------------------------------------------------------------------------------
+void releaseTokens(Parser* parser)
 {
     assert(parser);
 
-    return tokensLeft(parser) <= 1;
+    size_t keptOffset = parser->offset > PARSER_MAX_REWIND ? parser->offset - PARSER_MAX_REWIND : 0;
+    if (keptOffset > parser->pinnedOffset) { keptOffset = parser->pinnedOffset; }
+
+    releaseTokens(parser->tokenizer, keptOffset);
 }
 
 bool requireIdToken(Parser* parser, const char* id)
@@ -158,7 +210,7 @@ bool requireIdToken(Parser* parser, const char* id)
         return false;
     }
 
-    if (id != nullptr && strcmp(id, curToken(parser)->data.id) != 0)
+    if (id != nullptr && !isId(parser->tokenizer, curToken(parser), id))
     {
         syntaxError(parser, PARSE_ERROR_INVALID_ID);
         return false;
@@ -174,7 +226,7 @@ bool requireKeywordToken(Parser* parser, KeywordCode keywordCode, ParseError err
     ASSERT_PARSER(parser);
     CHECK_END_REACHED(false);
 
-    Token* token = curToken(parser);
+    Token token = curToken(parser);
 
     if (!isKeyword(token, keywordCode))
     {
@@ -192,7 +244,7 @@ bool requireNewLines(Parser* parser)
     ASSERT_PARSER(parser);
     CHECK_END_REACHED(false);
 
-    Token* token = curToken(parser);
+    Token token = curToken(parser);
 
     if (!isKeyword(token, NEW_LINE_KEYWORD))
     {
@@ -215,8 +267,8 @@ void syntaxError(Parser* parser, ParseError error)
 
     if (parser->status == PARSE_NO_ERROR)
     {
-        printf("SYNTAX ERROR: %s\n", errorString(error));
-        printTokenLinePos(parser->tokenizer, curToken(parser), stdout, nullptr);
+        fprintf(parser->errorsFile, "SYNTAX ERROR: %s\n", errorString(error));
+        printTokenLinePos(parser->tokenizer, curToken(parser), parser->errorsFile, nullptr);
     }
     
     parser->status = error;
@@ -303,13 +355,15 @@ Node* parseSDeclaration(Parser* parser)
     if (!isKeyword(curToken(parser), SDECL_KEYWORD)) { return nullptr; }
     proceed(parser);
 
-    Node* stringDeclaration = newNode(SDECL_TYPE, {}, nullptr, nullptr);
+    Node* stringDeclaration = newNode(&parser->arena, SDECL_TYPE, {}, nullptr, nullptr);
     Node* stringId          = parseStringId(parser);
     
     if (stringId == nullptr) { SYNTAX_ERROR(PARSE_ERROR_NO_STRING_ID_IN_DECLARATION); }
     
-    String* existingString = getStringByName(parser->table, stringId->data.id);
-    if (existingString != nullptr) { SYNTAX_ERROR(PARSE_ERROR_STRING_ID_SECOND_DECLARATION); }
+    if (getStringByName(parser->table, stringId->data.id.name) != NO_STRING) 
+    { 
+        SYNTAX_ERROR(PARSE_ERROR_STRING_ID_SECOND_DECLARATION); 
+    }
 
     setRight(stringDeclaration, stringId);
     setRight(stringId, parseQuotedString(parser));
@@ -317,7 +371,7 @@ Node* parseSDeclaration(Parser* parser)
 
     REQUIRE_NEW_LINES();
 
-    pushString(parser->table, {stringId->data.id, stringId->right->data.string});
+    pushString(parser->table, {stringId->data.id.name, stringId->right->data.string, false});
     return stringDeclaration;
 }
 
@@ -327,11 +381,12 @@ Node* parseFDeclaration(Parser* parser)
     CHECK_END_REACHED(nullptr);
 
     if (!isKeyword(curToken(parser), FDECL_KEYWORD)) { return nullptr; }
+    uint32_t line = curLine(parser);
     proceed(parser);
 
-    Node* functionDeclaration = newNode(FDECL_TYPE, {.isVoidFunction = false}, nullptr, nullptr);
+    Node* functionDeclaration = newNode(&parser->arena, FDECL_TYPE, {.isVoidFunction = false}, nullptr, nullptr);
     
-    if (isNumber(curToken(parser), 0))
+    if (isNumber(parser->tokenizer, curToken(parser), 0))
     {
         functionDeclaration->data.isVoidFunction = true;
         proceed(parser); 
@@ -340,21 +395,23 @@ Node* parseFDeclaration(Parser* parser)
     setRight(functionDeclaration, parseId(parser));
     if (functionDeclaration->right == nullptr) { SYNTAX_ERROR(PARSE_ERROR_ID_NEEDED); }
 
-    if (getFunction(parser->table, functionDeclaration->right->data.id) != nullptr)
+    functionDeclaration->right->line = line;
+
+    if (getFunction(parser->table, functionDeclaration->right->data.id.name) != nullptr)
     {
         SYNTAX_ERROR(PARSE_ERROR_FUNCTION_SECOND_DECLARATION);
     }
 
-    parser->curFunction = pushFunction(parser->table, functionDeclaration->right->data.id);
+    parser->curFunction = pushFunction(parser->table, functionDeclaration->right->data.id.name);
 
     Node* params = parseParamList(parser);
 
-    if (params == nullptr && !isNumber(curToken(parser), 0))
+    if (params == nullptr && !isNumber(parser->tokenizer, curToken(parser), 0))
     {
         SYNTAX_ERROR(PARSE_ERROR_FUNCTION_PARAMS_NEEDED);
     }
 
-    if (isNumber(curToken(parser), 0))
+    if (isNumber(parser->tokenizer, curToken(parser), 0))
     {
         proceed(parser);
     }
@@ -378,7 +435,7 @@ Node* parseBlock(Parser* parser)
     REQUIRE_KEYWORD(OPEN_BRACE_KEYWORD, PARSE_ERROR_OPEN_BRACE_NEEDED);
     REQUIRE_NEW_LINES();
 
-    Node* block = newNode(BLOCK_TYPE, {}, nullptr, parseStatement(parser));
+    Node* block = newNode(&parser->arena, BLOCK_TYPE, {}, nullptr, parseStatement(parser));
     Node* statement = block->right;
 
     while (statement != nullptr)
@@ -397,13 +454,16 @@ Node* parseStatement(Parser* parser)
 {
     ASSERT_PARSER(parser);
 
-    Node* node = parseCmdLine(parser);
+    uint32_t line = curLine(parser);
+    Node*    node = parseCmdLine(parser);
 
     if (node == nullptr) { node = parseCondition(parser); }
     if (node == nullptr) { node = parseLoop(parser);      }
     if (node == nullptr) { return nullptr;                }
 
-    Node* statement = newNode(STATEMENT_TYPE, {}, node, nullptr);
+    node->line = line;
+
+    Node* statement = newNode(&parser->arena, STATEMENT_TYPE, {}, node, nullptr);
     // setLeft(statement, node);
 
     return statement;
@@ -447,7 +507,7 @@ Node* parseJump(Parser* parser)
     Node* expression = parseExpression(parser);
     if (expression == nullptr) { SYNTAX_ERROR(PARSE_ERROR_RETURN_EXPRESSION_NEEDED); } 
 
-    return newNode(JUMP_TYPE, {}, nullptr, expression);
+    return newNode(&parser->arena, JUMP_TYPE, {}, nullptr, expression);
 }
 
 Node* parseExpression(Parser* parser)
@@ -460,7 +520,7 @@ Node* parseExpression(Parser* parser)
 
     while (isComparand(curToken(parser)))
     {
-        KeywordCode operation = curToken(parser)->data.keywordCode;
+        KeywordCode operation = tokenKeyword(curToken(parser));
 
         proceed(parser);
 
@@ -469,12 +529,12 @@ Node* parseExpression(Parser* parser)
 
         switch (operation)
         {
-            case EQUAL_KEYWORD:         { comparand1 = BINARY_OP(EQUAL,         comparand1, comparand2); break; }
-            case NOT_EQUAL_KEYWORD:     { comparand1 = BINARY_OP(NOT_EQUAL,     comparand1, comparand2); break; }
-            case LESS_KEYWORD:          { comparand1 = BINARY_OP(LESS,          comparand1, comparand2); break; }
-            case GREATER_KEYWORD:       { comparand1 = BINARY_OP(GREATER,       comparand1, comparand2); break; }
-            case LESS_EQUAL_KEYWORD:    { comparand1 = BINARY_OP(LESS_EQUAL,    comparand1, comparand2); break; }
-            case GREATER_EQUAL_KEYWORD: { comparand1 = BINARY_OP(GREATER_EQUAL, comparand1, comparand2); break; }
+            case EQUAL_KEYWORD:         { comparand1 = BINARY_OP(&parser->arena, EQUAL,         comparand1, comparand2); break; }
+            case NOT_EQUAL_KEYWORD:     { comparand1 = BINARY_OP(&parser->arena, NOT_EQUAL,     comparand1, comparand2); break; }
+            case LESS_KEYWORD:          { comparand1 = BINARY_OP(&parser->arena, LESS,          comparand1, comparand2); break; }
+            case GREATER_KEYWORD:       { comparand1 = BINARY_OP(&parser->arena, GREATER,       comparand1, comparand2); break; }
+            case LESS_EQUAL_KEYWORD:    { comparand1 = BINARY_OP(&parser->arena, LESS_EQUAL,    comparand1, comparand2); break; }
+            case GREATER_EQUAL_KEYWORD: { comparand1 = BINARY_OP(&parser->arena, GREATER_EQUAL, comparand1, comparand2); break; }
 
             default: SYNTAX_ERROR(PARSE_ERROR_INVALID_COMPARISON_OPERATION);
         }
@@ -492,7 +552,7 @@ Node* parseComparand(Parser* parser)
 
     while (isKeyword(curToken(parser), PLUS_KEYWORD) || isKeyword(curToken(parser), MINUS_KEYWORD))
     {
-        KeywordCode operation = curToken(parser)->data.keywordCode;
+        KeywordCode operation = tokenKeyword(curToken(parser));
 
         proceed(parser);
 
@@ -501,8 +561,8 @@ Node* parseComparand(Parser* parser)
 
         switch (operation)
         {
-            case PLUS_KEYWORD:  { term1 = BINARY_OP(ADD, term1, term2); break; }
-            case MINUS_KEYWORD: { term1 = BINARY_OP(SUB, term1, term2); break; }
+            case PLUS_KEYWORD:  { term1 = BINARY_OP(&parser->arena, ADD, term1, term2); break; }
+            case MINUS_KEYWORD: { term1 = BINARY_OP(&parser->arena, SUB, term1, term2); break; }
 
             default: SYNTAX_ERROR(PARSE_ERROR_INVALID_TERM_OPERATION);
         }
@@ -520,7 +580,7 @@ Node* parseTerm(Parser* parser)
 
     while (isKeyword(curToken(parser), MUL_KEYWORD) || isKeyword(curToken(parser), DIV_KEYWORD))
     {
-        KeywordCode operation = curToken(parser)->data.keywordCode;
+        KeywordCode operation = tokenKeyword(curToken(parser));
 
         proceed(parser);
 
@@ -529,8 +589,8 @@ Node* parseTerm(Parser* parser)
 
         switch (operation)
         {
-            case MUL_KEYWORD: { factor1 = BINARY_OP(MUL, factor1, factor2); break; }
-            case DIV_KEYWORD: { factor1 = BINARY_OP(DIV, factor1, factor2); break; }
+            case MUL_KEYWORD: { factor1 = BINARY_OP(&parser->arena, MUL, factor1, factor2); break; }
+            case DIV_KEYWORD: { factor1 = BINARY_OP(&parser->arena, DIV, factor1, factor2); break; }
 
             default: SYNTAX_ERROR(PARSE_ERROR_INVALID_FACTOR_OPERATION);
         }
@@ -554,7 +614,7 @@ Node* parseFactor(Parser* parser)
     factor = parseMemAccess(parser);
     if (factor != nullptr) { return factor; }
 
-    switch (curToken(parser)->data.keywordCode)
+    switch (tokenKeyword(curToken(parser)))
     {
         case BRACKET_KEYWORD:
         {
@@ -572,7 +632,7 @@ Node* parseFactor(Parser* parser)
             factor = parseId(parser);
             if (factor == nullptr) { SYNTAX_ERROR(PARSE_ERROR_DEREFERENCING_NO_VARIABLE); }
     
-            REQUIRE_VAR_DECLARED(factor->data.id);
+            REQUIRE_VAR_DECLARED(factor);
 
             break;
         }
@@ -582,9 +642,9 @@ Node* parseFactor(Parser* parser)
 
         case SCAN_KEYWORD:
         {
-            Node* scanId = ID(getStdFunctionInfo(SCAN_KEYWORD)->workingName);
+            Node* scanId = ID(&parser->arena, getStdFunctionInfo(SCAN_KEYWORD)->workingName);
 
-            factor = newNode(CALL_TYPE, {}, scanId, nullptr);
+            factor = newNode(&parser->arena, CALL_TYPE, {}, scanId, nullptr);
             proceed(parser);
             break;
         }
@@ -592,16 +652,16 @@ Node* parseFactor(Parser* parser)
         case SCAN_FLOAT_KEYWORD:
         {
             proceed(parser);
-            Node* scanFloatId = ID(getStdFunctionInfo(SCAN_FLOAT_KEYWORD)->workingName);
-            Node* param       = newNode(EXPR_LIST_TYPE, {}, parseExpression(parser), nullptr);
-            factor = newNode(CALL_TYPE, {}, scanFloatId, param);
+            Node* scanFloatId = ID(&parser->arena, getStdFunctionInfo(SCAN_FLOAT_KEYWORD)->workingName);
+            Node* param       = newNode(&parser->arena, EXPR_LIST_TYPE, {}, parseExpression(parser), nullptr);
+            factor = newNode(&parser->arena, CALL_TYPE, {}, scanFloatId, param);
             
             break;
         }
 
         case RAND_JUMP_KEYWORD:
         {
-            factor = newNode(CALL_TYPE, {}, ID(KEYWORDS[RAND_JUMP_KEYWORD].string), nullptr);
+            factor = newNode(&parser->arena, CALL_TYPE, {}, ID(&parser->arena, KEYWORDS[RAND_JUMP_KEYWORD].string), nullptr);
             proceed(parser);
             break;
         }
@@ -630,7 +690,7 @@ Node* parseCondition(Parser* parser)
     Node* trueBlock = parseBlock(parser);
     if (trueBlock == nullptr) { SYNTAX_ERROR(PARSE_ERROR_IF_BLOCK_NEEDED); }
     
-    Node* conditionRoot = newNode(COND_TYPE, {}, expression, newNode(IFELSE_TYPE, {}, trueBlock, nullptr));
+    Node* conditionRoot = newNode(&parser->arena, COND_TYPE, {}, expression, newNode(&parser->arena, IFELSE_TYPE, {}, trueBlock, nullptr));
 
     if (isKeyword(curToken(parser), ELSE_KEYWORD))
     {
@@ -663,7 +723,7 @@ Node* parseLoop(Parser* parser)
     Node* block = parseBlock(parser);
     if (block == nullptr) { SYNTAX_ERROR(PARSE_ERROR_LOOP_BLOCK_NEEDED); }
 
-    return newNode(LOOP_TYPE, {}, expression, block);
+    return newNode(&parser->arena, LOOP_TYPE, {}, expression, block);
 }
 
 Node* parseVDeclaration(Parser* parser)
@@ -676,8 +736,8 @@ Node* parseVDeclaration(Parser* parser)
 
     if (!isIdType(curToken(parser))) { SYNTAX_ERROR(PARSE_ERROR_VARIABLE_DECLARATION_NO_ASSIGNMENT); }
 
-    const char* id = curToken(parser)->data.id;
-    if (getVarOffset(parser->curFunction, id) != -1) { SYNTAX_ERROR(PARSE_ERROR_VARIABLE_SECOND_DECLARATION); }
+    const char* id = tokenData(parser->tokenizer, curToken(parser)).id;
+    if (getVarSlot(parser->curFunction, id) != NO_VAR_SLOT) { SYNTAX_ERROR(PARSE_ERROR_VARIABLE_SECOND_DECLARATION); }
 
     pushVariable(parser->curFunction, id);
 
@@ -701,16 +761,18 @@ Node* parseADeclaration(Parser* parser)
 
     if (!isIdType(curToken(parser))) { SYNTAX_ERROR(PARSE_ERROR_ID_NEEDED); }
 
-    const char* id = curToken(parser)->data.id;
-    if (getVarOffset(parser->curFunction, id) != -1) { SYNTAX_ERROR(PARSE_ERROR_VARIABLE_SECOND_DECLARATION); }
+    const char* id = tokenData(parser->tokenizer, curToken(parser)).id;
+    if (getVarSlot(parser->curFunction, id) != NO_VAR_SLOT) { SYNTAX_ERROR(PARSE_ERROR_VARIABLE_SECOND_DECLARATION); }
     pushVariable(parser->curFunction, id);
 
-    Node* arrayDeclaration = newNode(ADECL_TYPE, {}, parseId(parser), nullptr);
+    Node* arrayDeclaration = newNode(&parser->arena, ADECL_TYPE, {}, parseId(parser), nullptr);
     if (arrayDeclaration->left == nullptr)
     {
         SYNTAX_ERROR(PARSE_ERROR_ARRAY_DECLARATION_NO_NAME);
     }
 
+    resolveVar(parser, arrayDeclaration->left);
+
     REQUIRE_KEYWORD(COMMA_KEYWORD, PARSE_ERROR_ARRAY_DECLARATION_NO_COMMA);
 
     setRight(arrayDeclaration, parseExpression(parser));
@@ -728,7 +790,14 @@ Node* parseAssignment(Parser* parser)
 
     size_t assignmentStart = parser->offset;
 
+    /* The lvalue may turn out not to be followed by an assignment, in which 
+     * case the parser has to go back to its start. */
+    size_t pinnedOffset = parser->pinnedOffset;
+    if (assignmentStart < pinnedOffset) { parser->pinnedOffset = assignmentStart; }
+
     Node* lvalue = parseLValue(parser);
+
+    parser->pinnedOffset = pinnedOffset;
     if (lvalue == nullptr) { return nullptr; }
 
     if (!isKeyword(curToken(parser), ASSIGN_KEYWORD))
@@ -737,16 +806,18 @@ Node* parseAssignment(Parser* parser)
         return nullptr;
     }
 
+    if (lvalue->type == ID_TYPE && lvalue->data.id.varSlot == NO_VAR_SLOT)
+    {
+        parser->offset = assignmentStart;
+        SYNTAX_ERROR(PARSE_ERROR_VARIABLE_UNDECLARED_USAGE);
+    }
+
     proceed(parser);
 
     Node* expression = parseExpression(parser);
     if (expression == nullptr) { SYNTAX_ERROR(PARSE_ERROR_VARIABLE_ASSIGNMENT_NO_EXPRESSION); }
 
-    // Node* variable = parseId(parser);
-    // REQUIRE_VAR_DECLARED(variable->data.id); // TODO: add this to every place I use arrays!
-    // REQUIRE_KEYWORD(ASSIGN_KEYWORD, PARSE_ERROR_VARIABLE_DECLARATION_NO_ASSIGNMENT);
-
-    return newNode(ASSIGN_TYPE, {}, lvalue, expression);
+    return newNode(&parser->arena, ASSIGN_TYPE, {}, lvalue, expression);
 }
 
 Node* parseLValue(Parser* parser)
@@ -756,7 +827,9 @@ Node* parseLValue(Parser* parser)
     Node* lvalue = parseMemAccess(parser);
     if (lvalue == nullptr)
     {
+        /* Whether it's declared is checked once it turns out to be assigned. */
         lvalue = parseId(parser);
+        if (lvalue != nullptr) { resolveVar(parser, lvalue); }
     }
 
     return lvalue;
@@ -787,7 +860,7 @@ Node* parseCall(Parser* parser)
 
     REQUIRE_KEYWORD(BRACKET_KEYWORD, PARSE_ERROR_BRACKET_NEEDED);
 
-    return newNode(CALL_TYPE, {}, function, exprList);
+    return newNode(&parser->arena, CALL_TYPE, {}, function, exprList);
 }
 
 Node* parsePrintFloat(Parser* parser)
@@ -805,12 +878,12 @@ Node* parsePrintFloat(Parser* parser)
     Node* expression = parseExpression(parser);
     if (expression == nullptr) { SYNTAX_ERROR(PARSE_ERROR_PRINT_FLOAT_EXPRESSION_NEEDED); }
 
-    Node* firstParam   = newNode(EXPR_LIST_TYPE, {}, precision,  nullptr);
-    Node* secondParam  = newNode(EXPR_LIST_TYPE, {}, expression, firstParam);
+    Node* firstParam   = newNode(&parser->arena, EXPR_LIST_TYPE, {}, precision,  nullptr);
+    Node* secondParam  = newNode(&parser->arena, EXPR_LIST_TYPE, {}, expression, firstParam);
 
-    Node* printFloatId = ID(getStdFunctionInfo(PRINT_FLOAT_KEYWORD)->workingName);
+    Node* printFloatId = ID(&parser->arena, getStdFunctionInfo(PRINT_FLOAT_KEYWORD)->workingName);
 
-    return newNode(CALL_TYPE, {}, printFloatId, secondParam);
+    return newNode(&parser->arena, CALL_TYPE, {}, printFloatId, secondParam);
 }
 
 Node* parsePrintString(Parser* parser)
@@ -820,44 +893,38 @@ Node* parsePrintString(Parser* parser)
     if (!isKeyword(curToken(parser), PRINT_STRING_KEYWORD)) { return nullptr; }
     proceed(parser);
 
-    Node* paramList     = newNode(EXPR_LIST_TYPE, {}, nullptr, nullptr);
-    Node* printStringId = ID(getStdFunctionInfo(PRINT_STRING_KEYWORD)->workingName);
+    Node* paramList     = newNode(&parser->arena, EXPR_LIST_TYPE, {}, nullptr, nullptr);
+    Node* printStringId = ID(&parser->arena, getStdFunctionInfo(PRINT_STRING_KEYWORD)->workingName);
 
     if (isKeyword(curToken(parser), STR_NEW_LINE_KEYWORD))
     {
         proceed(parser);
 
-        if (getStringByContent(parser->table, "\n") == nullptr)
-        {
-            pushString(parser->table, {nullptr, "\n"});
-        }
+        pushString(parser->table, {nullptr, "\n", false});
 
-        setLeft(paramList, newNode(STRING_TYPE, {.string = "\n"}, nullptr, nullptr));
-        return newNode(CALL_TYPE, {}, printStringId, paramList);
+        setLeft(paramList, newNode(&parser->arena, STRING_TYPE, {.string = "\n"}, nullptr, nullptr));
+        return newNode(&parser->arena, CALL_TYPE, {}, printStringId, paramList);
     }
 
     Node* stringId = parseStringId(parser);
     if (stringId != nullptr)
     {
-        if (getStringByName(parser->table, stringId->data.id) == nullptr)
+        if (getStringByName(parser->table, stringId->data.id.name) == NO_STRING)
         {
             SYNTAX_ERROR(PARSE_ERROR_PRINT_STRING_UNDECLARED_STRING_ID);
         }
 
         setLeft(paramList, stringId);
-        return newNode(CALL_TYPE, {}, printStringId, paramList);
+        return newNode(&parser->arena, CALL_TYPE, {}, printStringId, paramList);
     }
 
     Node* quotedString = parseQuotedString(parser);
     if (quotedString != nullptr)
     {
-        if (getStringByContent(parser->table, quotedString->data.string) == nullptr)
-        {
-            pushString(parser->table, {nullptr, quotedString->data.string});
-        }
+        pushString(parser->table, {nullptr, quotedString->data.string, false});
 
         setLeft(paramList, quotedString);
-        return newNode(CALL_TYPE, {}, printStringId, paramList);
+        return newNode(&parser->arena, CALL_TYPE, {}, printStringId, paramList);
     }
 
     SYNTAX_ERROR(PARSE_ERROR_PRINT_STRING_INVALID_ARGUMENT);
@@ -873,10 +940,10 @@ Node* parsePrint(Parser* parser)
     Node* expression = parseExpression(parser);
     if (expression == nullptr) { SYNTAX_ERROR(PARSE_ERROR_PRINT_EXPRESSION_NEEDED); }
 
-    Node* paramList = newNode(EXPR_LIST_TYPE, {}, expression, nullptr);
-    Node* printId   = ID(getStdFunctionInfo(PRINT_KEYWORD)->workingName);
+    Node* paramList = newNode(&parser->arena, EXPR_LIST_TYPE, {}, expression, nullptr);
+    Node* printId   = ID(&parser->arena, getStdFunctionInfo(PRINT_KEYWORD)->workingName);
 
-    return newNode(CALL_TYPE, {}, printId, paramList);
+    return newNode(&parser->arena, CALL_TYPE, {}, printId, paramList);
 }
 
 Node* parseStandardFunc(Parser* parser, KeywordCode keywordCode)
@@ -893,9 +960,9 @@ Node* parseStandardFunc(Parser* parser, KeywordCode keywordCode)
 
     REQUIRE_KEYWORD(BRACKET_KEYWORD, PARSE_ERROR_BRACKET_NEEDED);
 
-    Node* paramList = newNode(EXPR_LIST_TYPE, {}, expression, nullptr);
+    Node* paramList = newNode(&parser->arena, EXPR_LIST_TYPE, {}, expression, nullptr);
 
-    return newNode(CALL_TYPE, {}, ID(KEYWORDS[keywordCode].string), paramList);
+    return newNode(&parser->arena, CALL_TYPE, {}, ID(&parser->arena, KEYWORDS[keywordCode].string), paramList);
 }
 
 Node* parseSqrt(Parser* parser)
@@ -912,9 +979,9 @@ Node* parseSqrt(Parser* parser)
 
     REQUIRE_KEYWORD(BRACKET_KEYWORD, PARSE_ERROR_BRACKET_NEEDED);
 
-    Node* paramList = newNode(EXPR_LIST_TYPE, {}, expression, nullptr);
+    Node* paramList = newNode(&parser->arena, EXPR_LIST_TYPE, {}, expression, nullptr);
 
-    return newNode(CALL_TYPE, {}, ID(KEYWORDS[SQRT_KEYWORD].string), paramList);
+    return newNode(&parser->arena, CALL_TYPE, {}, ID(&parser->arena, KEYWORDS[SQRT_KEYWORD].string), paramList);
 }
 
 Node* parseExprList(Parser* parser)
@@ -924,7 +991,7 @@ Node* parseExprList(Parser* parser)
     Node* expression = parseExpression(parser);
     if (expression == nullptr) { return nullptr; }
 
-    Node* paramList = newNode(EXPR_LIST_TYPE, {}, expression, nullptr);
+    Node* paramList = newNode(&parser->arena, EXPR_LIST_TYPE, {}, expression, nullptr);
 
     while (isKeyword(curToken(parser), COMMA_KEYWORD))
     {
@@ -933,7 +1000,7 @@ Node* parseExprList(Parser* parser)
         Node* nextExpression = parseExpression(parser);
         if (nextExpression == nullptr) { SYNTAX_ERROR(PARSE_ERROR_FUNCTION_PARAMS_NEEDED); }
 
-        paramList = newNode(EXPR_LIST_TYPE, {}, nextExpression, paramList);
+        paramList = newNode(&parser->arena, EXPR_LIST_TYPE, {}, nextExpression, paramList);
     }
 
     return paramList;
@@ -947,7 +1014,7 @@ Node* parseParamList(Parser* parser)
     if (param == nullptr) { return nullptr; }
 
     Node* prevParam = param;
-    pushParameter(parser->curFunction, prevParam->data.id);
+    pushParameter(parser->curFunction, prevParam->data.id.name);
 
     while (isKeyword(curToken(parser), COMMA_KEYWORD))
     {
@@ -957,7 +1024,7 @@ Node* parseParamList(Parser* parser)
         if (prevParam->right == nullptr) { SYNTAX_ERROR(PARSE_ERROR_FUNCTION_PARAMS_NEEDED); }
 
         prevParam = prevParam->right;
-        pushParameter(parser->curFunction, prevParam->data.id);
+        pushParameter(parser->curFunction, prevParam->data.id.name);
     }
 
     return param;
@@ -994,8 +1061,8 @@ Node* parseQuotedString(Parser* parser)
         SYNTAX_ERROR(PARSE_ERROR_NO_STRING_AFTER_QUOTE);
     }
 
-    Node* string = newNode(STRING_TYPE, 
-                           {.string = curToken(parser)->data.quotedString}, 
+    Node* string = newNode(&parser->arena, STRING_TYPE, 
+                           {.string = tokenData(parser->tokenizer, curToken(parser)).quotedString}, 
                            nullptr, 
                            nullptr);
 
@@ -1011,10 +1078,26 @@ Node* parseId(Parser* parser)
 
     if (!isIdType(curToken(parser))) { return nullptr; }
 
-    const char* id = curToken(parser)->data.id;
+    const char* id = tokenData(parser->tokenizer, curToken(parser)).id;
     proceed(parser);
 
-    return newNode(ID_TYPE, { .id = id }, nullptr, nullptr);
+    return newNode(&parser->arena, ID_TYPE, { .id = { id, NO_VAR_SLOT } }, nullptr, nullptr);
+}
+
+//------------------------------------------------------------------------------
+//! Resolves id to the slot of the current function's variable.
+//!
+//! @return Whether the variable is declared.
+//------------------------------------------------------------------------------
+bool resolveVar(Parser* parser, Node* id)
+{
+    ASSERT_PARSER(parser);
+    assert(id);
+    assert(id->type == ID_TYPE);
+
+    id->data.id.varSlot = getVarSlot(parser->curFunction, id->data.id.name);
+
+    return id->data.id.varSlot != NO_VAR_SLOT;
 }
 
 Node* parseMemAccess(Parser* parser)
@@ -1023,12 +1106,13 @@ Node* parseMemAccess(Parser* parser)
 
     if (!isIdType(curToken(parser)) || 
         isEndReached(parser) || 
-        !isKeyword(curToken(parser) + 1, MEM_ACCESS_KEYWORD)) 
+        !isKeyword(fetchToken(parser->tokenizer, parser->offset + 1), MEM_ACCESS_KEYWORD)) 
     {
         return nullptr;
     }
 
-    Node* memAccess = newNode(MEM_ACCESS_TYPE, {}, parseId(parser), nullptr);
+    Node* memAccess = newNode(&parser->arena, MEM_ACCESS_TYPE, {}, parseId(parser), nullptr);
+    REQUIRE_VAR_DECLARED(memAccess->left);
     proceed(parser);
 
     setRight(memAccess, parseExpression(parser));
@@ -1045,8 +1129,8 @@ Node* parseNumber(Parser* parser)
 
     if (!isNumberType(curToken(parser))) { return nullptr; }
 
-    int64_t number = curToken(parser)->data.number;
+    int64_t number = tokenData(parser->tokenizer, curToken(parser)).number;
     proceed(parser);
 
-    return newNode(NUMBER_TYPE, { .number = number }, nullptr, nullptr);
+    return newNode(&parser->arena, NUMBER_TYPE, { .number = number }, nullptr, nullptr);
 }
\ No newline at end of file
@@ -1,6 +1,8 @@
 #ifndef PARSER_H
 #define PARSER_H
 
+#include <stdint.h>
+#include <stdio.h>
 #include "tokenizer.h"
 #include "expression_tree.h"
 #include "../symbol_table/symbol_table.h"
@@ -151,19 +153,32 @@ static const char* PARSE_ERROR_STRINGS[TOTAL_PARSE_ERRORS] =
     "all global string have to be declared before any function declarations"
 };
 
+/* How far back proceed() may step. Only parseAssignment() goes back further,
+ * so it pins its starting token in order for it not to be released. */
+static const size_t PARSER_MAX_REWIND     = 1;
+static const size_t PARSER_NOTHING_PINNED = SIZE_MAX;
+
 struct Parser
 {
     Tokenizer*   tokenizer;
     size_t       offset;
+    size_t       pinnedOffset; /* the earliest token that may be rewound to */
     ParseError   status;
 
     SymbolTable* table;
     Function*    curFunction;
+
+    NodeArena    arena; /* owns the nodes of the parsed tree */
+
+    bool         areLinesNeeded; /* whether nodes get their source lines */
+    FILE*        errorsFile;     /* syntax errors are reported to, stdout by default */
 };
 
-void        construct    (Parser* parser, Tokenizer* tokenizer);
-void        destroy      (Parser* parser);
-const char* errorString  (ParseError error);
-ParseError  parseProgram (Parser* parser, SymbolTable* table, Node** root);
+void        construct     (Parser* parser, Tokenizer* tokenizer);
+void        destroy       (Parser* parser);
+void        recordLines   (Parser* parser);
+void        setErrorsFile (Parser* parser, FILE* errorsFile);
+const char* errorString   (ParseError error);
+ParseError  parseProgram  (Parser* parser, SymbolTable* table, Node** root);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,77 @@
+#include <assert.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <file_manager/file_manager.h>
+#include "source_file.h"
+
+bool mapSource (SourceFile* source, const char* filename);
+
+bool loadSource(SourceFile* source, const char* filename)
+{
+    assert(source);
+    assert(filename);
+
+    *source = {};
+
+    if (mapSource(source, filename)) { return true; }
+
+    char*  buffer     = nullptr;
+    size_t bufferSize = 0;
+
+    if (!loadFile(filename, &buffer, &bufferSize)) { return false; }
+
+    source->buffer   = buffer;
+    source->size     = bufferSize;
+    source->isMapped = false;
+
+    return true;
+}
+
+bool mapSource(SourceFile* source, const char* filename)
+{
+    assert(source);
+    assert(filename);
+
+    int fd = open(filename, O_RDONLY);
+    if (fd == -1) { return false; }
+
+    struct stat fileStat = {};
+    if (fstat(fd, &fileStat) == -1 || !S_ISREG(fileStat.st_mode) || fileStat.st_size == 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    void* mapped = mmap(nullptr, (size_t) fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (mapped == MAP_FAILED) { return false; }
+
+    /* The tokenizer reads the source once from the beginning to the end. */
+    madvise(mapped, (size_t) fileStat.st_size, MADV_SEQUENTIAL);
+
+    source->buffer   = (const char*) mapped;
+    source->size     = (size_t) fileStat.st_size;
+    source->isMapped = true;
+
+    return true;
+}
+
+void destroy(SourceFile* source)
+{
+    assert(source);
+
+    if (source->isMapped)
+    {
+        munmap((void*) source->buffer, source->size);
+    }
+    else
+    {
+        free((void*) source->buffer);
+    }
+
+    *source = {};
+}
@@ -0,0 +1,28 @@
+#ifndef SOURCE_FILE_H
+#define SOURCE_FILE_H
+
+#include <stdlib.h>
+
+//------------------------------------------------------------------------------
+//! Read-only program source. Regular files are memory-mapped, so there's no 
+//! heap copy of them and the buffer is NOT terminated with '\0'. If the file 
+//! can't be mapped (e.g. it's a pipe), it is loaded into the heap instead.
+//------------------------------------------------------------------------------
+struct SourceFile
+{
+    const char* buffer;
+    size_t      size;
+    bool        isMapped;
+};
+
+//------------------------------------------------------------------------------
+//! @param source
+//! @param filename
+//!
+//! @return Whether the file has been opened successfully.
+//------------------------------------------------------------------------------
+bool loadSource (SourceFile* source, const char* filename);
+
+void destroy    (SourceFile* source);
+
+#endif
@@ -100,11 +100,11 @@ struct Keyword
     const char* codeString;
 };
 
-static const char* ID_VALID_SYMBOLS = "abcdefghijklmnopqrstuvwxyz"
-                                      "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+static constexpr char ID_VALID_SYMBOLS[] = "abcdefghijklmnopqrstuvwxyz"
+                                           "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
 
 #define TO_STR(keywordCode) #keywordCode
-static const Keyword KEYWORDS[KEYWORDS_COUNT] = 
+static constexpr Keyword KEYWORDS[KEYWORDS_COUNT] = 
 {
     { "Godric's-Hollow",   15, PROG_START_KEYWORD,    TO_STR(PROG_START_KEYWORD)    },
     { "Privet-Drive",      12, PROG_END_KEYWORD,      TO_STR(PROG_END_KEYWORD)      },
@@ -2,175 +2,831 @@
 #include <stdio.h>
 #include <string.h>
 #include <inttypes.h>
+#include <pthread.h>
 
 #include "tokenizer.h"
+#include "keyword_trie.h"
+#include "char_scanner.h"
 #include "../../libs/utilib.h"
 
 #define ASSERT_TOKENIZER(tokenizer) assert((tokenizer));           \
                                     assert((tokenizer)->buffer);   \
-                                    assert((tokenizer)->position); \
-                                    assert((tokenizer)->tokens); 
-
-const size_t MAX_TOKENS_COUNT = 8192;
+                                    assert((tokenizer)->position);
 
 bool    finished            (Tokenizer* tokenizer);
+void    setEndToken         (Tokenizer* tokenizer);
 void    skipSpaces          (Tokenizer* tokenizer);
 void    proceed             (Tokenizer* tokenizer, size_t step);
-void    addToken            (Tokenizer* tokenizer, Token token);
+void    addToken            (Tokenizer* tokenizer, uint8_t kind, TokenData data);
+
+enum LexemeType
+{
+    LEXEME_NONE,
+    LEXEME_NUMBER,
+    LEXEME_KEYWORD,
+    LEXEME_ID
+};
+
+struct Lexeme
+{
+    LexemeType  type;
+    size_t      length;
+    KeywordCode keywordCode;
+};
+
+static constexpr KeywordTrie KEYWORD_TRIE = buildKeywordTrie();
 
 bool    processQuotedString (Tokenizer* tokenizer);
-bool    processKeyword      (Tokenizer* tokenizer);
+Lexeme  scanLexeme          (const Tokenizer* tokenizer);
+bool    processLexeme       (Tokenizer* tokenizer);
+void    processKeyword      (Tokenizer* tokenizer, Keyword keyword);
 bool    isKeywordNumber     (Keyword keyword);
 int64_t keywordToNumber     (Keyword keyword);
-bool    processNumeric      (Tokenizer* tokenizer);
-bool    processId           (Tokenizer* tokenizer);
+void    processNumeric      (Tokenizer* tokenizer, size_t length);
+void    processId           (Tokenizer* tokenizer, size_t length);
+
+static inline bool hasData(uint8_t kind)
+{
+    return kind == TOKEN_KIND_QUOTED_STRING || kind == TOKEN_KIND_NUMBER || kind == TOKEN_KIND_ID;
+}
+
+//----------------------------------TokenStore----------------------------------
+void construct(TokenStore* store)
+{
+    assert(store);
+
+    for (size_t i = 0; i < TOKEN_CHUNKS_MAX_COUNT; i++)
+    {
+        store->kinds[i]    = nullptr;
+        store->payloads[i] = nullptr;
+        store->offsets[i]  = nullptr;
+        store->data[i]     = nullptr;
+    }
+
+    store->chunksCount     = 0;
+    store->count           = 0;
+    store->dataChunksCount = 0;
+    store->dataCount       = 0;
+}
+
+void destroy(TokenStore* store)
+{
+    assert(store);
+
+    for (size_t i = 0; i < store->chunksCount; i++)
+    {
+        free(store->kinds[i]);
+        free(store->payloads[i]);
+        free(store->offsets[i]);
+    }
+
+    for (size_t i = 0; i < store->dataChunksCount; i++)
+    {
+        free(store->data[i]);
+    }
+
+    construct(store);
+}
+
+//------------------------------------------------------------------------------
+//! Chunk k holds TOKEN_CHUNK_FIRST_SIZE * 2^k tokens, so after biasing the
+//! index by TOKEN_CHUNK_FIRST_SIZE, the chunk number is given by the position
+//! of its highest set bit and the offset inside the chunk by the rest of bits.
+//------------------------------------------------------------------------------
+static inline size_t tokenChunk(size_t index)
+{
+    size_t biased = index + TOKEN_CHUNK_FIRST_SIZE;
+    return (63 - __builtin_clzll(biased)) - TOKEN_CHUNK_FIRST_SIZE_LOG;
+}
+
+static inline size_t tokenChunkOffset(size_t index, size_t chunk)
+{
+    return index + TOKEN_CHUNK_FIRST_SIZE - (TOKEN_CHUNK_FIRST_SIZE << chunk);
+}
+
+//------------------------------------------------------------------------------
+//! @return Chunk the next token (or data) is to be put in, which is allocated
+//!         if needed.
+//------------------------------------------------------------------------------
+static size_t nextTokenChunk(TokenStore* store)
+{
+    assert(store);
+
+    size_t chunk = tokenChunk(store->count);
+    assert(chunk < TOKEN_CHUNKS_MAX_COUNT);
+
+    if (chunk == store->chunksCount)
+    {
+        size_t chunkSize = TOKEN_CHUNK_FIRST_SIZE << chunk;
+
+        store->kinds[chunk]    = (uint8_t*)  calloc(chunkSize, sizeof(uint8_t));
+        store->payloads[chunk] = (uint32_t*) calloc(chunkSize, sizeof(uint32_t));
+        store->offsets[chunk]  = (uint32_t*) calloc(chunkSize, sizeof(uint32_t));
+        assert(store->kinds[chunk] && store->payloads[chunk] && store->offsets[chunk]);
+
+        store->chunksCount++;
+    }
+
+    return chunk;
+}
+
+static size_t nextDataChunk(TokenStore* store)
+{
+    assert(store);
+
+    size_t dataChunk = tokenChunk(store->dataCount);
+    assert(dataChunk < TOKEN_CHUNKS_MAX_COUNT);
+    assert(store->dataCount < UINT32_MAX);
+
+    if (dataChunk == store->dataChunksCount)
+    {
+        store->data[dataChunk] = (TokenData*) calloc(TOKEN_CHUNK_FIRST_SIZE << dataChunk, sizeof(TokenData));
+        assert(store->data[dataChunk]);
+
+        store->dataChunksCount++;
+    }
+
+    return dataChunk;
+}
+
+void pushToken(TokenStore* store, uint8_t kind, TokenData data, uint32_t offset)
+{
+    assert(store);
+
+    /* Tokens without data refer to the next data, see releaseTokens(). */
+    uint32_t payload = (uint32_t) store->dataCount;
+
+    if (hasData(kind))
+    {
+        size_t dataChunk = nextDataChunk(store);
+
+        store->data[dataChunk][tokenChunkOffset(store->dataCount, dataChunk)] = data;
+        store->dataCount++;
+    }
+
+    size_t chunk       = nextTokenChunk(store);
+    size_t chunkOffset = tokenChunkOffset(store->count, chunk);
+
+    store->kinds[chunk][chunkOffset]    = kind;
+    store->payloads[chunk][chunkOffset] = payload;
+    store->offsets[chunk][chunkOffset]  = offset;
+    store->count++;
+}
+
+//------------------------------------------------------------------------------
+//! @return Number of elements which can be copied from index other to index
+//!         index at once, as they are in the same chunks in both stores.
+//------------------------------------------------------------------------------
+static inline size_t tokenRunLength(size_t index, size_t otherIndex, size_t left)
+{
+    size_t chunk      = tokenChunk(index);
+    size_t otherChunk = tokenChunk(otherIndex);
+
+    size_t length      = (TOKEN_CHUNK_FIRST_SIZE << chunk)      - tokenChunkOffset(index, chunk);
+    size_t otherLength = (TOKEN_CHUNK_FIRST_SIZE << otherChunk) - tokenChunkOffset(otherIndex, otherChunk);
+
+    if (otherLength < length) { length = otherLength; }
+    if (left < length)        { length = left;        }
+
+    return length;
+}
+
+//------------------------------------------------------------------------------
+//! Appends all the tokens of other to store, shifting their offsets by 
+//! offsetShift. Tokens are copied in runs which are contiguous in both stores.
+//------------------------------------------------------------------------------
+void appendTokens(TokenStore* store, const TokenStore* other, uint32_t offsetShift)
+{
+    assert(store);
+    assert(other);
+    assert(store->dataCount + other->dataCount < UINT32_MAX);
+
+    uint32_t payloadShift = (uint32_t) store->dataCount;
+
+    for (size_t copied = 0; copied < other->dataCount;)
+    {
+        size_t chunk      = nextDataChunk(store);
+        size_t otherChunk = tokenChunk(copied);
+        size_t length     = tokenRunLength(store->dataCount, copied, other->dataCount - copied);
+
+        memcpy(store->data[chunk] + tokenChunkOffset(store->dataCount, chunk),
+               other->data[otherChunk] + tokenChunkOffset(copied, otherChunk),
+               length * sizeof(TokenData));
+
+        store->dataCount += length;
+        copied           += length;
+    }
+
+    for (size_t copied = 0; copied < other->count;)
+    {
+        size_t chunk       = nextTokenChunk(store);
+        size_t chunkOffset = tokenChunkOffset(store->count, chunk);
+        size_t otherChunk  = tokenChunk(copied);
+        size_t otherOffset = tokenChunkOffset(copied, otherChunk);
+        size_t length      = tokenRunLength(store->count, copied, other->count - copied);
+
+        memcpy(store->kinds[chunk] + chunkOffset, other->kinds[otherChunk] + otherOffset, length);
+
+        for (size_t i = 0; i < length; i++)
+        {
+            store->payloads[chunk][chunkOffset + i] = other->payloads[otherChunk][otherOffset + i] + payloadShift;
+            store->offsets[chunk][chunkOffset + i]  = other->offsets[otherChunk][otherOffset + i]  + offsetShift;
+        }
+
+        store->count += length;
+        copied       += length;
+    }
+}
+//----------------------------------TokenStore----------------------------------
+
+//----------------------------------TokenRing-----------------------------------
+void construct(TokenRing* ring)
+{
+    assert(ring);
+
+    ring->kinds    = (uint8_t*)   calloc(TOKEN_RING_INITIAL_CAPACITY, sizeof(uint8_t));
+    ring->payloads = (uint32_t*)  calloc(TOKEN_RING_INITIAL_CAPACITY, sizeof(uint32_t));
+    ring->offsets  = (uint32_t*)  calloc(TOKEN_RING_INITIAL_CAPACITY, sizeof(uint32_t));
+    ring->data     = (TokenData*) calloc(TOKEN_RING_INITIAL_CAPACITY, sizeof(TokenData));
+    assert(ring->kinds && ring->payloads && ring->offsets && ring->data);
 
-void construct(Tokenizer* tokenizer, const char* buffer, size_t bufferSize, bool useNumericNumbers)
+    ring->capacity     = TOKEN_RING_INITIAL_CAPACITY;
+    ring->begin        = 0;
+    ring->end          = 0;
+
+    ring->dataCapacity = TOKEN_RING_INITIAL_CAPACITY;
+    ring->dataBegin    = 0;
+    ring->dataEnd      = 0;
+}
+
+void destroy(TokenRing* ring)
+{
+    assert(ring);
+
+    free(ring->kinds);
+    free(ring->payloads);
+    free(ring->offsets);
+    free(ring->data);
+
+    *ring = {};
+}
+
+//------------------------------------------------------------------------------
+//! @return Copy of elements [begin, end) of the ring with the new capacity.
+//------------------------------------------------------------------------------
+static void* regrowRing(void* elements, size_t elementSize, size_t capacity, size_t newCapacity, 
+                        size_t begin, size_t end)
+{
+    assert(elements);
+
+    uint8_t* newElements = (uint8_t*) calloc(newCapacity, elementSize);
+    assert(newElements);
+
+    for (size_t index = begin; index < end; index++)
+    {
+        memcpy(newElements + (index & (newCapacity - 1)) * elementSize, 
+               (uint8_t*) elements + (index & (capacity - 1)) * elementSize, 
+               elementSize);
+    }
+
+    free(elements);
+
+    return newElements;
+}
+
+void pushToken(TokenRing* ring, uint8_t kind, TokenData data, uint32_t offset)
+{
+    assert(ring);
+    assert(ring->kinds);
+
+    uint32_t payload = (uint32_t) ring->dataEnd;
+
+    if (hasData(kind))
+    {
+        if (ring->dataEnd - ring->dataBegin == ring->dataCapacity)
+        {
+            size_t newCapacity = 2 * ring->dataCapacity;
+
+            ring->data = (TokenData*) regrowRing(ring->data, sizeof(TokenData), ring->dataCapacity, 
+                                                 newCapacity, ring->dataBegin, ring->dataEnd);
+            ring->dataCapacity = newCapacity;
+        }
+
+        assert(ring->dataEnd < UINT32_MAX);
+
+        ring->data[ring->dataEnd & (ring->dataCapacity - 1)] = data;
+        ring->dataEnd++;
+    }
+
+    if (ring->end - ring->begin == ring->capacity)
+    {
+        size_t newCapacity = 2 * ring->capacity;
+
+        ring->kinds    = (uint8_t*)  regrowRing(ring->kinds,    sizeof(uint8_t),  ring->capacity, 
+                                                newCapacity, ring->begin, ring->end);
+        ring->payloads = (uint32_t*) regrowRing(ring->payloads, sizeof(uint32_t), ring->capacity, 
+                                                newCapacity, ring->begin, ring->end);
+        ring->offsets  = (uint32_t*) regrowRing(ring->offsets,  sizeof(uint32_t), ring->capacity, 
+                                                newCapacity, ring->begin, ring->end);
+        ring->capacity = newCapacity;
+    }
+
+    size_t slot = ring->end & (ring->capacity - 1);
+
+    ring->kinds[slot]    = kind;
+    ring->payloads[slot] = payload;
+    ring->offsets[slot]  = offset;
+    ring->end++;
+}
+
+//------------------------------------------------------------------------------
+//! Allows reusing the space of all tokens before index. The payload of the 
+//! first kept token is the first data that may still be needed, no matter 
+//! whether the token has data itself.
+//------------------------------------------------------------------------------
+void releaseTokens(TokenRing* ring, size_t index)
+{
+    assert(ring);
+
+    if (index > ring->end)    { index = ring->end; }
+    if (index <= ring->begin) { return; }
+
+    ring->begin     = index;
+    ring->dataBegin = index < ring->end ? ring->payloads[index & (ring->capacity - 1)] : ring->dataEnd;
+}
+//----------------------------------TokenRing-----------------------------------
+
+void construct(Tokenizer* tokenizer, const char* buffer, size_t bufferSize, bool useNumericNumbers, bool streaming)
 {
     assert(tokenizer);
+    assert(bufferSize <= TOKENIZER_MAX_BUFFER_SIZE);
 
     tokenizer->buffer      = buffer;
     tokenizer->bufferSize  = bufferSize;
     tokenizer->position    = buffer;
 
-    tokenizer->tokens      = (Token*) calloc(MAX_TOKENS_COUNT, sizeof(Token));
-    tokenizer->tokensCount = 0;
-    tokenizer->currentLine = 0;
+    tokenizer->streaming      = streaming;
+    tokenizer->exhausted      = false;
+    tokenizer->deferInterning = false;
+
+    construct(&tokenizer->tokens);
+    tokenizer->ring        = {};
+    if (streaming) { construct(&tokenizer->ring); }
+
+    tokenizer->endToken    = {TOKEN_KIND_END, 0, 0};
+    tokenizer->lineStarts  = nullptr;
+    tokenizer->linesCount  = 0;
 
     tokenizer->useNumericNumbers = useNumericNumbers;
 
-    assert(tokenizer->tokens);
+    skipSpaces(tokenizer);
 }
 
 void destroy(Tokenizer* tokenizer)
 {
     ASSERT_TOKENIZER(tokenizer);
 
-    free(tokenizer->tokens);
+    destroy(&tokenizer->tokens);
+    if (tokenizer->streaming) { destroy(&tokenizer->ring); }
+
+    free(tokenizer->lineStarts);
+    tokenizer->lineStarts  = nullptr;
+    tokenizer->linesCount  = 0;
 
     tokenizer->buffer      = nullptr;
     tokenizer->bufferSize  = 0;
     tokenizer->position    = nullptr;
+}
 
-    tokenizer->tokens      = nullptr;
-    tokenizer->tokensCount = 0;
-    tokenizer->currentLine = 0;
+//------------------------------------------------------------------------------
+//! @return Number of tokens produced so far.
+//------------------------------------------------------------------------------
+size_t tokensCount(const Tokenizer* tokenizer)
+{
+    assert(tokenizer);
+
+    return tokenizer->streaming ? tokenizer->ring.end : tokenizer->tokens.count;
 }
 
-bool isQuotedStringType(const Token* token)
+//------------------------------------------------------------------------------
+//! Doesn't produce new tokens, in the streaming mode index mustn't be released.
+//!
+//! @return Token number index or endToken if it hasn't been produced.
+//------------------------------------------------------------------------------
+Token getToken(const Tokenizer* tokenizer, size_t index)
 {
-    assert(token);
+    assert(tokenizer);
+
+    if (index >= tokensCount(tokenizer)) { return tokenizer->endToken; }
 
-    return token->type == QUOTED_STRING_TOKEN_TYPE;
+    if (tokenizer->streaming)
+    {
+        const TokenRing* ring = &tokenizer->ring;
+        assert(index >= ring->begin);
+
+        size_t slot = index & (ring->capacity - 1);
+        return {ring->kinds[slot], ring->payloads[slot], ring->offsets[slot]};
+    }
+
+    const TokenStore* store       = &tokenizer->tokens;
+    size_t            chunk       = tokenChunk(index);
+    size_t            chunkOffset = tokenChunkOffset(index, chunk);
+
+    return {store->kinds[chunk][chunkOffset], store->payloads[chunk][chunkOffset], store->offsets[chunk][chunkOffset]};
 }
 
-bool isKeywordType(const Token* token)
+//------------------------------------------------------------------------------
+//! Same as getToken(), but in the streaming mode tokenizes the buffer until 
+//! token number index is produced or the tokens run out.
+//------------------------------------------------------------------------------
+Token fetchToken(Tokenizer* tokenizer, size_t index)
 {
-    assert(token);
+    assert(tokenizer);
 
-    return token->type == KEYWORD_TOKEN_TYPE;
+    while (index >= tokensCount(tokenizer) && tokenizeNext(tokenizer)) {}
+
+    return getToken(tokenizer, index);
 }
 
-bool isNumberType(const Token* token)
+bool hasToken(Tokenizer* tokenizer, size_t index)
 {
-    assert(token);
+    assert(tokenizer);
+
+    while (index >= tokensCount(tokenizer) && tokenizeNext(tokenizer)) {}
 
-    return token->type == NUMBER_TOKEN_TYPE;
+    return index < tokensCount(tokenizer);
 }
 
-bool isIdType(const Token* token)
+void releaseTokens(Tokenizer* tokenizer, size_t index)
 {
-    assert(token);
+    assert(tokenizer);
 
-    return token->type == ID_TOKEN_TYPE;
+    if (tokenizer->streaming) { releaseTokens(&tokenizer->ring, index); }
 }
 
-bool isQuotedString(const Token* token, const char* quotedString)
+TokenType tokenType(Token token)
 {
-    assert(token);
+    switch (token.kind)
+    {
+        case TOKEN_KIND_QUOTED_STRING: { return QUOTED_STRING_TOKEN_TYPE; }
+        case TOKEN_KIND_NUMBER:        { return NUMBER_TOKEN_TYPE;        }
+        case TOKEN_KIND_ID:            { return ID_TOKEN_TYPE;            }
+        case TOKEN_KIND_END:           { return END_TOKEN_TYPE;           }
+        default:                       { return KEYWORD_TOKEN_TYPE;       }
+    }
+}
 
-    return isQuotedStringType(token) && 
-           strcmp(token->data.quotedString, quotedString) == 0;
+KeywordCode tokenKeyword(Token token)
+{
+    return isKeywordType(token) ? (KeywordCode) token.kind : INVALID_KEYWORD;
 }
 
-bool isKeyword(const Token* token, KeywordCode keywordCode)
+//------------------------------------------------------------------------------
+//! @return Data of a quoted string, number or id token.
+//------------------------------------------------------------------------------
+TokenData tokenData(const Tokenizer* tokenizer, Token token)
 {
-    assert(token);
+    assert(tokenizer);
+    assert(hasData(token.kind));
 
-    return isKeywordType(token) && token->data.keywordCode == keywordCode;
+    if (tokenizer->streaming)
+    {
+        const TokenRing* ring = &tokenizer->ring;
+        assert(token.payload >= ring->dataBegin && token.payload < ring->dataEnd);
+
+        return ring->data[token.payload & (ring->dataCapacity - 1)];
+    }
+
+    size_t chunk = tokenChunk(token.payload);
+    return tokenizer->tokens.data[chunk][tokenChunkOffset(token.payload, chunk)];
 }
 
-bool isNumber(const Token* token, int64_t number)
+const char* tokenPos(const Tokenizer* tokenizer, Token token)
 {
-    assert(token);
+    assert(tokenizer);
 
-    return isNumberType(token) && token->data.number == number;
+    return tokenizer->buffer + token.offset;
 }
 
-bool isId(const Token* token, const char* id)
+//------------------------------------------------------------------------------
+//! Line numbers aren't tracked while tokenizing. Instead, the first time one 
+//! is needed, beginnings of all the lines are found, and then lines are 
+//! looked up with binary search.
+//!
+//! @return Number of the line (starting from 0) the token is located at.
+//------------------------------------------------------------------------------
+size_t tokenLine(Tokenizer* tokenizer, Token token)
 {
-    assert(token);
+    ASSERT_TOKENIZER(tokenizer);
+
+    if (tokenizer->lineStarts == nullptr)
+    {
+        const char* buffer    = tokenizer->buffer;
+        const char* bufferEnd = tokenizer->buffer + tokenizer->bufferSize;
+        size_t      capacity  = 1;
+
+        for (const char* newLine = findEither(buffer, bufferEnd, '\n', '\n'); 
+             newLine < bufferEnd; 
+             newLine = findEither(newLine + 1, bufferEnd, '\n', '\n'))
+        {
+            capacity++;
+        }
+
+        tokenizer->lineStarts = (uint32_t*) calloc(capacity, sizeof(uint32_t));
+        assert(tokenizer->lineStarts);
+
+        tokenizer->lineStarts[tokenizer->linesCount++] = 0;
+
+        for (const char* newLine = findEither(buffer, bufferEnd, '\n', '\n'); 
+             newLine < bufferEnd; 
+             newLine = findEither(newLine + 1, bufferEnd, '\n', '\n'))
+        {
+            tokenizer->lineStarts[tokenizer->linesCount++] = (uint32_t) (newLine + 1 - buffer);
+        }
+    }
+
+    /* The last line starting at or before the token. */
+    size_t left  = 0;
+    size_t right = tokenizer->linesCount;
+
+    while (right - left > 1)
+    {
+        size_t middle = (left + right) / 2;
+
+        if (tokenizer->lineStarts[middle] <= token.offset) { left  = middle; }
+        else                                               { right = middle; }
+    }
 
-    return isIdType(token) && strcmp(token->data.id, id) == 0;
+    return left;
 }
 
-bool isComparand(const Token* token)
+bool isQuotedStringType(Token token)
 {
-    assert(token);
+    return token.kind == TOKEN_KIND_QUOTED_STRING;
+}
+
+bool isKeywordType(Token token)
+{
+    return token.kind < KEYWORDS_COUNT;
+}
+
+bool isNumberType(Token token)
+{
+    return token.kind == TOKEN_KIND_NUMBER;
+}
+
+bool isIdType(Token token)
+{
+    return token.kind == TOKEN_KIND_ID;
+}
+
+bool isQuotedString(const Tokenizer* tokenizer, Token token, const char* quotedString)
+{
+    assert(tokenizer);
+
+    return isQuotedStringType(token) && 
+           strcmp(tokenData(tokenizer, token).quotedString, quotedString) == 0;
+}
+
+bool isKeyword(Token token, KeywordCode keywordCode)
+{
+    return token.kind == keywordCode;
+}
+
+bool isNumber(const Tokenizer* tokenizer, Token token, int64_t number)
+{
+    assert(tokenizer);
 
-    return isKeywordType(token) && 
-           token->data.keywordCode >= EQUAL_KEYWORD && 
-           token->data.keywordCode <= GREATER_KEYWORD;
+    return isNumberType(token) && tokenData(tokenizer, token).number == number;
 }
 
-bool isTerm(const Token* token)
+bool isId(const Tokenizer* tokenizer, Token token, const char* id)
 {
-    assert(token);
+    assert(tokenizer);
+
+    return isIdType(token) && tokenData(tokenizer, token).id == id;
+}
 
-    return isKeywordType(token) && 
-           token->data.keywordCode >= PLUS_KEYWORD && 
-           token->data.keywordCode <= MINUS_KEYWORD;
+bool isComparand(Token token)
+{
+    return token.kind >= EQUAL_KEYWORD && token.kind <= GREATER_KEYWORD;
 }
 
-bool isFactor(const Token* token)
+bool isTerm(Token token)
 {
-    assert(token);
+    return token.kind >= PLUS_KEYWORD && token.kind <= MINUS_KEYWORD;
+}
+
+bool isFactor(Token token)
+{
+    return token.kind >= MUL_KEYWORD && token.kind <= DIV_KEYWORD;
+}
+
+//------------------------------------------------------------------------------
+//! Tokenizes the next lexeme (which results in up to 3 tokens).
+//!
+//! @param tokenizer
+//!
+//! @return Whether new tokens have been produced.
+//------------------------------------------------------------------------------
+bool tokenizeNext(Tokenizer* tokenizer)
+{
+    ASSERT_TOKENIZER(tokenizer);
 
-    return isKeywordType(token) && 
-           token->data.keywordCode >= MUL_KEYWORD && 
-           token->data.keywordCode <= DIV_KEYWORD;
+    if (tokenizer->exhausted) { return false; }
+
+    if (finished(tokenizer) || 
+        (!processQuotedString(tokenizer) && !processLexeme(tokenizer)))
+    {
+        tokenizer->exhausted = true;
+        setEndToken(tokenizer);
+
+        return false;
+    }
+
+    return true;
 }
 
 void tokenizeBuffer(Tokenizer* tokenizer)
 {
     ASSERT_TOKENIZER(tokenizer);
 
-    skipSpaces(tokenizer);
+    while (tokenizeNext(tokenizer)) {}
+}
+
+//------------------------------------------------------------------------------
+//! Part of the buffer tokenized by a separate thread. Its tokenizer's buffer 
+//! is the chunk itself, so tokens' offsets are relative to the chunk.
+//------------------------------------------------------------------------------
+struct TokenizingJob
+{
+    Tokenizer   tokenizer;
+    size_t      chunkOffset;
+    pthread_t   thread;
+    bool        threadStarted;
+};
 
-    while (!finished(tokenizer))
+static void* tokenizeJob(void* job)
+{
+    assert(job);
+
+    tokenizeBuffer(&((TokenizingJob*) job)->tokenizer);
+
+    return nullptr;
+}
+
+//------------------------------------------------------------------------------
+//! Interns the ids and quoted strings of a chunk's tokens, which point into 
+//! the buffer until then.
+//------------------------------------------------------------------------------
+static void internTokens(Tokenizer* chunk)
+{
+    ASSERT_TOKENIZER(chunk);
+    assert(chunk->deferInterning);
+
+    TokenStore* store     = &chunk->tokens;
+    const char* bufferEnd = chunk->buffer + chunk->bufferSize;
+
+    for (size_t index = 0; index < store->count;)
     {
-        if (!processQuotedString(tokenizer) && 
-            !processNumeric(tokenizer) && 
-            !processKeyword(tokenizer) && 
-            !processId(tokenizer))
+        size_t tokenChunkIndex = tokenChunk(index);
+        size_t chunkOffset     = tokenChunkOffset(index, tokenChunkIndex);
+        size_t length          = tokenRunLength(index, index, store->count - index);
+
+        for (size_t i = 0; i < length; i++)
         {
-            break;
+            uint8_t kind = store->kinds[tokenChunkIndex][chunkOffset + i];
+            if (kind != TOKEN_KIND_ID && kind != TOKEN_KIND_QUOTED_STRING) { continue; }
+
+            size_t      payload   = store->payloads[tokenChunkIndex][chunkOffset + i];
+            size_t      dataChunk = tokenChunk(payload);
+            TokenData*  data      = &store->data[dataChunk][tokenChunkOffset(payload, dataChunk)];
+
+            if (kind == TOKEN_KIND_ID)
+            {
+                data->id = intern(data->id, spanIdSymbols(data->id, bufferEnd));
+            }
+            else if (data->quotedString != nullptr)
+            {
+                const char* end    = findEither(data->quotedString, bufferEnd, '\"', '\n');
+                data->quotedString = intern(data->quotedString, (size_t) (end - data->quotedString));
+            }
         }
+
+        index += length;
     }
+
+    chunk->deferInterning = false;
+}
+
+//------------------------------------------------------------------------------
+//! Tokenizes the whole buffer using up to threadsCount threads. The buffer is 
+//! split into chunks ending with new lines, and as no lexeme spans a new line
+//! (it's a keyword of its own, while quoted strings and comments end at it),
+//! and nothing is carried over from one lexeme to the next, concatenating the
+//! chunks' tokens gives exactly the same tokens as tokenizeBuffer(). If some 
+//! chunk stops at an unknown lexeme, the following ones are dropped, just as 
+//! tokenizeBuffer() would stop there.
+//!
+//! The intern pool isn't thread-safe, so ids and quoted strings are interned 
+//! while concatenating.
+//! Buffers too small to be split are tokenized in the current thread.
+//------------------------------------------------------------------------------
+void tokenizeParallel(Tokenizer* tokenizer, size_t threadsCount)
+{
+    ASSERT_TOKENIZER(tokenizer);
+    assert(!tokenizer->streaming);
+    assert(tokensCount(tokenizer) == 0);
+
+    const char* bufferEnd   = tokenizer->buffer + tokenizer->bufferSize;
+    size_t      restSize    = finished(tokenizer) ? 0 : (size_t) (bufferEnd - tokenizer->position);
+    size_t      chunksCount = restSize / PARALLEL_TOKENIZING_MIN_CHUNK_SIZE;
+
+    if (chunksCount > threadsCount)                    { chunksCount = threadsCount; }
+    if (chunksCount > PARALLEL_TOKENIZING_MAX_THREADS) { chunksCount = PARALLEL_TOKENIZING_MAX_THREADS; }
+
+    if (chunksCount <= 1)
+    {
+        tokenizeBuffer(tokenizer);
+        return;
+    }
+
+    TokenizingJob jobs[PARALLEL_TOKENIZING_MAX_THREADS] = {};
+    size_t        jobsCount  = 0;
+    const char*   chunkStart = tokenizer->position;
+
+    for (size_t chunk = 0; chunk < chunksCount && chunkStart < bufferEnd; chunk++)
+    {
+        const char* chunkEnd = bufferEnd;
+
+        if (chunk + 1 < chunksCount)
+        {
+            const char* split = tokenizer->position + restSize * (chunk + 1) / chunksCount;
+            if (split < chunkStart) { split = chunkStart; }
+
+            chunkEnd = findEither(split, bufferEnd, '\n', '\n');
+            if (chunkEnd < bufferEnd) { chunkEnd++; }
+        }
+
+        TokenizingJob* job = &jobs[jobsCount++];
+
+        construct(&job->tokenizer, chunkStart, (size_t) (chunkEnd - chunkStart), tokenizer->useNumericNumbers, false);
+        job->tokenizer.deferInterning = true;
+        job->chunkOffset              = (size_t) (chunkStart - tokenizer->buffer);
+
+        job->threadStarted = pthread_create(&job->thread, nullptr, tokenizeJob, job) == 0;
+        if (!job->threadStarted) { tokenizeJob(job); }
+
+        chunkStart = chunkEnd;
+    }
+
+    bool stopped = false;
+
+    for (size_t i = 0; i < jobsCount; i++)
+    {
+        TokenizingJob* job = &jobs[i];
+        if (job->threadStarted) { pthread_join(job->thread, nullptr); }
+
+        if (!stopped)
+        {
+            internTokens(&job->tokenizer);
+            appendTokens(&tokenizer->tokens, &job->tokenizer.tokens, (uint32_t) job->chunkOffset);
+
+            tokenizer->position = tokenizer->buffer + job->chunkOffset + 
+                                  (job->tokenizer.position - job->tokenizer.buffer);
+            stopped = !finished(&job->tokenizer);
+        }
+
+        destroy(&job->tokenizer);
+    }
+
+    tokenizer->exhausted = true;
+    setEndToken(tokenizer);
+}
+
+void setEndToken(Tokenizer* tokenizer)
+{
+    ASSERT_TOKENIZER(tokenizer);
+
+    /* Reading past the last token yields an empty token pointing at the last
+     * one's position, so that errors at the end of the file can be shown. The
+     * last token can't have been released yet, as it's never been read. */
+    size_t count = tokensCount(tokenizer);
+    tokenizer->endToken = {TOKEN_KIND_END, 0, count > 0 ? getToken(tokenizer, count - 1).offset : 0};
 }
 
 bool finished(Tokenizer* tokenizer)
 {
     ASSERT_TOKENIZER(tokenizer);
 
-    return tokenizer->position > tokenizer->buffer + tokenizer->bufferSize;
+    return tokenizer->position >= tokenizer->buffer + tokenizer->bufferSize;
 }
 
 void skipSpaces(Tokenizer* tokenizer)
 {
     ASSERT_TOKENIZER(tokenizer);
 
-    tokenizer->position += strspn(tokenizer->position, " \t");
+    tokenizer->position += spanSpaces(tokenizer->position, tokenizer->buffer + tokenizer->bufferSize);
 }
 
 void proceed(Tokenizer* tokenizer, size_t step)
@@ -181,11 +837,19 @@ void proceed(Tokenizer* tokenizer, size_t step)
     skipSpaces(tokenizer);
 }
 
-void addToken(Tokenizer* tokenizer, Token token)
+void addToken(Tokenizer* tokenizer, uint8_t kind, TokenData data)
 {
     ASSERT_TOKENIZER(tokenizer);
 
-    tokenizer->tokens[tokenizer->tokensCount++] = token;
+    uint32_t offset = (uint32_t) (tokenizer->position - tokenizer->buffer);
+
+    if (tokenizer->streaming)
+    {
+        pushToken(&tokenizer->ring, kind, data, offset);
+        return;
+    }
+
+    pushToken(&tokenizer->tokens, kind, data, offset);
 }
 
 bool processQuotedString(Tokenizer* tokenizer)
@@ -194,105 +858,141 @@ bool processQuotedString(Tokenizer* tokenizer)
 
     if (*(tokenizer->position) != '\"') { return false; }
 
-    addToken(tokenizer, {KEYWORD_TOKEN_TYPE, 
-                         {.keywordCode = STR_QUOTE_KEYWORD}, 
-                         tokenizer->currentLine, 
-                         tokenizer->position});
+    addToken(tokenizer, STR_QUOTE_KEYWORD, {});
     tokenizer->position++;
 
-    const char* quote   = strchr(tokenizer->position, '\"');
-    const char* newLine = strchr(tokenizer->position, '\n');
-
-    const char* end = quote < newLine ? quote : newLine;
-    size_t length = end - tokenizer->position;
+    const char* bufferEnd = tokenizer->buffer + tokenizer->bufferSize;
+    const char* end       = findEither(tokenizer->position, bufferEnd, '\"', '\n');
+    size_t      length    = end - tokenizer->position;
 
     if (length == 0) 
     {
-        addToken(tokenizer, {QUOTED_STRING_TOKEN_TYPE, 
-                             {.quotedString = nullptr}, 
-                             tokenizer->currentLine, 
-                             tokenizer->position});
+        addToken(tokenizer, TOKEN_KIND_QUOTED_STRING, {.quotedString = nullptr});
     }
     else 
     {
-        addToken(tokenizer, {QUOTED_STRING_TOKEN_TYPE, 
-                             {.quotedString = copyString(tokenizer->position, length)}, 
-                             tokenizer->currentLine, 
-                             tokenizer->position});
+        /* A deferred string's length is found again by internTokens(). */
+        const char* quotedString = tokenizer->deferInterning ? tokenizer->position : 
+                                                               intern(tokenizer->position, length);
+
+        addToken(tokenizer, TOKEN_KIND_QUOTED_STRING, {.quotedString = quotedString});
     }
 
     proceed(tokenizer, length);
 
-    if (end == quote)
+    if (end < bufferEnd && *end == '\"')
     {
-        addToken(tokenizer, {KEYWORD_TOKEN_TYPE, 
-                             {.keywordCode = STR_QUOTE_KEYWORD}, 
-                             tokenizer->currentLine, 
-                             tokenizer->position});
-        
+        addToken(tokenizer, STR_QUOTE_KEYWORD, {});
+
         proceed(tokenizer, 1);
     }
 
     return true;
 }
 
-bool processKeyword(Tokenizer* tokenizer)
+//------------------------------------------------------------------------------
+//! Classifies the lexeme at the current position as a number (only if numbers
+//! are allowed), a keyword or an identifier, in this order of priority. The
+//! keyword trie is advanced until it reaches the dead node, so that the longest
+//! keyword is chosen (e.g. 'accio-bombarda' over 'accio'). Only if there is no
+//! keyword, the identifier's end is searched for by the char scanner.
+//!
+//! @param tokenizer
+//!
+//! @return Lexeme's type, length and keyword code (if it is a keyword).
+//------------------------------------------------------------------------------
+Lexeme scanLexeme(const Tokenizer* tokenizer)
 {
     ASSERT_TOKENIZER(tokenizer);
 
-    for (size_t i = 0; i < KEYWORDS_COUNT; i++)
+    const KeywordTrie& trie  = KEYWORD_TRIE;
+    const char*        start = tokenizer->position;
+    const char*        end   = tokenizer->buffer + tokenizer->bufferSize;
+
+    if (tokenizer->useNumericNumbers)
     {
-        Keyword keyword = KEYWORDS[i];
+        const char* digits = start;
+        if (digits < end && (trie.charFlags[(uint8_t) *digits] & CHAR_FLAG_SIGN)) { digits++; }
 
-        if (tokenizer->position + keyword.length > tokenizer->buffer + tokenizer->bufferSize)
+        const char* numberEnd = digits;
+        while (numberEnd < end && (trie.charFlags[(uint8_t) *numberEnd] & CHAR_FLAG_DIGIT))
         {
-            continue;
+            numberEnd++;
         }
 
-        if (strncmp(tokenizer->position, keyword.string, keyword.length) == 0)
+        if (numberEnd != digits) { return {LEXEME_NUMBER, (size_t) (numberEnd - start), INVALID_KEYWORD}; }
+    }
+
+    Lexeme   lexeme = {LEXEME_NONE, 0, INVALID_KEYWORD};
+    uint16_t node   = KEYWORD_TRIE_ROOT;
+
+    for (const char* cur = start; cur < end && node != KEYWORD_TRIE_DEAD; cur++)
+    {
+        node = trie.next[node][trie.charClass[(uint8_t) *cur]];
+        if (trie.accept[node] != INVALID_KEYWORD)
         {
-            if (isKeywordNumber(keyword))
-            {
-                addToken(tokenizer, {NUMBER_TOKEN_TYPE, {.number = keywordToNumber(keyword)}, tokenizer->currentLine, tokenizer->position});
-            }
-            else if (keyword.code == COMMENT_KEYWORD)
-            {
-                const char* newLine = strchr(tokenizer->position, '\n');
+            lexeme = {LEXEME_KEYWORD, (size_t) (cur - start + 1), trie.accept[node]};
+        }
+    }
 
-                addToken(tokenizer, {KEYWORD_TOKEN_TYPE, {.keywordCode = NEW_LINE_KEYWORD}, tokenizer->currentLine, tokenizer->position});
-                    
-                if (newLine != nullptr)
-                {
-                    proceed(tokenizer, newLine - tokenizer->position + 1);
-                } 
-                else
-                {
-                    proceed(tokenizer, tokenizer->bufferSize);
-                }
+    if (lexeme.type != LEXEME_NONE) { return lexeme; }
 
-                tokenizer->currentLine++;
+    size_t idLength = spanIdSymbols(start, end);
+    if (idLength > 0)
+    {
+        lexeme = {LEXEME_ID, idLength, INVALID_KEYWORD};
+    }
 
-                return true;
-            }
-            else
-            {
-                addToken(tokenizer, {KEYWORD_TOKEN_TYPE, {.keywordCode = keyword.code}, tokenizer->currentLine, tokenizer->position});
-            }
+    return lexeme;
+}
 
-            if (*(tokenizer->position) == '\n')
-            {
-                tokenizer->currentLine++;
-            }
+bool processLexeme(Tokenizer* tokenizer)
+{
+    ASSERT_TOKENIZER(tokenizer);
 
-            proceed(tokenizer, keyword.length);
+    Lexeme lexeme = scanLexeme(tokenizer);
 
-            return true;
-        }
+    switch (lexeme.type)
+    {
+        case LEXEME_NUMBER:  { processNumeric (tokenizer, lexeme.length);               return true;  }
+        case LEXEME_KEYWORD: { processKeyword (tokenizer, KEYWORDS[lexeme.keywordCode]); return true;  }
+        case LEXEME_ID:      { processId      (tokenizer, lexeme.length);               return true;  }
+        default:             {                                                          return false; }
     }
 
     return false;
 }
 
+void processKeyword(Tokenizer* tokenizer, Keyword keyword)
+{
+    ASSERT_TOKENIZER(tokenizer);
+
+    if (isKeywordNumber(keyword))
+    {
+        addToken(tokenizer, TOKEN_KIND_NUMBER, {.number = keywordToNumber(keyword)});
+    }
+    else if (keyword.code == COMMENT_KEYWORD)
+    {
+        const char* newLine = findEither(tokenizer->position, 
+                                         tokenizer->buffer + tokenizer->bufferSize, 
+                                         '\n', 
+                                         '\n');
+
+        addToken(tokenizer, NEW_LINE_KEYWORD, {});
+
+        /* If there's no new line, this steps past the buffer's end. */
+        proceed(tokenizer, newLine - tokenizer->position + 1);
+
+        return;
+    }
+    else
+    {
+        addToken(tokenizer, (uint8_t) keyword.code, {});
+    }
+
+    proceed(tokenizer, keyword.length);
+}
+
 bool isKeywordNumber(Keyword keyword)
 {
     return keyword.code >= ZERO_KEYWORD && keyword.code <= SIX_KEYWORD;  
@@ -310,71 +1010,105 @@ int64_t keywordToNumber(Keyword keyword)
     }
 }
 
-bool processNumeric(Tokenizer* tokenizer)
+void processNumeric(Tokenizer* tokenizer, size_t length)
 {
     ASSERT_TOKENIZER(tokenizer);
 
-    if (!(tokenizer->useNumericNumbers)) { return false; }
+    /* The buffer isn't NUL-terminated, so strtoll can't be used. Out of range 
+     * values are clamped the same way it does. */
+    const char* cur      = tokenizer->position;
+    const char* end      = tokenizer->position + length;
+    bool        negative = *cur == '-';
 
-    char*   numberEnd = nullptr;
-    int64_t value     = strtoll(tokenizer->position, &numberEnd, 10);
+    if (*cur == '-' || *cur == '+') { cur++; }
 
-    if (numberEnd == tokenizer->position) { return false; }
+    uint64_t limit    = negative ? (uint64_t) INT64_MAX + 1 : (uint64_t) INT64_MAX;
+    uint64_t absValue = 0;
 
-    addToken(tokenizer, {NUMBER_TOKEN_TYPE, {.number = value}, tokenizer->currentLine, tokenizer->position});
-    proceed(tokenizer, numberEnd - tokenizer->position);
+    for (; cur < end; cur++)
+    {
+        uint64_t digit = (uint64_t) (*cur - '0');
 
-    return true;
+        if (absValue > (limit - digit) / 10)
+        {
+            absValue = limit;
+            break;
+        }
+
+        absValue = 10 * absValue + digit;
+    }
+
+    int64_t value = negative ? (int64_t) (0 - absValue) : (int64_t) absValue;
+
+    addToken(tokenizer, TOKEN_KIND_NUMBER, {.number = value});
+    proceed(tokenizer, length);
 }
 
-bool processId(Tokenizer* tokenizer)
+void processId(Tokenizer* tokenizer, size_t length)
 {
     ASSERT_TOKENIZER(tokenizer);
 
-    size_t length = strspn(tokenizer->position, ID_VALID_SYMBOLS); 
-
-    if (tokenizer->position + length > tokenizer->buffer + tokenizer->bufferSize || length == 0)
+    /* A deferred id's length is found again by spanIdSymbols() in internTokens(). */
+    if (tokenizer->deferInterning)
     {
-        return false;
+        addToken(tokenizer, TOKEN_KIND_ID, {.id = tokenizer->position});
+    }
+    else
+    {
+        addToken(tokenizer, TOKEN_KIND_ID, {.id = intern(tokenizer->position, length)});
     }
 
-    addToken(tokenizer, {ID_TOKEN_TYPE, {.id = copyString(tokenizer->position, length)}, tokenizer->currentLine, tokenizer->position});
     proceed(tokenizer, length);
+}
 
-    return true;
+//------------------------------------------------------------------------------
+//! @return Symbol at ptr or '\0' if ptr is outside of the buffer.
+//------------------------------------------------------------------------------
+static inline char bufferChar(const Tokenizer* tokenizer, const char* ptr)
+{
+    if (ptr < tokenizer->buffer || ptr >= tokenizer->buffer + tokenizer->bufferSize) { return '\0'; }
+
+    return *ptr;
 }
 
-void printTokenLinePos(const Tokenizer* tokenizer, const Token* token, FILE* file, const char* offsetString)
+void printTokenLinePos(Tokenizer* tokenizer, Token token, FILE* file, const char* offsetString)
 {
     ASSERT_TOKENIZER(tokenizer);
-    assert(token);
     assert(file);
 
-    const char* lineStart  = token->pos;
-    const char* lineEnd    = token->pos;
+    const char* pos        = tokenPos(tokenizer, token);
+    size_t      line       = tokenLine(tokenizer, token);
+
+    const char* lineStart  = pos;
+    const char* lineEnd    = pos;
 
     const char* buffer     = tokenizer->buffer;
     size_t      bufferSize = tokenizer->bufferSize;
 
-    if (*lineStart == '\n') { lineStart--; }
-    while (lineStart > buffer && *(lineStart - 1) != '\n' && *lineStart != '\n')
+    if (bufferChar(tokenizer, lineStart) == '\n') { lineStart--; }
+    while (lineStart > buffer && *(lineStart - 1) != '\n' && bufferChar(tokenizer, lineStart) != '\n')
     {
         lineStart--;
     }
 
-    if (*lineEnd == '\n') { lineEnd--; }
-    while (lineEnd < buffer + bufferSize && *(lineEnd + 1) != '\n' && *lineEnd != '\n')
+    if (bufferChar(tokenizer, lineEnd) == '\n') { lineEnd--; }
+    while (lineEnd < buffer + bufferSize && 
+           bufferChar(tokenizer, lineEnd + 1) != '\n' && 
+           bufferChar(tokenizer, lineEnd) != '\n')
     {
         lineEnd++;
     }
 
-    int lineOffset = digitsCount(token->line + 1) + 1;
+    if (lineStart < buffer)               { lineStart = buffer; }
+    if (lineEnd >= buffer + bufferSize)   { lineEnd   = buffer + bufferSize - 1; }
+
+    int lineOffset = digitsCount(line + 1) + 1;
     
     if (offsetString != nullptr) { fprintf(file, offsetString); }
-    fprintf(file, "%zu|%.*s\n", token->line + 1, (int) (lineEnd - lineStart + 1), lineStart);
+    fprintf(file, "%zu|%.*s\n", line + 1, (int) (lineEnd - lineStart + 1), lineStart);
 
     if (offsetString != nullptr) { fprintf(file, offsetString); }
-    for (size_t i = 0; i + lineStart < token->pos + lineOffset; i++)
+    for (size_t i = 0; i + lineStart < pos + lineOffset; i++)
     {
         fputc(' ', file);
     }
@@ -382,45 +1116,50 @@ void printTokenLinePos(const Tokenizer* tokenizer, const Token* token, FILE* fil
     fprintf(file, "^\n");
 }
 
-void dumpTokens(const Tokenizer* tokenizer, FILE* file)
+void dumpTokens(Tokenizer* tokenizer, FILE* file)
 {
     ASSERT_TOKENIZER(tokenizer);
     assert(file);
+    assert(!tokenizer->streaming);
 
-    const Token* tokens = tokenizer->tokens;
-    size_t       count  = tokenizer->tokensCount;
+    size_t count = tokensCount(tokenizer);
 
     for (size_t i = 0; i < count; i++)
     {
+        Token     token = getToken(tokenizer, i);
+        TokenType type  = tokenType(token);
+
         fprintf(file, "Token %zu:\n"
                       "\ttype = %s[%d]\n"
                       "\tdata = ", 
                       i,
-                      tokenTypeToString(tokens[i].type),
-                      tokens[i].type);
+                      tokenTypeToString(type),
+                      type);
 
-        switch (tokens[i].type)
+        switch (type)
         {
             case QUOTED_STRING_TOKEN_TYPE:
             {
-                fprintf(file, "(quotedString) \"%s\"\n", tokens[i].data.id);
+                fprintf(file, "(quotedString) \"%s\"\n", tokenData(tokenizer, token).quotedString);
                 break;
             }
 
             case KEYWORD_TOKEN_TYPE: 
             { 
-                if (tokens[i].data.keywordCode == NEW_LINE_KEYWORD)
+                KeywordCode keywordCode = tokenKeyword(token);
+
+                if (keywordCode == NEW_LINE_KEYWORD)
                 {
                     fprintf(file, "(keywordCode) %s[%d] \\n\n", 
-                                  keywordCodeToString(tokens[i].data.keywordCode),
-                                  tokens[i].data.keywordCode); 
+                                  keywordCodeToString(keywordCode),
+                                  keywordCode); 
                 }
                 else 
                 {
                     fprintf(file, "(keywordCode) %s[%d] %s\n", 
-                                  keywordCodeToString(tokens[i].data.keywordCode),
-                                  tokens[i].data.keywordCode, 
-                                  KEYWORDS[tokens[i].data.keywordCode].string); 
+                                  keywordCodeToString(keywordCode),
+                                  keywordCode, 
+                                  KEYWORDS[keywordCode].string); 
                 }
 
                 break; 
@@ -428,18 +1167,23 @@ void dumpTokens(const Tokenizer* tokenizer, FILE* file)
 
             case NUMBER_TOKEN_TYPE: 
             { 
-                fprintf(file, "(number) %" PRId64 "\n", tokens[i].data.number);
+                fprintf(file, "(number) %" PRId64 "\n", tokenData(tokenizer, token).number);
                 break; 
             }
 
             case ID_TOKEN_TYPE: 
             { 
-                fprintf(file, "(id) %s\n", tokens[i].data.id);
+                fprintf(file, "(id) %s\n", tokenData(tokenizer, token).id);
                 break; 
             }
+
+            default:
+            {
+                break;
+            }
         }
 
-        printTokenLinePos(tokenizer, tokens + i, file, "\t");
+        printTokenLinePos(tokenizer, token, file, "\t");
         
         if (i + 1 == count) { fputc('\n', file); }
     }
@@ -453,6 +1197,7 @@ const char* tokenTypeToString(TokenType type)
         case KEYWORD_TOKEN_TYPE:       { return TO_STR(KEYWORD_TOKEN_TYPE);       }
         case NUMBER_TOKEN_TYPE:        { return TO_STR(NUMBER_TOKEN_TYPE);        }
         case ID_TOKEN_TYPE:            { return TO_STR(ID_TOKEN_TYPE);            }
+        case END_TOKEN_TYPE:           { return TO_STR(END_TOKEN_TYPE);           }
     }
 
     return nullptr;
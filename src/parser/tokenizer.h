@@ -2,13 +2,13 @@
 #define TOKENIZER_H
 
 #include "syntax.h"
+#include "../symbol_table/intern_pool.h"
 
 union TokenData
 {
-    char*       quotedString;
-    KeywordCode keywordCode;
+    const char* quotedString; /* interned */
     int64_t     number;
-    char*       id;
+    const char* id;           /* interned */
 };
 
 enum TokenType
@@ -16,17 +16,80 @@ enum TokenType
     QUOTED_STRING_TOKEN_TYPE,
     KEYWORD_TOKEN_TYPE,
     NUMBER_TOKEN_TYPE,
-    ID_TOKEN_TYPE
+    ID_TOKEN_TYPE,
+    END_TOKEN_TYPE
 };
 
+/* Token's kind is its KeywordCode for keywords and one of these otherwise. */
+static const uint8_t TOKEN_KIND_QUOTED_STRING = 0xFC;
+static const uint8_t TOKEN_KIND_NUMBER        = 0xFD;
+static const uint8_t TOKEN_KIND_ID            = 0xFE;
+static const uint8_t TOKEN_KIND_END           = 0xFF;
+
+static_assert(KEYWORDS_COUNT <= TOKEN_KIND_QUOTED_STRING, "Keyword codes have to fit in token kinds");
+
+//------------------------------------------------------------------------------
+//! Tokens are stored as parallel arrays of these fields, so that checking 
+//! tokens' kinds only touches one byte per token. Only quoted strings, numbers 
+//! and ids have data, which is stored separately and is referred to by payload.
+//------------------------------------------------------------------------------
 struct Token
 {
-    TokenType   type;
-    TokenData   data;
-    size_t      line;
-    const char* pos;
+    uint8_t     kind;
+    uint32_t    payload; /* index of the token's data */
+    uint32_t    offset;  /* from the beginning of the buffer */
+};
+
+/* Tokens' offsets and payloads are 32-bit, so bigger sources are rejected 
+ * before tokenizing. Every token with data takes at least a byte of the 
+ * source, so the payloads stay below UINT32_MAX as well. */
+static const size_t TOKENIZER_MAX_BUFFER_SIZE  = UINT32_MAX - 1;
+
+/* The first chunk holds 2^TOKEN_CHUNK_FIRST_SIZE_LOG tokens, each next one is 
+ * twice as big as the previous, so tokens never move once added. Tokens' data 
+ * is stored in chunks of the same sizes. */
+static const size_t TOKEN_CHUNK_FIRST_SIZE_LOG = 8;
+static const size_t TOKEN_CHUNK_FIRST_SIZE     = (size_t) 1 << TOKEN_CHUNK_FIRST_SIZE_LOG;
+static const size_t TOKEN_CHUNKS_MAX_COUNT     = 40;
+
+struct TokenStore
+{
+    uint8_t*    kinds    [TOKEN_CHUNKS_MAX_COUNT];
+    uint32_t*   payloads [TOKEN_CHUNKS_MAX_COUNT];
+    uint32_t*   offsets  [TOKEN_CHUNKS_MAX_COUNT];
+    size_t      chunksCount;
+    size_t      count;
+
+    TokenData*  data     [TOKEN_CHUNKS_MAX_COUNT];
+    size_t      dataChunksCount;
+    size_t      dataCount;
 };
 
+/* In the streaming mode only the tokens which may still be needed are kept 
+ * in a ring buffer. Normally, these are only TOKEN_RING_INITIAL_CAPACITY last 
+ * ones, but the ring grows if its reader holds on to older tokens. Tokens' 
+ * data is kept in a ring of its own. */
+static const size_t TOKEN_RING_INITIAL_CAPACITY = 16;
+
+struct TokenRing
+{
+    uint8_t*    kinds;
+    uint32_t*   payloads;
+    uint32_t*   offsets;
+    size_t      capacity; /* power of 2 */
+    size_t      begin;    /* index of the oldest token kept */
+    size_t      end;      /* index following the newest token */
+
+    TokenData*  data;
+    size_t      dataCapacity;
+    size_t      dataBegin;
+    size_t      dataEnd;
+};
+
+/* Parallel tokenizing splits the buffer into chunks of at least this size. */
+static const size_t PARALLEL_TOKENIZING_MIN_CHUNK_SIZE = 256 * 1024;
+static const size_t PARALLEL_TOKENIZING_MAX_THREADS    = 64;
+
 struct Tokenizer
 {
     const char* buffer;
@@ -34,32 +97,63 @@ struct Tokenizer
     const char* position;
 
     bool        useNumericNumbers;
+    bool        streaming;
+    bool        exhausted;      /* no more tokens will be produced */
+    bool        deferInterning; /* ids and quoted strings point into the buffer until they're interned */
+
+    TokenStore  tokens;
+    TokenRing   ring;
+    Token       endToken; /* returned for indices past the last token */
 
-    Token*      tokens;
-    size_t      tokensCount;
-    size_t      currentLine;
+    /* Offsets of lines' beginnings, computed only when line numbers are needed. */
+    uint32_t*   lineStarts;
+    size_t      linesCount;
 };
 
-void construct          (Tokenizer* tokenizer, const char* buffer, size_t bufferSize, bool useNumericNumbers);
+void construct          (TokenStore* store);
+void destroy            (TokenStore* store);
+void pushToken          (TokenStore* store, uint8_t kind, TokenData data, uint32_t offset);
+void appendTokens       (TokenStore* store, const TokenStore* other, uint32_t offsetShift);
+
+void construct          (TokenRing* ring);
+void destroy            (TokenRing* ring);
+void pushToken          (TokenRing* ring, uint8_t kind, TokenData data, uint32_t offset);
+void releaseTokens      (TokenRing* ring, size_t index);
+
+void construct          (Tokenizer* tokenizer, const char* buffer, size_t bufferSize, bool useNumericNumbers, bool streaming);
 void destroy            (Tokenizer* tokenizer);
 
-bool isQuotedStringType (const Token* token);
-bool isKeywordType      (const Token* token);
-bool isNumberType       (const Token* token);
-bool isIdType           (const Token* token);
+size_t      tokensCount         (const Tokenizer* tokenizer);
+Token       getToken            (const Tokenizer* tokenizer, size_t index);
+Token       fetchToken          (Tokenizer* tokenizer, size_t index);
+bool        hasToken            (Tokenizer* tokenizer, size_t index);
+void        releaseTokens       (Tokenizer* tokenizer, size_t index);
+
+TokenType   tokenType           (Token token);
+KeywordCode tokenKeyword        (Token token);
+TokenData   tokenData           (const Tokenizer* tokenizer, Token token);
+const char* tokenPos            (const Tokenizer* tokenizer, Token token);
+size_t      tokenLine           (Tokenizer* tokenizer, Token token);
+
+bool isQuotedStringType (Token token);
+bool isKeywordType      (Token token);
+bool isNumberType       (Token token);
+bool isIdType           (Token token);
 
-bool isQuotedString     (const Token* token, const char* quotedString);
-bool isKeyword          (const Token* token, KeywordCode keywordCode);
-bool isNumber           (const Token* token, int64_t number);
-bool isId               (const Token* token, const char* id);
+bool isQuotedString     (const Tokenizer* tokenizer, Token token, const char* quotedString);
+bool isKeyword          (Token token, KeywordCode keywordCode);
+bool isNumber           (const Tokenizer* tokenizer, Token token, int64_t number);
+bool isId               (const Tokenizer* tokenizer, Token token, const char* id);
 
-bool isComparand        (const Token* token);
-bool isTerm             (const Token* token);
-bool isFactor           (const Token* token);
+bool isComparand        (Token token);
+bool isTerm             (Token token);
+bool isFactor           (Token token);
 
+bool tokenizeNext       (Tokenizer* tokenizer);
 void tokenizeBuffer     (Tokenizer* tokenizer);
-void printTokenLinePos  (const Tokenizer* tokenizer, const Token* token, FILE* file, const char* offsetString);  
-void dumpTokens         (const Tokenizer* tokenizer, FILE* file);
+void tokenizeParallel   (Tokenizer* tokenizer, size_t threadsCount);
+void printTokenLinePos  (Tokenizer* tokenizer, Token token, FILE* file, const char* offsetString);  
+void dumpTokens         (Tokenizer* tokenizer, FILE* file);
 
 const char* tokenTypeToString(TokenType type);
 
@@ -28,6 +28,7 @@ void destroyFunction(Function* function)
     assert(function);
 
     destroy(&function->varsData, nullptr);
+    destroy(&function->varsIndex);
     function->name        = nullptr;
     function->paramsCount = 0;
 }
@@ -39,34 +40,50 @@ void pushParameter(Function* function, const char* parameter)
     function->paramsCount++;
 }
 
-void pushVariable(Function* function, const char* variable)
+//------------------------------------------------------------------------------
+//! The variable mustn't be declared yet (see getVarSlot()).
+//!
+//! @return Slot of the variable.
+//------------------------------------------------------------------------------
+int pushVariable(Function* function, const char* variable)
 {
     assert(function);
     assert(variable);
     assert(function->varsData.vars);
 
-    insertVariable(&function->varsData, variable);
+    int varSlot = insertVariable(&function->varsData, variable);
+    indexName(&function->varsIndex, variable, varSlot);
+
+    return varSlot;
 }
 
-int getVarOffset(Function* function, const char* variable)
+//------------------------------------------------------------------------------
+//! @return Slot of the variable or NO_VAR_SLOT if it's not declared.
+//------------------------------------------------------------------------------
+int getVarSlot(const Function* function, const char* variable)
 {
     assert(function);
     assert(variable);
-    assert(function->varsData.vars);
 
-    int varIndex = findVariable(&function->varsData, variable);
-    if (varIndex == -1) { return -1; }
+    return findIndexedName(&function->varsIndex, variable);
+}
+
+//------------------------------------------------------------------------------
+//! @return Offset of the variable in the function's frame (relative to rbp).
+//------------------------------------------------------------------------------
+int getSlotOffset(const Function* function, int varSlot)
+{
+    assert(function);
+    assert(0 <= varSlot && (size_t) varSlot < function->varsData.count);
 
-    if (varIndex < (int) function->paramsCount)
+    if (varSlot < (int) function->paramsCount)
     {
-        return 2 * 8 + varIndex * 8;  
+        return 2 * 8 + varSlot * 8;  
     }
     else 
     {
-        return -(varIndex - (int) function->paramsCount + 1) * 8;
+        return -(varSlot - (int) function->paramsCount + 1) * 8;
     }
-
-    return -1;
 }
 //-----------------------------------Function-----------------------------------
 
@@ -137,4 +154,4 @@ void dump(const FunctionsData* functionsData)
 
     printf("}\n");
 }
-//--------------------------------FunctionsData---------------------------------
\ No newline at end of file
+//--------------------------------FunctionsData---------------------------------
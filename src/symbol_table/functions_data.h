@@ -3,6 +3,7 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include "names_index.h"
 
 //-----------------------------------VarsData-----------------------------------
 #define STRUCT   VarsData          
@@ -22,17 +23,24 @@
 
 
 //-----------------------------------Function-----------------------------------
+/* Variables are referred to by their slots, i.e. positions in varsData, which
+ * the parser resolves names to once (see IdData). */
+static const int NO_VAR_SLOT = -1;
+
 struct Function
 {
     const char* name;
     VarsData    varsData;    // local variables (including parameters!)
+    NamesIndex  varsIndex;   // variable -> its slot
     size_t      paramsCount; // parameters count
+    bool        isReachable; // is called (transitively) from main
 };
 
 void destroyFunction (Function* function);
 void pushParameter   (Function* function, const char* parameter);
-void pushVariable    (Function* function, const char* variable);
-int  getVarOffset    (Function* function, const char* variable);
+int  pushVariable    (Function* function, const char* variable);
+int  getVarSlot      (const Function* function, const char* variable);
+int  getSlotOffset   (const Function* function, int varSlot);
 //-----------------------------------Function-----------------------------------
 
 
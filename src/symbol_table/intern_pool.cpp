@@ -0,0 +1,180 @@
+#include <assert.h>
+#include <pthread.h>
+#include <string.h>
+#include "intern_pool.h"
+
+const size_t INTERN_POOL_INITIAL_CAPACITY = 1024;
+const size_t INTERN_POOL_BLOCK_SIZE       = 64 * 1024;
+
+static InternPool internPool = {};
+
+/* Taken by intern() only once the pool is shared (see shareInternPool()), so 
+ * that compiling a single program doesn't pay for it. */
+static pthread_mutex_t internPoolLock     = PTHREAD_MUTEX_INITIALIZER;
+static bool            isInternPoolShared = false;
+
+uint32_t    hashString       (const char* string, size_t length);
+void        rehash           (InternPool* pool, size_t newCapacity);
+const char* storeString      (InternPool* pool, const char* string, size_t length);
+const char* internUnlocked   (InternPool* pool, const char* string, size_t length);
+
+uint32_t hashString(const char* string, size_t length)
+{
+    assert(string);
+
+    /* FNV-1a */
+    uint32_t hash = 2166136261u;
+
+    for (size_t i = 0; i < length; i++)
+    {
+        hash ^= (uint8_t) string[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+void rehash(InternPool* pool, size_t newCapacity)
+{
+    assert(pool);
+
+    InternEntry* newEntries = (InternEntry*) calloc(newCapacity, sizeof(InternEntry));
+    assert(newEntries);
+
+    for (size_t i = 0; i < pool->capacity; i++)
+    {
+        InternEntry entry = pool->entries[i];
+        if (entry.string == nullptr) { continue; }
+
+        size_t slot = entry.hash & (newCapacity - 1);
+        while (newEntries[slot].string != nullptr)
+        {
+            slot = (slot + 1) & (newCapacity - 1);
+        }
+
+        newEntries[slot] = entry;
+    }
+
+    free(pool->entries);
+
+    pool->entries  = newEntries;
+    pool->capacity = newCapacity;
+}
+
+const char* storeString(InternPool* pool, const char* string, size_t length)
+{
+    assert(pool);
+    assert(string);
+
+    if (pool->block == nullptr || pool->blockUsed + length + 1 > pool->blockSize)
+    {
+        size_t blockSize = sizeof(char*) + length + 1;
+        if (blockSize < INTERN_POOL_BLOCK_SIZE) { blockSize = INTERN_POOL_BLOCK_SIZE; }
+
+        char* newBlock = (char*) malloc(blockSize);
+        assert(newBlock);
+
+        memcpy(newBlock, &pool->block, sizeof(char*));
+
+        pool->block     = newBlock;
+        pool->blockUsed = sizeof(char*);
+        pool->blockSize = blockSize;
+    }
+
+    char* stored = pool->block + pool->blockUsed;
+    memcpy(stored, string, length);
+    stored[length] = '\0';
+
+    pool->blockUsed += length + 1;
+
+    return stored;
+}
+
+const char* intern(const char* string, size_t length)
+{
+    assert(string);
+
+    if (!isInternPoolShared) { return internUnlocked(&internPool, string, length); }
+
+    pthread_mutex_lock(&internPoolLock);
+    const char* interned = internUnlocked(&internPool, string, length);
+    pthread_mutex_unlock(&internPoolLock);
+
+    return interned;
+}
+
+//------------------------------------------------------------------------------
+//! intern() for the caller which has the pool to itself.
+//------------------------------------------------------------------------------
+const char* internUnlocked(InternPool* pool, const char* string, size_t length)
+{
+    assert(pool);
+    assert(string);
+
+    if (pool->entries == nullptr)
+    {
+        rehash(pool, INTERN_POOL_INITIAL_CAPACITY);
+    }
+
+    uint32_t hash = hashString(string, length);
+    size_t   slot = hash & (pool->capacity - 1);
+
+    while (pool->entries[slot].string != nullptr)
+    {
+        InternEntry entry = pool->entries[slot];
+
+        if (entry.hash == hash && entry.length == length &&
+            memcmp(entry.string, string, length) == 0)
+        {
+            return entry.string;
+        }
+
+        slot = (slot + 1) & (pool->capacity - 1);
+    }
+
+    const char* stored = storeString(pool, string, length);
+    pool->entries[slot] = {stored, (uint32_t) length, hash};
+    pool->count++;
+
+    if (2 * pool->count > pool->capacity)
+    {
+        rehash(pool, 2 * pool->capacity);
+    }
+
+    return stored;
+}
+
+const char* intern(const char* string)
+{
+    assert(string);
+
+    return intern(string, strlen(string));
+}
+
+void shareInternPool()
+{
+    isInternPoolShared = true;
+}
+
+void destroyInternPool()
+{
+    InternPool* pool = &internPool;
+
+    free(pool->entries);
+
+    while (pool->block != nullptr)
+    {
+        char* previousBlock = nullptr;
+        memcpy(&previousBlock, pool->block, sizeof(char*));
+
+        free(pool->block);
+        pool->block = previousBlock;
+    }
+
+    *pool = {};
+}
+
+int internedCmp(const char* firstName, const char* secondName)
+{
+    return firstName != secondName;
+}
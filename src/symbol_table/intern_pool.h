@@ -0,0 +1,70 @@
+#ifndef INTERN_POOL_H
+#define INTERN_POOL_H
+
+#include <stdlib.h>
+#include <stdint.h>
+
+//------------------------------------------------------------------------------
+//! Identifiers' interning pool. Every distinct identifier is stored only once, 
+//! so names returned by intern() can be compared by pointers. The pool is 
+//! global and is shared by the tokenizer, the parser, the symbol table and the
+//! compiler's labels.
+//------------------------------------------------------------------------------
+
+struct InternEntry
+{
+    const char* string;
+    uint32_t    length;
+    uint32_t    hash;
+};
+
+struct InternPool
+{
+    /* Open-addressing hash table with linear probing, capacity is a power of 2. */
+    InternEntry* entries;
+    size_t       capacity;
+    size_t       count;
+
+    /* Strings are stored one after another in big blocks. The first bytes of 
+     * each block point to the previous block. */
+    char*        block;
+    size_t       blockUsed;
+    size_t       blockSize;
+};
+
+//------------------------------------------------------------------------------
+//! @param string
+//! @param length
+//!
+//! @return Canonical NUL-terminated copy of the first length chars of string.
+//------------------------------------------------------------------------------
+const char* intern            (const char* string, size_t length);
+
+//------------------------------------------------------------------------------
+//! @param string NUL-terminated string.
+//!
+//! @return Canonical copy of string.
+//------------------------------------------------------------------------------
+const char* intern            (const char* string);
+
+//------------------------------------------------------------------------------
+//! Makes intern() safe to call from several threads at once, e.g. compiling
+//! different programs in the same process. Has to be called before the 
+//! threads are started.
+//------------------------------------------------------------------------------
+void        shareInternPool   ();
+
+//------------------------------------------------------------------------------
+//! Frees all the interned strings. All pointers returned by intern() before 
+//! this call become invalid.
+//------------------------------------------------------------------------------
+void        destroyInternPool ();
+
+//------------------------------------------------------------------------------
+//! Comparator for the dynamic arrays of interned names.
+//!
+//! @return 0 if the names are the same atom, 1 otherwise.
+//------------------------------------------------------------------------------
+int         internedCmp       (const char* firstName, const char* secondName);
+
+#endif
@@ -0,0 +1,104 @@
+#include <assert.h>
+#include <stdint.h>
+#include "names_index.h"
+
+static inline size_t hashName(const char* name)
+{
+    /* Names are interned, so their addresses identify them. Fibonacci hashing
+     * spreads the aligned addresses over the table. */
+    return (size_t) (((uint64_t) (uintptr_t) name * 0x9E3779B97F4A7C15ull) >> 32);
+}
+
+static void rehash(NamesIndex* index, size_t newCapacity)
+{
+    assert(index);
+
+    NamesIndexSlot* newSlots = (NamesIndexSlot*) calloc(newCapacity, sizeof(NamesIndexSlot));
+    assert(newSlots);
+
+    for (size_t i = 0; i < index->capacity; i++)
+    {
+        NamesIndexSlot slot = index->slots[i];
+        if (slot.name == nullptr) { continue; }
+
+        size_t newSlot = hashName(slot.name) & (newCapacity - 1);
+        while (newSlots[newSlot].name != nullptr)
+        {
+            newSlot = (newSlot + 1) & (newCapacity - 1);
+        }
+
+        newSlots[newSlot] = slot;
+    }
+
+    free(index->slots);
+
+    index->slots    = newSlots;
+    index->capacity = newCapacity;
+}
+
+void construct(NamesIndex* index)
+{
+    assert(index);
+
+    index->slots    = nullptr;
+    index->capacity = 0;
+    index->count    = 0;
+
+    rehash(index, NAMES_INDEX_INITIAL_CAPACITY);
+}
+
+void destroy(NamesIndex* index)
+{
+    assert(index);
+
+    free(index->slots);
+
+    index->slots    = nullptr;
+    index->capacity = 0;
+    index->count    = 0;
+}
+
+//------------------------------------------------------------------------------
+//! Adds name -> position to the index, name mustn't be indexed already.
+//------------------------------------------------------------------------------
+void indexName(NamesIndex* index, const char* name, int position)
+{
+    assert(index);
+    assert(index->slots);
+    assert(name);
+
+    size_t slot = hashName(name) & (index->capacity - 1);
+    while (index->slots[slot].name != nullptr)
+    {
+        assert(index->slots[slot].name != name);
+        slot = (slot + 1) & (index->capacity - 1);
+    }
+
+    index->slots[slot] = {name, position};
+    index->count++;
+
+    if (2 * index->count > index->capacity)
+    {
+        rehash(index, 2 * index->capacity);
+    }
+}
+
+//------------------------------------------------------------------------------
+//! @return Position the name is indexed with or -1 if there's none.
+//------------------------------------------------------------------------------
+int findIndexedName(const NamesIndex* index, const char* name)
+{
+    assert(index);
+    assert(index->slots);
+    assert(name);
+
+    size_t slot = hashName(name) & (index->capacity - 1);
+    while (index->slots[slot].name != nullptr)
+    {
+        if (index->slots[slot].name == name) { return index->slots[slot].position; }
+
+        slot = (slot + 1) & (index->capacity - 1);
+    }
+
+    return -1;
+}
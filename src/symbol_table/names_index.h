@@ -0,0 +1,30 @@
+#ifndef NAMES_INDEX_H
+#define NAMES_INDEX_H
+
+#include <stdlib.h>
+
+/* Hash index from interned names (i.e. from pointers) to positions in one of 
+ * the dynamic arrays, such as FunctionsData, VarsData or StringsData: open 
+ * addressing with linear probing. Capacity is a power of 2 and the index is 
+ * kept at most half full. */
+static const size_t NAMES_INDEX_INITIAL_CAPACITY = 64;
+
+struct NamesIndexSlot
+{
+    const char* name;        // nullptr in empty slots
+    int         position;
+};
+
+struct NamesIndex
+{
+    NamesIndexSlot* slots;
+    size_t          capacity;
+    size_t          count;
+};
+
+void construct       (NamesIndex* index);
+void destroy         (NamesIndex* index);
+void indexName       (NamesIndex* index, const char* name, int position);
+int  findIndexedName (const NamesIndex* index, const char* name);
+
+#endif
@@ -41,4 +41,121 @@ void dump(const StringsData* stringsData)
     }
 
     printf("}\n");
-}
\ No newline at end of file
+}
+
+//--------------------------------ContentsIndex---------------------------------
+static uint32_t hashContent(const char* content)
+{
+    assert(content);
+
+    /* FNV-1a */
+    uint32_t hash = 2166136261u;
+
+    for (const char* symbol = content; *symbol != '\0'; symbol++)
+    {
+        hash ^= (uint8_t) *symbol;
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+static void rehash(ContentsIndex* index, size_t newCapacity)
+{
+    assert(index);
+
+    ContentsIndexSlot* newSlots = (ContentsIndexSlot*) calloc(newCapacity, sizeof(ContentsIndexSlot));
+    assert(newSlots);
+
+    for (size_t i = 0; i < index->capacity; i++)
+    {
+        ContentsIndexSlot slot = index->slots[i];
+        if (slot.content == nullptr) { continue; }
+
+        size_t newSlot = slot.hash & (newCapacity - 1);
+        while (newSlots[newSlot].content != nullptr)
+        {
+            newSlot = (newSlot + 1) & (newCapacity - 1);
+        }
+
+        newSlots[newSlot] = slot;
+    }
+
+    free(index->slots);
+
+    index->slots    = newSlots;
+    index->capacity = newCapacity;
+}
+
+void construct(ContentsIndex* index)
+{
+    assert(index);
+
+    index->slots    = nullptr;
+    index->capacity = 0;
+    index->count    = 0;
+
+    rehash(index, CONTENTS_INDEX_INITIAL_CAPACITY);
+}
+
+void destroy(ContentsIndex* index)
+{
+    assert(index);
+
+    free(index->slots);
+
+    index->slots    = nullptr;
+    index->capacity = 0;
+    index->count    = 0;
+}
+
+//------------------------------------------------------------------------------
+//! Adds content -> position to the index, content mustn't be indexed already.
+//------------------------------------------------------------------------------
+void indexContent(ContentsIndex* index, const char* content, int position)
+{
+    assert(index);
+    assert(index->slots);
+    assert(content);
+
+    uint32_t hash = hashContent(content);
+    size_t   slot = hash & (index->capacity - 1);
+
+    while (index->slots[slot].content != nullptr)
+    {
+        assert(index->slots[slot].hash != hash || strcmp(index->slots[slot].content, content) != 0);
+        slot = (slot + 1) & (index->capacity - 1);
+    }
+
+    index->slots[slot] = {content, hash, position};
+    index->count++;
+
+    if (2 * index->count > index->capacity)
+    {
+        rehash(index, 2 * index->capacity);
+    }
+}
+
+//------------------------------------------------------------------------------
+//! @return Position the content is indexed with or -1 if there's none.
+//------------------------------------------------------------------------------
+int findIndexedContent(const ContentsIndex* index, const char* content)
+{
+    assert(index);
+    assert(index->slots);
+    assert(content);
+
+    uint32_t hash = hashContent(content);
+    size_t   slot = hash & (index->capacity - 1);
+
+    while (index->slots[slot].content != nullptr)
+    {
+        ContentsIndexSlot* cur = index->slots + slot;
+        if (cur->hash == hash && strcmp(cur->content, content) == 0) { return cur->position; }
+
+        slot = (slot + 1) & (index->capacity - 1);
+    }
+
+    return -1;
+}
+//--------------------------------ContentsIndex---------------------------------
@@ -2,6 +2,7 @@
 #define STRINGS_DATA_H
 
 #include <stdlib.h>
+#include <stdint.h>
 #include <string.h>
 
 const size_t DEFAULT_CAPACITY   = 8;
@@ -11,6 +12,7 @@ struct String
 {
     const char* name;
     const char* content;
+    bool        isReachable; // is used by a function reachable from main
 };
 
 #define STRUCT   StringsData          
@@ -29,4 +31,30 @@ struct String
 
 void dump(const StringsData* stringsData);
 
-#endif
\ No newline at end of file
+//--------------------------------ContentsIndex---------------------------------
+/* Hash index from strings' contents to their positions in StringsData. Unlike
+ * names, contents aren't interned, so slots keep the contents' hashes, and the
+ * contents themselves are compared only when the hashes match. */
+static const size_t CONTENTS_INDEX_INITIAL_CAPACITY = 64;
+
+struct ContentsIndexSlot
+{
+    const char* content; // nullptr in empty slots
+    uint32_t    hash;
+    int         position;
+};
+
+struct ContentsIndex
+{
+    ContentsIndexSlot* slots;
+    size_t             capacity;
+    size_t             count;
+};
+
+void construct          (ContentsIndex* index);
+void destroy            (ContentsIndex* index);
+void indexContent       (ContentsIndex* index, const char* content, int position);
+int  findIndexedContent (const ContentsIndex* index, const char* content);
+//--------------------------------ContentsIndex---------------------------------
+
+#endif
@@ -9,41 +9,39 @@ int functionCmp(Function firstFunction, Function secondFunction)
     assert(firstFunction.name);
     assert(secondFunction.name);
 
-    return strcmp(firstFunction.name, secondFunction.name);
+    return internedCmp(firstFunction.name, secondFunction.name);
 }
 
 int stringCmpByName(String firstString, String secondString)
 {
-    if (firstString.name == secondString.name)                       { return 0; }
-    if (firstString.name == nullptr || secondString.name == nullptr) { return 1; }
-
-    return strcmp(firstString.name, secondString.name);
-}
-
-int stringCmpByContent(String firstString, String secondString)
-{
-    if (firstString.content == secondString.content)                       { return 0; }
-    if (firstString.content == nullptr || secondString.content == nullptr) { return 1; }
-
-    return strcmp(firstString.content, secondString.content);
+    return internedCmp(firstString.name, secondString.name);
 }
 
 void construct(SymbolTable* table)
 {
     assert(table);
 
-    construct(&table->functionsData, functionCmp);
-    construct(&table->stringsData,   stringCmpByName);
+    construct(&table->functionsData,    functionCmp);
+    construct(&table->functionsIndex);
+    construct(&table->stringsData,      stringCmpByName);
+    construct(&table->stringsByName);
+    construct(&table->stringsByContent);
 }
 
 void destroy(SymbolTable* table)
 {
     assert(table);
 
-    destroy(&table->functionsData, destroyFunction);
-    destroy(&table->stringsData,   nullptr);
+    destroy(&table->functionsData,    destroyFunction);
+    destroy(&table->functionsIndex);
+    destroy(&table->stringsData,      nullptr);
+    destroy(&table->stringsByName);
+    destroy(&table->stringsByContent);
 }
 
+//------------------------------------------------------------------------------
+//! The function mustn't be declared yet (see getFunction()).
+//------------------------------------------------------------------------------
 Function* pushFunction(SymbolTable* table, const char* function)
 {
     assert(table);
@@ -51,11 +49,15 @@ Function* pushFunction(SymbolTable* table, const char* function)
 
     Function newFunction = {};
     newFunction.name     = function;
-    construct(&newFunction.varsData, strcmp);
+    construct(&newFunction.varsData, internedCmp);
+    construct(&newFunction.varsIndex);
 
     int functionIdx = insertFunction(&table->functionsData, newFunction);
+    if (functionIdx == -1) { return nullptr; }
 
-    return functionIdx != -1 ? table->functionsData.functions + functionIdx : nullptr;
+    indexName(&table->functionsIndex, function, functionIdx);
+
+    return table->functionsData.functions + functionIdx;
 }
 
 Function* getFunction(SymbolTable* table, const char* function)
@@ -63,50 +65,63 @@ Function* getFunction(SymbolTable* table, const char* function)
     assert(table);
     assert(function);
 
-    int functionIdx = findFunction(&table->functionsData, {.name = function, 
-                                                           .varsData = {}, 
-                                                           .paramsCount = 0});
+    int functionIdx = findIndexedName(&table->functionsIndex, function);
 
     return functionIdx != -1 ? table->functionsData.functions + functionIdx : nullptr;
 }
 
-String* pushString(SymbolTable* table, String string)
+//------------------------------------------------------------------------------
+//! Anonymous strings (without names) are deduplicated: if some string already 
+//! has the same content, its id is returned instead. Named strings mustn't be 
+//! declared yet (see getStringByName()).
+//!
+//! @return Id of the string, which stays the same for the table's lifetime.
+//------------------------------------------------------------------------------
+int pushString(SymbolTable* table, String string)
 {
     assert(table);
-    assert(string.name || string.content);
+    assert(string.content);
 
-    int stringIdx = insertString(&table->stringsData, string);
-    return stringIdx != -1 ? table->stringsData.strings + stringIdx : nullptr;
+    int existingId = getStringByContent(table, string.content);
+    if (string.name == nullptr && existingId != NO_STRING) { return existingId; }
+
+    int stringId = insertString(&table->stringsData, string);
+
+    if (string.name != nullptr) { indexName   (&table->stringsByName,    string.name,    stringId); }
+    if (existingId == NO_STRING) { indexContent(&table->stringsByContent, string.content, stringId); }
+
+    return stringId;
 }
 
-String* getStringByName(SymbolTable* table, const char* name)
+//------------------------------------------------------------------------------
+//! @return Id of the string or NO_STRING if there's none.
+//------------------------------------------------------------------------------
+int getStringByName(const SymbolTable* table, const char* name)
 {
     assert(table);
     assert(name);
 
-    table->stringsData.cmp = stringCmpByName;
-    int stringIdx = findString(&table->stringsData, { name, nullptr });
-
-    return stringIdx != -1 ? table->stringsData.strings + stringIdx : nullptr;
+    return findIndexedName(&table->stringsByName, name);
 }
 
-String* getStringByContent(SymbolTable* table, const char* content)
+//------------------------------------------------------------------------------
+//! @return Id of the first string with the content or NO_STRING if there's 
+//!         none.
+//------------------------------------------------------------------------------
+int getStringByContent(const SymbolTable* table, const char* content)
 {
     assert(table);
     assert(content);
 
-    table->stringsData.cmp = stringCmpByContent;
-    int stringIdx = findString(&table->stringsData, { nullptr, content });
-
-    return stringIdx != -1 ? table->stringsData.strings + stringIdx : nullptr;
+    return findIndexedContent(&table->stringsByContent, content);
 }
 
-int getStringNumber(SymbolTable* table, String* string)
+const String* getString(const SymbolTable* table, int stringId)
 {
     assert(table);
-    assert(string);
+    assert(0 <= stringId && (size_t) stringId < table->stringsData.count);
 
-    return string - table->stringsData.strings;
+    return table->stringsData.strings + stringId;
 }
 
 void dump(const SymbolTable* table)
@@ -118,4 +133,54 @@ void dump(const SymbolTable* table)
 
     printf("\n");
     dump(&table->stringsData);
+
+    printf("\n");
+    dumpEliminated(table);
+}
+
+//------------------------------------------------------------------------------
+//! Prints the functions and strings, which aren't reachable from main (see 
+//! markReachableSymbols()) and thus aren't compiled.
+//------------------------------------------------------------------------------
+void dumpEliminated(const SymbolTable* table)
+{
+    assert(table);
+
+    const FunctionsData* functionsData = &table->functionsData;
+    const StringsData*   stringsData   = &table->stringsData;
+
+    size_t eliminatedCount = 0;
+    for (size_t i = 0; i < functionsData->count; i++) { eliminatedCount += !functionsData->functions[i].isReachable; }
+    for (size_t i = 0; i < stringsData->count;   i++) { eliminatedCount += !stringsData->strings[i].isReachable;     }
+
+    printf("eliminatedCount = %zu\n"
+           "eliminated = {", 
+           eliminatedCount);
+
+    if (eliminatedCount == 0)
+    {
+        printf(" nullptr }\n");
+        return;
+    }
+
+    printf("\n");
+
+    for (size_t i = 0; i < functionsData->count; i++)
+    {
+        const Function* function = &functionsData->functions[i];
+        if (!function->isReachable) { printf("    { function name='%s' },\n", function->name); }
+    }
+
+    for (size_t i = 0; i < stringsData->count; i++)
+    {
+        const String* string = &stringsData->strings[i];
+        if (!string->isReachable) 
+        { 
+            printf("    { string name='%s', content='%s' },\n", 
+                   string->name, 
+                   string->content[0] == '\n' ? "\\n" : string->content); 
+        }
+    }
+
+    printf("}\n");
 }
\ No newline at end of file
@@ -4,23 +4,33 @@
 #include <stdlib.h>
 #include "functions_data.h"
 #include "strings_data.h"
+#include "intern_pool.h"
 
+/* Functions' and strings' names have to be interned (see intern_pool.h). */
 struct SymbolTable
 {
     FunctionsData functionsData; 
+    NamesIndex    functionsIndex;
+
+    /* Strings' ids are their positions in stringsData. */
     StringsData   stringsData;
+    NamesIndex    stringsByName;
+    ContentsIndex stringsByContent;
 };
 
-void      construct          (SymbolTable* table);
-void      destroy            (SymbolTable* table);
-void      dump               (const SymbolTable* table);
+static const int NO_STRING = -1;
+
+void          construct          (SymbolTable* table);
+void          destroy            (SymbolTable* table);
+void          dump               (const SymbolTable* table);
+void          dumpEliminated     (const SymbolTable* table);
 
-Function* pushFunction       (SymbolTable* table, const char* function);
-Function* getFunction        (SymbolTable* table, const char* function);
+Function*     pushFunction       (SymbolTable* table, const char* function);
+Function*     getFunction        (SymbolTable* table, const char* function);
 
-String*   pushString         (SymbolTable* table, String string);
-String*   getStringByName    (SymbolTable* table, const char* name);
-String*   getStringByContent (SymbolTable* table, const char* content);
-int       getStringNumber    (SymbolTable* table, String* string);
+int           pushString         (SymbolTable* table, String string);
+int           getStringByName    (const SymbolTable* table, const char* name);
+int           getStringByContent (const SymbolTable* table, const char* content);
+const String* getString          (const SymbolTable* table, int stringId);
 
 #endif
\ No newline at end of file